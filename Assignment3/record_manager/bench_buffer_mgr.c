@@ -0,0 +1,717 @@
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "dberror.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+/*----------------------macros----------------------*/
+#define BENCH_FILE "benchbuffer.bin"
+#define BENCH_HITS 2000000     // pin/unpin pairs timed per pool size
+#define BENCH_MAX_FRAMES 1000000 // 1M frames need ~4GB for the frames and ~4GB for the page file
+#define MISS_FRAMES 1000       // pool size for the miss latency benchmark
+#define MISS_FILE_PAGES 20000  // pages the misses draw from, the pool holds 5% of them
+#define MISS_ACCESSES 200000   // random clean accesses, about 95% misses
+#define APPEND_FRAMES 100      // pool size for the append benchmark
+#define APPEND_PAGES 20000     // pages created at the end of an empty file
+#define MIX_FRAMES 1000        // pool size for the replacement strategy comparison
+#define MIX_FILE_PAGES 10000   // pages in the file the mixed workload draws from
+#define MIX_ACCESSES 200000    // accesses in the mixed workload
+#define MIX_SCAN_EVERY 20000   // a sequential scan starts every MIX_SCAN_EVERY accesses
+#define MIX_SCAN_LENGTH 3000   // pages read by one scan, longer than the pool
+#define MIX_RING_FRAMES 32     // ring of a scan that uses an access strategy
+#define MT_FRAMES 10000        // pool size for the multithreaded benchmark, every access is a hit
+#define MT_OPS_PER_THREAD 1000000 // pin/unpin pairs per thread
+#define MT_MAX_THREADS 8
+#define MT_PARTITIONS 8        // sub-pools of the partitioned rows
+#define WB_FRAMES 1000         // pool size for the background writer benchmark
+#define WB_FILE_PAGES 5000     // pages the write-heavy workload draws from
+#define WB_ACCESSES 50000      // pin + markDirty + unpin triples, most of them misses
+#define WB_THINK_US 20         // pause between accesses, gives the writer idle time like a real client
+#define UPD_FRAMES 1000        // pool size for the dirty-aware replacement comparison
+#define UPD_FILE_PAGES 10000   // pages the update-heavy workload draws from
+#define UPD_ACCESSES 200000    // accesses, reads of any page and updates of the first 5% of the pages
+#define UPD_WRITE_PERCENT 30   // accesses that are updates
+#define SCAN_FRAMES 1000       // pool size for the cold scan benchmark
+#define SCAN_PAGES 20000       // pages scanned in file order, 80MB
+#define SCAN_WORK_ROUNDS 4     // passes over each page to simulate processing the records on it
+#define WARM_FRAMES 2000       // pool size for the warm restart benchmark
+#define WARM_FILE_PAGES 20000  // pages in the file, 80MB
+#define WARM_HOT_RUNS 4        // the hot set is this many runs of consecutive pages spread over the file
+#define WARM_HOT_RUN_PAGES 400 // pages per hot run, the hot set fits in the pool
+#define WARM_HOT_PERCENT 98    // accesses that go to the hot set
+#define WARM_ACCESSES 50000    // accesses before the restart, and timed accesses after it
+#define VICTIM_MIN_FRAMES 4096 // smallest pool of the victim scan benchmark, sizes grow 4x up to maxFrames
+#define VICTIM_MAX_FRAMES 65536 // largest pool of the victim scan benchmark
+#define VICTIM_MISSES 20000    // timed misses per pool size, every one of them picks a victim
+
+/*----------------------strategies compared----------------------*/
+static const ReplacementStrategy mixStrategies[] = { RS_FIFO, RS_LRU, RS_CLOCK, RS_LFU, RS_LRU_K, RS_ARC, RS_2Q, RS_GCLOCK };
+static const char *mixNames[] = { "FIFO", "LRU", "CLOCK", "LFU", "LRU-K", "ARC", "2Q", "GCLOCK" };
+
+/*----------------------local auxiliary functions----------------------*/
+/**
+* @brief monotonic clock in nanoseconds
+* @return double, current time in nanoseconds
+*/
+static double nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+* @brief fill a pool with numFrames pages, then time random hits on resident pages
+* @param numFrames, input value, number of frames in the buffer pool
+* @return double, average nanoseconds for one pinPage + unpinPage pair
+*/
+static double benchHits(int numFrames)
+{
+    BM_BufferPool bm;
+    BM_PageHandle h;
+    SM_FileHandle fh;
+
+    CHECK(createPageFile(BENCH_FILE));
+    CHECK(openPageFile(BENCH_FILE, &fh));
+    CHECK(ensureCapacity(numFrames, &fh));
+    CHECK(closePageFile(&fh));
+
+    CHECK(initBufferPool(&bm, BENCH_FILE, numFrames, RS_FIFO, NULL));
+    for (int i = 0; i < numFrames; i++) {
+        CHECK(pinPage(&bm, &h, i));
+        CHECK(unpinPage(&bm, &h));
+    }
+
+    // pre-compute the access sequence so rand() is not measured
+    int *pages = (int *)malloc(BENCH_HITS * sizeof(int));
+    srand(525);
+    for (int i = 0; i < BENCH_HITS; i++) {
+        pages[i] = (int)(((unsigned long)rand() * RAND_MAX + rand()) % numFrames);
+    }
+
+    double start = nowNs();
+    for (int i = 0; i < BENCH_HITS; i++) {
+        pinPage(&bm, &h, pages[i]);
+        unpinPage(&bm, &h);
+    }
+    double elapsed = nowNs() - start;
+
+    if (getNumReadIO(&bm) != numFrames) {
+        printf("unexpected misses: %d reads for %d frames\n", getNumReadIO(&bm), numFrames);
+    }
+
+    free(pages);
+    CHECK(shutdownBufferPool(&bm));
+    CHECK(destroyPageFile(BENCH_FILE));
+    return elapsed / BENCH_HITS;
+}
+
+/**
+* @brief time random accesses over a file 20 times larger than the pool, nearly all of them misses
+*        on clean pages, so the cost is the page read plus the frame turnover
+* @return double, average nanoseconds for one miss (pinPage + unpinPage)
+*/
+static double benchMisses(void)
+{
+    BM_BufferPool bm;
+    BM_PageHandle h;
+    SM_FileHandle fh;
+
+    CHECK(createPageFile(BENCH_FILE));
+    CHECK(openPageFile(BENCH_FILE, &fh));
+    CHECK(ensureCapacity(MISS_FILE_PAGES, &fh));
+    CHECK(closePageFile(&fh));
+
+    int *pages = (int *)malloc(MISS_ACCESSES * sizeof(int));
+    srand(525);
+    for (int i = 0; i < MISS_ACCESSES; i++) {
+        pages[i] = rand() % MISS_FILE_PAGES;
+    }
+
+    CHECK(initBufferPool(&bm, BENCH_FILE, MISS_FRAMES, RS_LRU, NULL));
+    double start = nowNs();
+    for (int i = 0; i < MISS_ACCESSES; i++) {
+        CHECK(pinPage(&bm, &h, pages[i]));
+        CHECK(unpinPage(&bm, &h));
+    }
+    double elapsed = nowNs() - start;
+    int misses = getNumReadIO(&bm);
+
+    free(pages);
+    CHECK(shutdownBufferPool(&bm));
+    CHECK(destroyPageFile(BENCH_FILE));
+    return elapsed / misses;
+}
+
+/**
+* @brief create APPEND_PAGES pages at the end of a new file, like a bulk insert
+* @param useNewPage, input value, true to create pages with pinNewPage, false with pinPage
+* @param reads, output value, pages read by the pool
+* @return double, average nanoseconds per created page, including the final flush
+*/
+static double benchAppend(bool useNewPage, int *reads)
+{
+    BM_BufferPool bm;
+    BM_PageHandle h;
+
+    CHECK(createPageFile(BENCH_FILE));
+    CHECK(initBufferPool(&bm, BENCH_FILE, APPEND_FRAMES, RS_LRU, NULL));
+    double start = nowNs();
+    for (int i = 1; i <= APPEND_PAGES; i++) {
+        if (useNewPage) {
+            CHECK(pinNewPage(&bm, &h, i));
+        } else {
+            CHECK(pinPage(&bm, &h, i));
+        }
+        memset(h.data, i & 0xff, 64);
+        CHECK(markDirty(&bm, &h));
+        CHECK(useNewPage ? unpinPageLatched(&bm, &h) : unpinPage(&bm, &h));
+    }
+    CHECK(forceFlushPool(&bm));
+    double elapsed = nowNs() - start;
+    *reads = getNumReadIO(&bm);
+    CHECK(shutdownBufferPool(&bm));
+    CHECK(destroyPageFile(BENCH_FILE));
+    return elapsed / APPEND_PAGES;
+}
+
+/**
+* @brief build the mixed workload: random hits on a hot set of half the pool, 
+*        interrupted by sequential scans over cold pages
+* @param pages, output value, MIX_ACCESSES page numbers
+*/
+static void buildMixedWorkload(int *pages)
+{
+    int hotPages = MIX_FRAMES / 2;
+    int scanPos = hotPages;
+
+    srand(525);
+    for (int i = 0; i < MIX_ACCESSES; ) {
+        if (i > 0 && i % MIX_SCAN_EVERY == 0) {
+            for (int j = 0; j < MIX_SCAN_LENGTH && i < MIX_ACCESSES; j++, i++) {
+                pages[i] = scanPos;
+                scanPos = (scanPos + 1 < MIX_FILE_PAGES) ? scanPos + 1 : hotPages;
+            }
+            continue;
+        }
+        pages[i++] = rand() % hotPages;
+    }
+}
+
+/**
+* @brief run the mixed workload against one replacement strategy
+* @param strategy, input value, replacement strategy
+* @param pages, input value, MIX_ACCESSES page numbers
+* @param ring, input value, access strategy the scans pin through, NULL to pin them like the hot pages
+* @param hitRatio, output value, fraction of accesses served without a read
+* @return double, average nanoseconds for one pinPage + unpinPage pair
+*/
+static double benchStrategy(ReplacementStrategy strategy, const int *pages, BM_AccessStrategy *ring, double *hitRatio)
+{
+    BM_BufferPool bm;
+    BM_PageHandle h;
+
+    CHECK(initBufferPool(&bm, BENCH_FILE, MIX_FRAMES, strategy, NULL));
+    double start = nowNs();
+    for (int i = 0; i < MIX_ACCESSES; i++) {
+        // pages past the hot set are only read by the scans
+        CHECK(pinPageWithStrategy(&bm, &h, pages[i], (pages[i] >= MIX_FRAMES / 2) ? ring : NULL));
+        CHECK(unpinPage(&bm, &h));
+    }
+    double elapsed = nowNs() - start;
+
+    *hitRatio = 1.0 - (double)getNumReadIO(&bm) / MIX_ACCESSES;
+    CHECK(shutdownBufferPool(&bm));
+    return elapsed / MIX_ACCESSES;
+}
+
+/**
+* @brief compare the replacement strategies on the mixed workload
+*/
+static void benchStrategies(void)
+{
+    SM_FileHandle fh;
+    int *pages = (int *)malloc(MIX_ACCESSES * sizeof(int));
+
+    CHECK(createPageFile(BENCH_FILE));
+    CHECK(openPageFile(BENCH_FILE, &fh));
+    CHECK(ensureCapacity(MIX_FILE_PAGES, &fh));
+    CHECK(closePageFile(&fh));
+    buildMixedWorkload(pages);
+
+    printf("\n%d frames, hot set of %d pages, %d-page scans every %d accesses\n", 
+           MIX_FRAMES, MIX_FRAMES / 2, MIX_SCAN_LENGTH, MIX_SCAN_EVERY);
+    printf("%10s %10s %16s %16s %16s\n", "strategy", "hit ratio", "ns/access", "ring hit ratio", "ring ns/access");
+    for (int i = 0; i < (int)(sizeof(mixStrategies) / sizeof(mixStrategies[0])); i++) {
+        BM_AccessStrategy *ring;
+        double hitRatio, ringHitRatio;
+        double ns = benchStrategy(mixStrategies[i], pages, NULL, &hitRatio);
+        // the same workload with the scans pinned through a private ring of frames
+        CHECK(createAccessStrategy(&ring, MIX_RING_FRAMES));
+        double ringNs = benchStrategy(mixStrategies[i], pages, ring, &ringHitRatio);
+        CHECK(freeAccessStrategy(ring));
+        printf("%10s %10.4f %16.1f %16.4f %16.1f\n", mixNames[i], hitRatio, ns, ringHitRatio, ringNs);
+        fflush(stdout);
+    }
+
+    free(pages);
+    CHECK(destroyPageFile(BENCH_FILE));
+}
+
+// per-thread state of the multithreaded benchmark
+typedef struct MTWorker {
+    BM_BufferPool *bm;
+    unsigned int seed;
+} MTWorker;
+
+/**
+* @brief pin and unpin random resident pages
+* @param arg, input value, an MTWorker pointer
+*/
+static void *mtWorker(void *arg)
+{
+    MTWorker *w = (MTWorker *)arg;
+    BM_PageHandle h;
+
+    for (int i = 0; i < MT_OPS_PER_THREAD; i++) {
+        pinPage(w->bm, &h, rand_r(&w->seed) % MT_FRAMES);
+        unpinPage(w->bm, &h);
+    }
+    return NULL;
+}
+
+/**
+* @brief aggregate pin/unpin throughput of a concurrent pool
+* @param strategy, input value, replacement strategy
+* @param numPartitions, input value, sub-pools of the pool, 0 = one pool
+* @param numThreads, input value, number of worker threads
+* @return double, million pin + unpin pairs per second over all threads
+*/
+static double benchThreads(ReplacementStrategy strategy, int numPartitions, int numThreads)
+{
+    BM_BufferPool bm;
+    BM_PageHandle h;
+    BM_PoolOptions options = { true, 0, 0, 0, 0, 0, numPartitions };
+    MTWorker workers[MT_MAX_THREADS];
+    pthread_t threads[MT_MAX_THREADS];
+
+    CHECK(initBufferPoolEx(&bm, BENCH_FILE, MT_FRAMES, strategy, NULL, &options));
+    for (int i = 0; i < MT_FRAMES; i++) {
+        CHECK(pinPage(&bm, &h, i));
+        CHECK(unpinPage(&bm, &h));
+    }
+
+    double start = nowNs();
+    for (int i = 0; i < numThreads; i++) {
+        workers[i].bm = &bm;
+        workers[i].seed = 525 + i;
+        pthread_create(&threads[i], NULL, mtWorker, &workers[i]);
+    }
+    for (int i = 0; i < numThreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = nowNs() - start;
+
+    CHECK(shutdownBufferPool(&bm));
+    return (double)numThreads * MT_OPS_PER_THREAD / elapsed * 1e3;
+}
+
+/**
+* @brief throughput of the concurrent pool for 1..MT_MAX_THREADS threads.
+*        CLOCK hits only take a page table stripe latch, LRU hits take the pool latch,
+*        one per partition in a partitioned pool.
+*/
+static void benchConcurrency(void)
+{
+    SM_FileHandle fh;
+    const ReplacementStrategy strategies[] = { RS_CLOCK, RS_LRU, RS_CLOCK, RS_LRU };
+    const int partitions[] = { 0, 0, MT_PARTITIONS, MT_PARTITIONS };
+    const char *names[] = { "CLOCK", "LRU", "CLOCK", "LRU" };
+
+    CHECK(createPageFile(BENCH_FILE));
+    CHECK(openPageFile(BENCH_FILE, &fh));
+    CHECK(ensureCapacity(MT_FRAMES, &fh));
+    CHECK(closePageFile(&fh));
+
+    printf("\nconcurrent pool, %d frames, all hits, %ld online cores\n", MT_FRAMES, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%10s %10s %10s %16s\n", "strategy", "partitions", "threads", "Mpins/s");
+    for (int s = 0; s < 4; s++) {
+        for (int numThreads = 1; numThreads <= MT_MAX_THREADS; numThreads *= 2) {
+            printf("%10s %10d %10d %16.2f\n", names[s], (partitions[s] > 0) ? partitions[s] : 1, numThreads, 
+                   benchThreads(strategies[s], partitions[s], numThreads));
+            fflush(stdout);
+        }
+    }
+
+    CHECK(destroyPageFile(BENCH_FILE));
+}
+
+static int compareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+* @brief write-heavy random workload, every access dirties its page
+* @param cleanerIntervalMs, input value, background writer period, 0 = no writer
+* @param lat, output value, WB_ACCESSES per-access latencies in ns, sorted
+* @param writes, output value, pages written by the pool
+*/
+static void benchWriteback(int cleanerIntervalMs, double *lat, int *writes)
+{
+    BM_BufferPool bm;
+    BM_PageHandle h;
+    BM_PoolOptions options = { false, 0, cleanerIntervalMs, 0 };
+    struct timespec think = { 0, WB_THINK_US * 1000 };
+
+    CHECK(initBufferPoolEx(&bm, BENCH_FILE, WB_FRAMES, RS_CLOCK, NULL, &options));
+    srand(525);
+    for (int i = 0; i < WB_ACCESSES; i++) {
+        int pageNum = rand() % WB_FILE_PAGES;
+        double start = nowNs();
+        CHECK(pinPage(&bm, &h, pageNum));
+        h.data[0]++;
+        CHECK(markDirty(&bm, &h));
+        CHECK(unpinPage(&bm, &h));
+        lat[i] = nowNs() - start;
+        nanosleep(&think, NULL);
+    }
+    *writes = getNumWriteIO(&bm);
+    CHECK(shutdownBufferPool(&bm));
+    qsort(lat, WB_ACCESSES, sizeof(double), compareDoubles);
+}
+
+/**
+* @brief access latency of a write-heavy workload with and without the background writer.
+*        Without it every dirty victim is written on the miss path.
+*/
+static void benchBackgroundWriter(void)
+{
+    SM_FileHandle fh;
+    double *lat = (double *)malloc(WB_ACCESSES * sizeof(double));
+    const int intervals[] = { 0, 10, 1 };
+
+    CHECK(createPageFile(BENCH_FILE));
+    CHECK(openPageFile(BENCH_FILE, &fh));
+    CHECK(ensureCapacity(WB_FILE_PAGES, &fh));
+    CHECK(closePageFile(&fh));
+
+    printf("\n%d frames, %d-page file, every access dirties its page\n", WB_FRAMES, WB_FILE_PAGES);
+    printf("%10s %10s %10s %10s %10s %10s\n", "writer ms", "p50 ns", "p99 ns", "p99.9 ns", "max ns", "writes");
+    for (int i = 0; i < (int)(sizeof(intervals) / sizeof(intervals[0])); i++) {
+        int writes;
+        benchWriteback(intervals[i], lat, &writes);
+        printf("%10d %10.0f %10.0f %10.0f %10.0f %10d\n", intervals[i], lat[WB_ACCESSES / 2], 
+               lat[WB_ACCESSES * 99 / 100], lat[WB_ACCESSES * 999 / 1000], lat[WB_ACCESSES - 1], writes);
+        fflush(stdout);
+    }
+
+    free(lat);
+    CHECK(destroyPageFile(BENCH_FILE));
+}
+
+/**
+* @brief read/update workload: reads are spread over the whole file, updates hit a hot set
+* @param strategy, input value, replacement strategy
+* @param stats, output value, the pool's statistics at the end, before the final flush
+* @return double, average nanoseconds per access
+*/
+static double benchUpdates(ReplacementStrategy strategy, BM_PoolStats *stats)
+{
+    BM_BufferPool bm;
+    BM_PageHandle h;
+
+    CHECK(initBufferPool(&bm, BENCH_FILE, UPD_FRAMES, strategy, NULL));
+    srand(525);
+    double start = nowNs();
+    for (int i = 0; i < UPD_ACCESSES; i++) {
+        int update = (rand() % 100) < UPD_WRITE_PERCENT;
+        int pageNum = update ? rand() % (UPD_FILE_PAGES / 20) : rand() % UPD_FILE_PAGES;
+        CHECK(pinPage(&bm, &h, pageNum));
+        if (update) {
+            h.data[0]++;
+            CHECK(markDirty(&bm, &h));
+        }
+        CHECK(unpinPage(&bm, &h));
+    }
+    double elapsed = nowNs() - start;
+    CHECK(getPoolStats(&bm, stats));
+    CHECK(shutdownBufferPool(&bm));
+    return elapsed / UPD_ACCESSES;
+}
+
+/**
+* @brief dirty victims written on the miss path by CLOCK and by GCLOCK, which passes over dirty pages once
+*/
+static void benchDirtyAware(void)
+{
+    SM_FileHandle fh;
+    const ReplacementStrategy strategies[] = { RS_CLOCK, RS_GCLOCK };
+    const char *names[] = { "CLOCK", "GCLOCK" };
+
+    CHECK(createPageFile(BENCH_FILE));
+    CHECK(openPageFile(BENCH_FILE, &fh));
+    CHECK(ensureCapacity(UPD_FILE_PAGES, &fh));
+    CHECK(closePageFile(&fh));
+
+    printf("\n%d frames, %d-page file, %d%% updates of %d hot pages\n", UPD_FRAMES, UPD_FILE_PAGES, 
+           UPD_WRITE_PERCENT, UPD_FILE_PAGES / 20);
+    printf("%10s %10s %16s %16s %10s\n", "strategy", "hit ratio", "dirty evictions", "clean evictions", "ns/access");
+    for (int s = 0; s < 2; s++) {
+        BM_PoolStats stats;
+        double ns = benchUpdates(strategies[s], &stats);
+        printf("%10s %10.4f %16llu %16llu %10.1f\n", names[s], (double)stats.hits / (stats.hits + stats.misses), 
+               stats.dirtyEvictions, stats.cleanEvictions, ns);
+        fflush(stdout);
+    }
+
+    CHECK(destroyPageFile(BENCH_FILE));
+}
+
+/**
+* @brief drop the page file from the OS page cache so that the next scan reads from the device
+*/
+static void dropFileCache(void)
+{
+    int fd = open(BENCH_FILE, O_RDONLY);
+    if (fd < 0) return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+/**
+* @brief scan a cold file page by page, summing every page SCAN_WORK_ROUNDS times
+* @param readAheadPages, input value, read-ahead window, 0 = every miss is a blocking read
+* @return double, milliseconds for the whole scan
+*/
+static double benchColdScan(int readAheadPages)
+{
+    BM_BufferPool bm;
+    BM_PageHandle h;
+    BM_PoolOptions options = { false, 0, 0, 0, readAheadPages };
+    volatile unsigned long sum = 0;
+
+    dropFileCache();
+    CHECK(initBufferPoolEx(&bm, BENCH_FILE, SCAN_FRAMES, RS_2Q, NULL, &options));
+    double start = nowNs();
+    for (int i = 0; i < SCAN_PAGES; i++) {
+        CHECK(pinPage(&bm, &h, i));
+        for (int r = 0; r < SCAN_WORK_ROUNDS; r++) {
+            for (int j = 0; j < PAGE_SIZE; j += sizeof(long)) sum += *(long *)(h.data + j);
+        }
+        CHECK(unpinPage(&bm, &h));
+    }
+    double elapsed = nowNs() - start;
+    CHECK(shutdownBufferPool(&bm));
+    return elapsed / 1e6;
+}
+
+/**
+* @brief sequential scan of a file that is not in the OS cache, with and without read-ahead
+*/
+static void benchReadAhead(void)
+{
+    SM_FileHandle fh;
+    const int windows[] = { 0, 8, 32 };
+
+    CHECK(createPageFile(BENCH_FILE));
+    CHECK(openPageFile(BENCH_FILE, &fh));
+    CHECK(ensureCapacity(SCAN_PAGES, &fh));
+    CHECK(closePageFile(&fh));
+
+    printf("\ncold sequential scan of %d pages, %d frames\n", SCAN_PAGES, SCAN_FRAMES);
+    printf("%10s %10s %10s\n", "read-ahead", "ms", "MB/s");
+    for (int i = 0; i < (int)(sizeof(windows) / sizeof(windows[0])); i++) {
+        double ms = benchColdScan(windows[i]);
+        printf("%10d %10.1f %10.1f\n", windows[i], ms, (double)SCAN_PAGES * PAGE_SIZE / 1e3 / ms);
+        fflush(stdout);
+    }
+
+    CHECK(destroyPageFile(BENCH_FILE));
+}
+
+/**
+* @brief skewed access: most go to a few runs of consecutive pages, the rest anywhere in the file
+* @return int, page number
+*/
+static int warmPage(void)
+{
+    if ((rand() % 100) >= WARM_HOT_PERCENT) return rand() % WARM_FILE_PAGES;
+    int run = rand() % WARM_HOT_RUNS;
+    return run * (WARM_FILE_PAGES / WARM_HOT_RUNS) + rand() % WARM_HOT_RUN_PAGES;
+}
+
+/**
+* @brief open a pool on a file that is not in the OS cache and run the skewed workload
+* @param warmRestart, input value, preload the hot page set saved by the last shutdown
+* @param initMs, output value, milliseconds initBufferPoolEx took, the preload included
+* @param misses, output value, misses of the timed accesses
+* @return double, milliseconds from the start of initBufferPoolEx to the last access
+*/
+static double benchRestart(bool warmRestart, double *initMs, unsigned long long *misses)
+{
+    BM_BufferPool bm;
+    BM_PageHandle h;
+    BM_PoolStats stats;
+    BM_PoolOptions options = { false, 0, 0, 0, 0, 0, 0, warmRestart };
+
+    dropFileCache();
+    srand(607);
+    double start = nowNs();
+    CHECK(initBufferPoolEx(&bm, BENCH_FILE, WARM_FRAMES, RS_LRU, NULL, &options));
+    *initMs = (nowNs() - start) / 1e6;
+    for (int i = 0; i < WARM_ACCESSES; i++) {
+        CHECK(pinPage(&bm, &h, warmPage()));
+        CHECK(unpinPage(&bm, &h));
+    }
+    double elapsed = nowNs() - start;
+    CHECK(getPoolStats(&bm, &stats));
+    *misses = stats.misses;
+    CHECK(shutdownBufferPool(&bm));
+    return elapsed / 1e6;
+}
+
+/**
+* @brief restart a pool after a run of the skewed workload, cold and with the saved hot page set
+*/
+static void benchWarmRestart(void)
+{
+    BM_BufferPool bm;
+    BM_PageHandle h;
+    SM_FileHandle fh;
+    BM_PoolOptions options = { false, 0, 0, 0, 0, 0, 0, true };
+    char warmFile[64];
+
+    CHECK(createPageFile(BENCH_FILE));
+    CHECK(openPageFile(BENCH_FILE, &fh));
+    CHECK(ensureCapacity(WARM_FILE_PAGES, &fh));
+    CHECK(closePageFile(&fh));
+
+    // the run before the restart, its shutdown saves the hot page set
+    srand(525);
+    CHECK(initBufferPoolEx(&bm, BENCH_FILE, WARM_FRAMES, RS_LRU, NULL, &options));
+    for (int i = 0; i < WARM_ACCESSES; i++) {
+        CHECK(pinPage(&bm, &h, warmPage()));
+        CHECK(unpinPage(&bm, &h));
+    }
+    CHECK(shutdownBufferPool(&bm));
+
+    printf("\nrestart of %d frames on a cold %d-page file, %d%% of %d accesses to %d runs of %d pages\n", 
+           WARM_FRAMES, WARM_FILE_PAGES, WARM_HOT_PERCENT, WARM_ACCESSES, WARM_HOT_RUNS, WARM_HOT_RUN_PAGES);
+    printf("%10s %10s %10s %10s\n", "start", "init ms", "misses", "total ms");
+    for (int warm = 0; warm < 2; warm++) {
+        double initMs;
+        unsigned long long misses;
+        double ms = benchRestart(warm == 1, &initMs, &misses);
+        printf("%10s %10.1f %10llu %10.1f\n", warm ? "warm" : "cold", initMs, misses, ms);
+        fflush(stdout);
+    }
+
+    sprintf(warmFile, "%s%s", BENCH_FILE, WARM_FILE_SUFFIX);
+    remove(warmFile);
+    CHECK(destroyPageFile(BENCH_FILE));
+}
+
+/**
+* @brief fill a pool, then time misses that cycle through pages that are never resident, so every pin
+*        picks a victim. FIFO takes the head of its load order list, CLOCK and GCLOCK sweep.
+* @param strategy, input value, replacement strategy
+* @param numFrames, input value, number of frames in the buffer pool
+* @return double, average nanoseconds for one miss (pinPage + unpinPage)
+*/
+static double benchVictims(ReplacementStrategy strategy, int numFrames)
+{
+    BM_BufferPool bm;
+    BM_PageHandle h;
+
+    CHECK(initBufferPool(&bm, BENCH_FILE, numFrames, strategy, NULL));
+    for (int i = 0; i < numFrames; i++) {
+        CHECK(pinPage(&bm, &h, i));
+        CHECK(unpinPage(&bm, &h));
+    }
+    double start = nowNs();
+    for (int i = 0; i < VICTIM_MISSES; i++) {
+        // 2 * numFrames pages in turn: each one was evicted before it comes back
+        CHECK(pinPage(&bm, &h, (numFrames + i) % (2 * numFrames)));
+        CHECK(unpinPage(&bm, &h));
+    }
+    double elapsed = nowNs() - start;
+    CHECK(shutdownBufferPool(&bm));
+    return elapsed / VICTIM_MISSES;
+}
+
+/**
+* @brief victim selection cost at large pool sizes. A CLOCK/GCLOCK sweep clears the bits it passes, so it
+*        only takes a few steps per miss and the time stays about flat with the pool size; the read dominates.
+* @param maxFrames, input value, largest pool size
+*/
+static void benchVictimScan(int maxFrames)
+{
+    SM_FileHandle fh;
+    const ReplacementStrategy strategies[] = { RS_FIFO, RS_CLOCK, RS_GCLOCK };
+    const char *names[] = { "FIFO", "CLOCK", "GCLOCK" };
+    if (maxFrames > VICTIM_MAX_FRAMES) maxFrames = VICTIM_MAX_FRAMES;
+    if (maxFrames < VICTIM_MIN_FRAMES) return;
+
+    CHECK(createPageFile(BENCH_FILE));
+    CHECK(openPageFile(BENCH_FILE, &fh));
+    CHECK(ensureCapacity(2 * maxFrames, &fh));
+    CHECK(closePageFile(&fh));
+
+    printf("\n%d misses per pool size, every one picks a victim\n", VICTIM_MISSES);
+    printf("%10s", "frames");
+    for (int s = 0; s < 3; s++) printf(" %10s", names[s]);
+    printf("  (ns/miss)\n");
+    for (int numFrames = VICTIM_MIN_FRAMES; numFrames <= maxFrames; numFrames *= 4) {
+        printf("%10d", numFrames);
+        for (int s = 0; s < 3; s++) {
+            printf(" %10.1f", benchVictims(strategies[s], numFrames));
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+
+    CHECK(destroyPageFile(BENCH_FILE));
+}
+
+/*----------------------main----------------------*/
+/**
+* @brief buffer pool hit latency benchmark and replacement strategy comparison
+*        usage: bench_buffer_mgr [maxFrames]
+*/
+int main(int argc, char **argv)
+{
+    int maxFrames = (argc > 1) ? atoi(argv[1]) : BENCH_MAX_FRAMES;
+
+    initStorageManager();
+    printf("%10s %16s\n", "frames", "ns/hit(pin+unpin)");
+    for (int numFrames = 10; numFrames <= maxFrames; numFrames *= 10) {
+        printf("%10d %16.1f\n", numFrames, benchHits(numFrames));
+        fflush(stdout);
+    }
+    printf("\n%d frames, %d-page file, random clean accesses\n", MISS_FRAMES, MISS_FILE_PAGES);
+    printf("%10s %16.1f\n", "ns/miss", benchMisses());
+    printf("\n%d new pages appended through %d frames\n", APPEND_PAGES, APPEND_FRAMES);
+    printf("%10s %16s %10s\n", "call", "ns/page", "reads");
+    for (int i = 0; i < 2; i++) {
+        int reads;
+        double ns = benchAppend(i == 1, &reads);
+        printf("%10s %16.1f %10d\n", (i == 1) ? "pinNewPage" : "pinPage", ns, reads);
+    }
+    benchStrategies();
+    benchConcurrency();
+    benchBackgroundWriter();
+    benchDirtyAware();
+    benchReadAhead();
+    benchWarmRestart();
+    benchVictimScan(maxFrames);
+    return 0;
+}
@@ -7,6 +7,9 @@
 // #include <time.h>
 #include <stdio.h>
 #include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
 
 #ifdef DEBUG // define this macro from makefile to enable debug print
     #define DEBUG_PRINT(format, ...) printf(format, ##__VA_ARGS__)
@@ -14,41 +17,312 @@
     #define DEBUG_PRINT(format, ...)
 #endif
 
+// fields touched without the pool latch in concurrent mode (fix counts, CLOCK's reference bits, isDirty)
+#define ATOMIC_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE(ptr, val) __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+#define ATOMIC_ADD(ptr, val) __atomic_add_fetch((ptr), (val), __ATOMIC_ACQ_REL)
+// statistics counters order nothing, a relaxed add is all they need
+#define STAT_ADD(ptr, val) __atomic_add_fetch((ptr), (val), __ATOMIC_RELAXED)
+
+#define DEFAULT_LATCH_STRIPES 16
+#define DEFAULT_CLEANER_DIRTY_PERCENT 10
+#define DEFAULT_PIN_WAIT_MS 100 // BM_PoolOptions.pinWaitMs 0, also the cap of PIN_WAIT_FOREVER in a partition
+#define READ_AHEAD_TRIGGER 2 // pins of the next page in a row before read-ahead starts
+#define PREFETCH_MAX_RUN 32  // consecutive queued pages the I/O thread reads with one readBlocks
+
+// RS_ADAPTIVE
+#define ADAPTIVE_CANDIDATES 3         // policies simulated by the shadow caches
+#define ADAPTIVE_MIN_SHADOW 64        // default sampling keeps at least this many pages per shadow
+#define ADAPTIVE_MAX_SAMPLE_RATE 64   // default sampling simulates at least 1 page in this many
+#define ADAPTIVE_MIN_EPOCH 256        // sampled pins between two policy decisions, at least
+
+// GCLOCK defaults and the bit marking a dirty frame the hand already passed over at count 0
+#define GCLOCK_DEFAULT_MAX_COUNT 4
+#define GCLOCK_SPARED (1 << 30)
+
+// pages of every file of the pool share one page table: the key of a page is its file id above its page number
+#define FILE_ID_SHIFT 20
+#define MAX_FILE_PAGES (1 << FILE_ID_SHIFT) // pages per file, 4GB
+#define MAX_POOL_FILES (1 << (31 - FILE_ID_SHIFT)) // file ids, keys stay positive
+
+// Frame.ioState
+#define IO_NONE 0            // the frame data is valid
+#define IO_PENDING 1         // a miss or the I/O thread is reading the page, pinners wait on ioCond
+#define IO_FAILED 2          // the read failed, the next pinner reads the page itself
+
+// internal to pinPageWith: the pool latch was dropped during a miss and another thread loaded the page, look again
+#define RC_PIN_AGAIN (-100)
+
 /*----------------------local data structures----------------------*/
 // metadata structure for each frame in the buffer pool
 typedef struct Frame {
     BM_PageHandle pageHandle; // frame handle, including pageNum (page number in pages file) and data buffer in frame
     bool isDirty;             // dirty flag
-    int fixCount;             // fix count
-    // related with FIFO
-    unsigned int enterCounter;  // counter when the page was loaded into the frame (for FIFO)
-    // related with LRU
-    unsigned int lastAccessCounter;   // last access counter value(for LRU)
-    // related with LFU
-    int refCount;             // reference count (for LFU)
-    // related with LRU-K
-    unsigned long int *accessTimes;    // access history (for LRU-K)
-    int accessCount;          // access history size (for LRU-K)
-    // related with CLOCK policy
-    int clockBit;             // clock bit (for CLOCK policy)
+    unsigned long int dirtyTime; // when the page went from clean to dirty, older pages are cleaned first
+    // the fix count lives in BM_MgmtData.fixCounts and replacement metadata in the policy's own
+    // per-frame arrays (BM_MgmtData.clockBits ...), the victim scans only touch those
+    // related with page table
+    int hashNext;             // next frame in the same page table bucket, -1 ends the chain
+    // related with prefetch
+    short ioState;            // IO_NONE, IO_PENDING or IO_FAILED
 } Frame;
 
+// list links of a frame, indexed like frames (for FIFO, LRU, LFU, ARC and 2Q)
+typedef struct ListNode {
+    int prev;                 // previous (less recently used) frame in the frame's list, -1 if none
+    int next;                 // next (more recently used) frame in the frame's list, -1 if none
+    int listId;               // ARC/2Q list holding the frame: ARC_T1, ARC_T2, Q2_A1IN, Q2_AM or LIST_NONE
+} ListNode;
+
+// intrusive doubly-linked list of frames, threaded through BM_MgmtData.listNodes
+typedef struct FrameList {
+    int head;                 // least recently used frame, -1 if the list is empty
+    int tail;                 // most recently used frame, -1 if the list is empty
+    int size;                 // number of frames in the list
+} FrameList;
+
+// ARC and 2Q lists, T1/T2/A1in/Am hold resident frames, B1/B2/A1out hold ghost page numbers
+#define LIST_NONE 0
+#define ARC_T1 1
+#define ARC_T2 2
+#define ARC_B1 3
+#define ARC_B2 4
+#define Q2_A1IN 5
+#define Q2_AM 6
+#define Q2_A1OUT 7
+
+// ghost entry of a recently evicted page (for ARC and 2Q)
+typedef struct Ghost {
+    PageNumber pageNum;       // evicted page, NO_PAGE if the entry is unused
+    int listId;               // ARC_B1, ARC_B2 or Q2_A1OUT
+    int prev;                 // previous (older) ghost in the same list, -1 if none
+    int next;                 // next (newer) ghost in the same list, -1 if none
+    int hashNext;             // next ghost in the same bucket, -1 ends the chain
+} Ghost;
+
+// frames with the same reference count, buckets are kept in ascending count order (for LFU)
+typedef struct LFUBucket {
+    int freq;                 // reference count shared by the frames in the bucket
+    int prev;                 // bucket with the next lower count, -1 if none
+    int next;                 // bucket with the next higher count, -1 if none
+    FrameList frames;         // unpinned frames in the order they reached freq or were unpinned, threaded through BM_MgmtData.listNodes
+    int numPinned;            // pinned frames with this count, they are in no list until unpinned
+} LFUBucket;
+
+// dirty frame considered by the background writer or a batch flush
+typedef struct CleanCandidate {
+    unsigned long int dirtyTime; // Frame.dirtyTime when the candidate was picked
+    PageNumber pageNum;       // page in the frame when the candidate was picked
+    int frameIdx;             // frame index
+} CleanCandidate;
+
+// resident page of a warm restart, rank 0 is the page the policy would evict last
+typedef struct WarmPage {
+    PageNumber pageNum;       // page number in the file
+    int rank;                 // position in the saved order, hottest first
+    int frameIdx;             // while loading: frame the page is read into, -1 if the read failed
+    unsigned long int heat;   // while saving: the policy's heat of the page's frame
+} WarmPage;
+
+// reference history of a resident frame, its K reference times are in BM_MgmtData.lruKTimes (for LRU-K)
+typedef struct LRUKFrame {
+    int accessCount;          // number of valid reference times, at most K
+    int accessHead;           // ring slot the next reference is written to, the oldest one once the ring is full
+    unsigned long int lastAccess; // time of the last reference, correlated or not
+    int heapPos;              // position in the LRU-K victim heap, -1 if not in it
+} LRUKFrame;
+
+// retained reference history of a page that is no longer resident (for LRU-K)
+typedef struct LRUKHistory {
+    PageNumber pageNum;       // page the history belongs to, NO_PAGE if the entry is unused
+    int accessCount;          // same meaning as in LRUKFrame
+    int accessHead;           // same meaning as in LRUKFrame
+    unsigned long int lastAccess; // same meaning as in LRUKFrame
+    int hashNext;             // next entry in the same history bucket, -1 ends the chain
+} LRUKHistory;
+
+// a page file cached by the pool, slot 0 holds the file given to initBufferPool (none if it was NULL)
+typedef struct PoolFile {
+    SM_FileHandle fileHandle; // mgmtInfo is NULL while the slot is unused
+    PageNumber newPagesEnd;   // one past the highest page made by pinNewPage, the file is extended to it lazily;
+                              // only the file owner's entry is used, read and written under the file latch
+    BM_BufferPool *view;      // handle pinning the file, NULL if the slot is free; slot 0 is the pool's own handle
+} PoolFile;
+
+// one page aligned block of frame data, made by initBufferPool or by a resizeBufferPool that grows the pool
+typedef struct ArenaSegment {
+    char *base;               // numFrames * PAGE_SIZE bytes aligned to PAGE_SIZE
+    int firstFrame;           // frame whose data starts at base
+    int numFrames;            // frames [firstFrame, firstFrame + numFrames) live in the block
+} ArenaSegment;
+
+// key-only cache replaying the sampled pins under one candidate policy (for RS_ADAPTIVE)
+typedef struct ShadowCache {
+    ReplacementStrategy strategy; // RS_LRU, RS_LFU or RS_CLOCK
+    int size;                 // slots [0, size) hold keys
+    PageNumber *keys;         // page key of each slot
+    unsigned long int *meta;  // LFU: reference count, CLOCK: reference bit
+    unsigned long int *stamp; // sampled pin count at the slot's last pin (LRU, LFU ties)
+    int *hashNext;            // next slot in the same bucket, -1 ends the chain
+    int *table;               // hash buckets, -1 if empty
+    int tableMask;            // number of buckets - 1
+    int hand;                 // CLOCK hand
+    int ticks;                // LFU: pins since the last halving
+    unsigned long long hits;  // hits in the current epoch
+} ShadowCache;
+
+// state of RS_ADAPTIVE: the live policy runs the frames, the shadows score every candidate
+typedef struct AdaptiveState {
+    const struct ReplacementPolicy *live; // policy the frames are handed to
+    int liveIndex;            // its index in adaptiveCandidates
+    ShadowCache shadows[ADAPTIVE_CANDIDATES]; // one per candidate, same order
+    int sampleRate;           // 1 page in sampleRate is replayed on the shadows, a power of 2
+    int slots;                // slots allocated per shadow
+    int target;               // shadow size, numPages / sampleRate
+    int epochLength;          // sampled pins between two decisions
+    int epochAccesses;        // sampled pins in the current epoch
+    unsigned long int clock;  // sampled pins so far
+} AdaptiveState;
+
 // metadata structure for the buffer pool
 typedef struct BM_MgmtData {
-    Frame *frames;       // pointer to a frame array
-    SM_FileHandle fileHandle;// file handle
-    int numReadIO;           // number of read IO
-    int numWriteIO;          // number of write IO
+    Frame *frames;       // pointer to a frame array, pageHandle.pageNum holds the page key
+    int *fixCounts;          // fix count of each frame, kept apart from frames so that victim scans read 4 bytes a frame
+    int capacity;            // entries in frames and every other per-frame array, numPages <= capacity
+    ArenaSegment *arenas;    // frame data blocks in frame order, frame data never moves while the pool is open
+    int numArenas;           // number of blocks in arenas
+    int arenaFrames;         // frames that have data, the end of the last block
+    PoolFile *files;         // page files, a page's key selects its slot
+    int numFiles;            // slots in files, the array only moves under the pool and the file latch
+    BM_PoolStats stats;      // counters for getPoolStats, updated with STAT_ADD from any thread
+    FILE *trace;             // access trace of startBufferTrace, NULL when off
+    pthread_mutex_t traceLatch; // orders the trace records, always initialized
+    // related with the replacement policy, only the arrays of bm->strategy's policy are allocated
+    const struct ReplacementPolicy *policy; // hooks of bm->strategy
+    AdaptiveState *adaptive; // RS_ADAPTIVE's shadows and live policy, NULL for the other strategies
+    ListNode *listNodes;     // capacity list links (FIFO, LRU, LFU, ARC, 2Q)
+    // related with FIFO, list of resident frames in load order, pinned ones included
+    FrameList fifoList;
     // related with CLOCK
+    int *clockBits;          // capacity reference bits, set without the pool latch; GCLOCK: counts | GCLOCK_SPARED
     int clockHand;           // clock hand (for CLOCK policy)
+    // related with GCLOCK, which shares the hand and clockBits with CLOCK
+    int gclockLoadWeight;    // BM_GCLOCKParams.loadWeight
+    int gclockHitWeight;     // BM_GCLOCKParams.hitWeight
+    int gclockMaxCount;      // BM_GCLOCKParams.maxCount
+    // related with LRU, list of unpinned frames from least to most recently used
+    FrameList lruList;
+    // related with ARC
+    FrameList arcT1;         // resident pages seen once recently
+    FrameList arcT2;         // resident pages seen at least twice recently
+    FrameList arcB1;         // ghosts evicted from T1, linked through Ghost.prev/next
+    FrameList arcB2;         // ghosts evicted from T2, linked through Ghost.prev/next
+    int arcP;                // adaptive target size of T1
+    bool arcNoGhost;         // the next victim is dropped without becoming a ghost
+    // related with 2Q
+    FrameList q2A1in;        // resident pages seen once, FIFO
+    FrameList q2Am;          // resident pages re-referenced after leaving A1in, LRU
+    FrameList q2A1out;       // ghosts evicted from A1in, linked through Ghost.prev/next
+    int q2Kin;               // target size of A1in
+    int q2KinParam;          // BM_2QParams.kin, 0 = numPages / 4 which follows resizeBufferPool
+    // related with ghost lists (ARC and 2Q)
+    int ghostHit;            // ghost list the page being loaded was found in (LIST_NONE, ARC_B1, ARC_B2, Q2_A1OUT)
+    Ghost *ghosts;           // ghost entries, capacity for ARC and Kout for 2Q
+    int *freeGhosts;         // stack of unused ghost entries
+    int numFreeGhosts;       // number of entries in freeGhosts
+    int *ghostTable;         // hash buckets of ghost entries, -1 if empty
+    int ghostMask;           // number of ghost buckets - 1
+    // related with LFU, a frame's reference count is the freq of its bucket
+    int *lfuFrameBucket;     // capacity bucket indexes, -1 if the frame is in none
+    LFUBucket *lfuBuckets;   // capacity buckets, at most one per distinct reference count
+    int *lfuFreeBuckets;     // stack of unused buckets
+    int lfuNumFreeBuckets;   // number of entries in lfuFreeBuckets
+    int lfuHead;             // bucket with the lowest reference count, -1 if none
+    int *lfuScratch;         // capacity entries, while aging: the bucket the frames of a bucket move to
+    int lfuAgingPeriod;      // references between two halvings of every count, 0 = never
+    int lfuTicks;            // references since the last halving
     // related with LRU-K
     int k;                   // LRU-K's K value
-    unsigned long int globalTime; // counter for LRU-K
+    unsigned long int globalTime; // counter for LRU-K, advanced on every pin
+    int correlatedPeriod;    // references closer than this to the last one are correlated
+    LRUKFrame *lruKFrames;   // capacity reference histories
+    unsigned long int *lruKTimes; // capacity * K reference times, K per frame
+    int *lruKHeap;           // min-heap of unpinned frames ordered by backward K-distance
+    int lruKHeapSize;        // number of frames in lruKHeap
+    int *lruKDeferred;       // scratch for frames skipped during victim selection
+    LRUKHistory *history;    // reference history of evicted pages
+    unsigned long int *historyTimes; // historySize * K reference times
+    int historySize;         // number of entries in history
+    int historyNext;         // next history entry to overwrite (FIFO)
+    int *historyTable;       // hash buckets of history entries, -1 if empty
+    int historyMask;         // number of history buckets - 1
+    // related with page table (pageNum -> frame index)
+    int *pageTable;          // bucket heads, each one is a frame index or -1
+    int pageTableMask;       // number of buckets - 1 (number of buckets is a power of 2)
+    // related with free frames
+    int *freeFrames;         // stack of frame indexes that never held a page
+    int numFreeFrames;       // number of entries in freeFrames
+    // related with concurrency, latches are only taken in concurrent mode
+    bool concurrent;         // the pool may be used by several threads
+    pthread_mutex_t poolLatch; // serializes misses, flushes and replacement bookkeeping
+    pthread_mutex_t *stripeLatches; // page table stripes, bucket b is covered by stripe b & stripeMask
+    int stripeMask;          // number of stripes - 1
+    pthread_rwlock_t *frameLatches; // per-frame content latches taken by pinPageShared/pinPageExclusive
+    const char **frameWriters; // per frame: threadToken of the thread holding the exclusive latch, NULL if none
+    // related with pins that find every frame pinned
+    int pinWaitMs;           // BM_PoolOptions.pinWaitMs
+    int frameWaiters;        // pins waiting on frameCond, read by unpins without the pool latch
+    pthread_cond_t frameCond; // broadcast when a frame is unpinned or added while pins wait, used with poolLatch
+    // related with the background dirty page writer
+    unsigned long int dirtyClock; // stamps Frame.dirtyTime
+    bool cleanerRunning;     // the writer thread exists
+    bool cleanerStop;        // asks the writer thread to exit, protected by poolLatch
+    pthread_t cleaner;       // writer thread
+    pthread_cond_t cleanerCond; // wakes the writer early, used with poolLatch
+    int cleanerIntervalMs;   // writer period
+    int cleanerDirtyPercent; // dirty share of unpinned frames the writer tolerates
+    CleanCandidate *cleanerScratch; // capacity candidates, only used by the writer
+    // related with prefetch and read-ahead
+    pthread_mutex_t fileLatch; // serializes the storage manager, prefetch reads run without the pool latch
+    pthread_cond_t ioCond;   // broadcast when a read or a victim write-back completes, used with poolLatch
+    PageNumber *writeBacks;  // keys of the dirty victims being written without the pool latch, capacity entries
+    int numWriteBacks;       // number of keys in writeBacks, protected by poolLatch
+    pthread_mutex_t prefetchLatch; // protects the prefetch queue and the sequential pin detector
+    pthread_cond_t prefetchCond; // wakes the I/O thread, used with prefetchLatch
+    PageNumber *prefetchQueue; // ring of requested pages, capacity entries
+    int prefetchHead;        // oldest request in prefetchQueue
+    int prefetchCount;       // number of queued requests
+    bool prefetcherRunning;  // the I/O thread exists, started by the first request
+    bool prefetcherStop;     // asks the I/O thread to exit, protected by prefetchLatch
+    pthread_t prefetcher;    // I/O thread
+    int readAheadPages;      // read-ahead window, 0 = off
+    PageNumber seqLast;      // last page pinned
+    int seqRun;              // pins of the next page in a row
+    PageNumber readAheadNext; // first page after the read-ahead already queued
+    // related with partitions, a partitioned pool's own BM_MgmtData only routes to its sub-pools
+    struct BM_BufferPool *partitions; // sub-pools pages are hashed to, NULL if the pool is not partitioned
+    int numPartitions;       // number of sub-pools
+    struct BM_MgmtData *fileOwner; // holds the page files and the file latch: this pool, or partition 0 of a partitioned pool
+    // related with warm restart, set on the pool handle and not on its partitions
+    bool warmRestart;        // BM_PoolOptions.warmRestart
 } BM_MgmtData;
 
-// local counter for every time a page is loaded into a frame
-static unsigned int gLoadCounter = 0;
-static unsigned int gAccessCounter = 0;
+// a replacement strategy's hooks, called with the pool latch held unless noted.
+// Each policy owns its metadata in BM_MgmtData and only sees frames through these calls.
+typedef struct ReplacementPolicy {
+    bool latchFreeHits;      // onHit and onUnpin only touch the frame's own metadata, under a stripe latch
+    RC (*init)(BM_BufferPool *bm, void *stratData);   // allocate the metadata of mgmt->capacity frames
+    RC (*grow)(BM_BufferPool *bm, int newCapacity);   // make room for frames [capacity, newCapacity)
+    void (*release)(BM_BufferPool *bm);                // free the metadata, init may run again afterwards
+    void (*resize)(BM_BufferPool *bm, int newNumPages); // bm->numPages changed, NULL if nothing depends on it
+    void (*onMiss)(BM_BufferPool *bm, PageNumber key); // key is about to be loaded, before a victim is picked; may be NULL
+    void (*onLoad)(BM_BufferPool *bm, int frameIdx);   // a page was loaded into the pinned frame
+    void (*onHit)(BM_BufferPool *bm, int frameIdx);    // a resident page was pinned, also under its stripe latch
+    void (*onUnpin)(BM_BufferPool *bm, int frameIdx);  // a pin was released, also under its stripe latch
+    int (*pickVictim)(BM_BufferPool *bm);              // unpinned frame to evict, -1 if every frame is pinned
+    void (*onEvict)(BM_BufferPool *bm, int frameIdx);  // the frame's page leaves the pool
+    void (*rank)(BM_BufferPool *bm, unsigned long int *heat); // heat of the unpinned frames, a hotter one is evicted later
+} ReplacementPolicy;
 /*----------------------Debug functions ----------------------*/
 /** 
 * @brief show the buffer pool metadata
@@ -78,17 +352,175 @@ static void showFrames(BM_BufferPool *bm) {
         return;
     }
     for (int i = 0; i < bm->numPages; i++) {
-        printf("Frame %d: pageNum %d, isDirty %d, fixCount %d, refCount %d, clockBit %d\n",
-               i, mgmt->frames[i].pageHandle.pageNum, mgmt->frames[i].isDirty, mgmt->frames[i].fixCount, mgmt->frames[i].refCount, mgmt->frames[i].clockBit);
+        printf("Frame %d: pageNum %d, isDirty %d, fixCount %d\n",
+               i, mgmt->frames[i].pageHandle.pageNum, mgmt->frames[i].isDirty, mgmt->fixCounts[i]);
     }
     printf("Clock Hand: %d\n", mgmt->clockHand);
     printf("k: %d\n", mgmt->k);
-    printf("numReadIO: %d, numWriteIO: %d\n", mgmt->numReadIO, mgmt->numWriteIO);
+    printf("numReadIO: %llu, numWriteIO: %llu\n", mgmt->stats.readIO, mgmt->stats.writeIO);
     printf("\n");
 }
 #endif
 
 /*----------------------Utility functions ----------------------*/
+/** 
+* @brief hash a page number to a page table bucket
+* @param mgmt, input value, a buffer pool metadata structure pointer
+* @param pageNum, input value, page number to hash
+* @return int, the bucket index in the page table
+*/
+static inline int hashPage(BM_MgmtData *mgmt, PageNumber pageNum) {
+    // Fibonacci hashing spreads sequential page numbers over all buckets
+    return (int)(((unsigned int)pageNum * 2654435761u) & (unsigned int)mgmt->pageTableMask);
+}
+
+// key of a page of the file bm pins from
+static inline PageNumber pageKey(BM_BufferPool *bm, PageNumber pageNum) {
+    return (bm->fileId << FILE_ID_SHIFT) | pageNum;
+}
+
+// page number within its file of a key
+static inline PageNumber keyPage(PageNumber key) {
+    return (key == NO_PAGE) ? NO_PAGE : (key & (MAX_FILE_PAGES - 1));
+}
+
+// file slot of a key
+static inline int keyFileId(PageNumber key) {
+    return key >> FILE_ID_SHIFT;
+}
+
+// the page file a key belongs to, read under the pool latch or the file latch; partitions share partition 0's
+static inline SM_FileHandle *keyFile(BM_MgmtData *mgmt, PageNumber key) {
+    return &mgmt->fileOwner->files[keyFileId(key)].fileHandle;
+}
+
+// the sub-pool of a partitioned pool that caches pageNum, the high bits of the hash leave the page table's to it
+static inline BM_BufferPool *partitionOf(BM_MgmtData *mgmt, PageNumber pageNum) {
+    return &mgmt->partitions[(((unsigned int)pageNum * 2654435761u) >> 16) % (unsigned int)mgmt->numPartitions];
+}
+
+/*----------------------latch functions ----------------------*/
+// pool latch: held for misses, flushes and every policy that reorders frames on a hit
+static inline void latchPool(BM_MgmtData *mgmt) {
+    if (mgmt->concurrent) pthread_mutex_lock(&mgmt->poolLatch);
+}
+
+static inline void unlatchPool(BM_MgmtData *mgmt) {
+    if (mgmt->concurrent) pthread_mutex_unlock(&mgmt->poolLatch);
+}
+
+// file latch: the storage manager shares one FILE position, every call on the page file takes it
+static inline void latchFile(BM_MgmtData *mgmt) {
+    if (mgmt->concurrent) pthread_mutex_lock(&mgmt->fileOwner->fileLatch);
+}
+
+static inline void unlatchFile(BM_MgmtData *mgmt) {
+    if (mgmt->concurrent) pthread_mutex_unlock(&mgmt->fileOwner->fileLatch);
+}
+
+// stripe latch: covers the page table buckets of pageNum's stripe
+static inline void latchStripe(BM_MgmtData *mgmt, PageNumber pageNum) {
+    if (mgmt->concurrent) pthread_mutex_lock(&mgmt->stripeLatches[hashPage(mgmt, pageNum) & mgmt->stripeMask]);
+}
+
+static inline void unlatchStripe(BM_MgmtData *mgmt, PageNumber pageNum) {
+    if (mgmt->concurrent) pthread_mutex_unlock(&mgmt->stripeLatches[hashPage(mgmt, pageNum) & mgmt->stripeMask]);
+}
+
+// every stripe latch in stripe order, keeps all hits and unpins out while resizeBufferPool detaches frames
+static void latchAllStripes(BM_MgmtData *mgmt) {
+    if (!mgmt->concurrent) return;
+    for (int i = 0; i <= mgmt->stripeMask; i++) {
+        pthread_mutex_lock(&mgmt->stripeLatches[i]);
+    }
+}
+
+static void unlatchAllStripes(BM_MgmtData *mgmt) {
+    if (!mgmt->concurrent) return;
+    for (int i = mgmt->stripeMask; i >= 0; i--) {
+        pthread_mutex_unlock(&mgmt->stripeLatches[i]);
+    }
+}
+
+// its address tells the threads apart, a frame's writer is recorded so that forcePage can write for it
+static __thread char threadToken;
+
+// frame content latch, taken by page users after the pin and never while holding the pool or a stripe latch
+static inline void latchFrame(BM_MgmtData *mgmt, int frameIdx, bool exclusive) {
+    if (!mgmt->concurrent) return;
+    if (exclusive) {
+        pthread_rwlock_wrlock(&mgmt->frameLatches[frameIdx]);
+        ATOMIC_STORE(&mgmt->frameWriters[frameIdx], &threadToken);
+    } else {
+        pthread_rwlock_rdlock(&mgmt->frameLatches[frameIdx]);
+    }
+}
+
+static inline void unlatchFrame(BM_MgmtData *mgmt, int frameIdx) {
+    if (!mgmt->concurrent) return;
+    if (ATOMIC_LOAD(&mgmt->frameWriters[frameIdx]) == &threadToken) ATOMIC_STORE(&mgmt->frameWriters[frameIdx], NULL);
+    pthread_rwlock_unlock(&mgmt->frameLatches[frameIdx]);
+}
+
+// the calling thread holds the frame's exclusive latch
+static inline bool ownsFrameLatch(BM_MgmtData *mgmt, int frameIdx) {
+    return mgmt->concurrent && ATOMIC_LOAD(&mgmt->frameWriters[frameIdx]) == &threadToken;
+}
+
+// change a fix count, a locked add is only paid for in concurrent mode. The add is sequentially consistent
+// for waitForFrame: an unpin that reads frameWaiters afterwards can not miss a pin that is about to wait.
+static inline int fixCountAdd(BM_MgmtData *mgmt, int frameIdx, int delta) {
+    if (mgmt->concurrent) return __atomic_add_fetch(&mgmt->fixCounts[frameIdx], delta, __ATOMIC_SEQ_CST);
+    return mgmt->fixCounts[frameIdx] += delta;
+}
+
+// a frame was unpinned or added: wake the pins waiting for one, the pool latch orders the wake-up after their wait
+static inline void wakeFrameWaiters(BM_MgmtData *mgmt, bool poolLatched) {
+    if (!mgmt->concurrent || __atomic_load_n(&mgmt->frameWaiters, __ATOMIC_SEQ_CST) == 0) return;
+    if (!poolLatched) latchPool(mgmt);
+    pthread_cond_broadcast(&mgmt->frameCond);
+    if (!poolLatched) unlatchPool(mgmt);
+}
+
+/** 
+* @brief whether a hit or an unpin changes replacement state shared by all frames.
+*        FIFO, CLOCK and GCLOCK only touch the frame itself, so their hits run under a stripe latch;
+*        the other policies reorder lists or heaps and take the pool latch.
+* @param bm, input value, a buffer pool structure pointer
+* @return bool, true if hits and unpins need the pool latch
+*/
+static inline bool hitNeedsPoolLatch(BM_BufferPool *bm) {
+    return !((BM_MgmtData *)bm->mgmtData)->policy->latchFreeHits;
+}
+
+/** 
+* @brief add a loaded frame to the page table
+* @param mgmt, input value, a buffer pool metadata structure pointer
+* @param frameIdx, input value, frame index whose pageHandle.pageNum is already set
+*/
+static void pageTableInsert(BM_MgmtData *mgmt, int frameIdx) {
+    int bucket = hashPage(mgmt, mgmt->frames[frameIdx].pageHandle.pageNum);
+    mgmt->frames[frameIdx].hashNext = mgmt->pageTable[bucket];
+    mgmt->pageTable[bucket] = frameIdx;
+}
+
+/** 
+* @brief remove a frame from the page table, must be called before its pageNum is cleared
+* @param mgmt, input value, a buffer pool metadata structure pointer
+* @param frameIdx, input value, frame index to remove
+*/
+static void pageTableRemove(BM_MgmtData *mgmt, int frameIdx) {
+    int *link = &mgmt->pageTable[hashPage(mgmt, mgmt->frames[frameIdx].pageHandle.pageNum)];
+    while (*link != -1) {
+        if (*link == frameIdx) {
+            *link = mgmt->frames[frameIdx].hashNext;
+            break;
+        }
+        link = &mgmt->frames[*link].hashNext;
+    }
+    mgmt->frames[frameIdx].hashNext = -1;
+}
+
 /** 
 * @brief get the index of a frame in the buffer pool
 * @param bm, input value, a buffer pool structure pointer
@@ -99,7 +531,8 @@ static int getFrameIndex(BM_BufferPool *bm, PageNumber pageNum) {
     BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
     if (mgmt == NULL) THROW(RC_UNVALID_HANDLE, "Buffer pool bm->mgmtData == NULL");
 
-    for (int i = 0; i < bm->numPages; i++) {
+    // only walk the frames that hash to the same bucket
+    for (int i = mgmt->pageTable[hashPage(mgmt, pageNum)]; i != -1; i = mgmt->frames[i].hashNext) {
         if (mgmt->frames[i].pageHandle.pageNum == pageNum) {
             return i;
         }
@@ -118,646 +551,3921 @@ static int findFreeFrame(BM_BufferPool *bm) {
     BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
     if (mgmt == NULL) THROW(RC_UNVALID_HANDLE, "findFreeFrame: bm->mgmtData == NULL");
 
-    for (int i = 0; i < bm->numPages; i++) {
-        if (mgmt->frames[i].fixCount == 0 && mgmt->frames[i].pageHandle.pageNum == NO_PAGE) {
-            return i;
-        }
+    if (mgmt->numFreeFrames > 0) {
+        return mgmt->freeFrames[--mgmt->numFreeFrames];
     }
     DEBUG_PRINT("No free frame found in buffer pool\n");
     return -1;
 }
 
-// 辅助函数：更新页面访问时间戳
-static RC recordAccess(BM_BufferPool *bm, int frameIndex) {
-    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
-    if (mgmt == NULL) THROW(RC_UNVALID_HANDLE, "recordAccess: bm->mgmtData == NULL");
+// put an empty frame back on the free stack, the caller holds the pool latch; pins waiting for a frame can take it
+static void releaseFreeFrame(BM_MgmtData *mgmt, int frameIdx) {
+    mgmt->freeFrames[mgmt->numFreeFrames++] = frameIdx;
+    wakeFrameWaiters(mgmt, true);
+}
 
-    // 添加frameIndex范围检查
-    if (frameIndex < 0 || frameIndex >= bm->numPages) {
-        DEBUG_PRINT("Warning: recordAccess: invalid frame index %d\n", frameIndex);
-        return RC_OK;  // 返回OK避免程序崩溃
+// true if the page is a victim being written back without the pool latch, the caller holds the pool latch
+static bool isWrittenBack(BM_MgmtData *mgmt, PageNumber key) {
+    for (int i = 0; i < mgmt->numWriteBacks; i++) {
+        if (mgmt->writeBacks[i] == key) return true;
     }
+    return false;
+}
 
-    Frame *frame = &mgmt->frames[frameIndex];
-    mgmt->globalTime++;  // 全局时间递增
+// wait until no victim is being written back, the caller holds the pool latch
+static void waitForWriteBacks(BM_MgmtData *mgmt) {
+    while (mgmt->numWriteBacks > 0) pthread_cond_wait(&mgmt->ioCond, &mgmt->poolLatch);
+}
 
-    if (frame->accessCount < mgmt->k) {
-        // 未满K次，直接记录
-        frame->accessTimes[frame->accessCount++] = mgmt->globalTime;
-    } else {
-        // 已满K次，移位并更新最近一次
-        for (int i = 0; i < mgmt->k - 1; i++) {
-            frame->accessTimes[i] = frame->accessTimes[i + 1];
-        }
-        frame->accessTimes[mgmt->k - 1] = mgmt->globalTime;
-    }
-    return RC_OK;
+/*----------------------frame list functions ----------------------*/
+/** 
+* @brief remove a frame from a frame list, do nothing if it is not in the list
+* @param mgmt, input value, a buffer pool metadata structure pointer
+* @param list, input value, the list the frame may be in
+* @param frameIdx, input value, frame index to remove
+*/
+static void listUnlink(BM_MgmtData *mgmt, FrameList *list, int frameIdx) {
+    ListNode *node = &mgmt->listNodes[frameIdx];
+    if (node->prev == -1 && list->head != frameIdx) 
+        return; // not in the list
+
+    if (node->prev != -1) mgmt->listNodes[node->prev].next = node->next;
+    else list->head = node->next;
+    if (node->next != -1) mgmt->listNodes[node->next].prev = node->prev;
+    else list->tail = node->prev;
+    node->prev = -1;
+    node->next = -1;
+    list->size--;
 }
 
 /** 
-* @brief select a victim frame in the buffer pool according to the replacement strategy.
-* @param bm, input value, a buffer pool structure pointer
-* @return int, the index of the victim frame in the buffer pool
+* @brief append a frame to the most recently used end of a frame list,
+*        the frame must not be in any list
+* @param mgmt, input value, a buffer pool metadata structure pointer
+* @param list, input value, the list to append to
+* @param frameIdx, input value, frame index to append
 */
-static int selectReplacementFrame(BM_BufferPool *bm) {
-    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
-    if (mgmt == NULL) 
-        THROW(RC_UNVALID_HANDLE, "selectReplacementFrame: bm->mgmtData == NULL");
+static void listPushBack(BM_MgmtData *mgmt, FrameList *list, int frameIdx) {
+    ListNode *node = &mgmt->listNodes[frameIdx];
+    node->prev = list->tail;
+    node->next = -1;
+    if (list->tail != -1) mgmt->listNodes[list->tail].next = frameIdx;
+    else list->head = frameIdx;
+    list->tail = frameIdx;
+    list->size++;
+}
 
-    int victimIndex = -1;
-    int numPages = bm->numPages;
+// reset a frame list to empty
+static void listInit(FrameList *list) {
+    list->head = -1;
+    list->tail = -1;
+    list->size = 0;
+}
 
-    // find all frames with fixCount=0
-    int *candidates = malloc(numPages * sizeof(int));
-    int candiCount = 0;
-    for (int i = 0; i < numPages; i++) {
-        if (mgmt->frames[i].fixCount == 0) {
-            candidates[candiCount++] = i;
-        }
-    }
-    if (candiCount == 0) {
-        free(candidates);
-        THROW(RC_UNVALID_HANDLE, "No available victim (all frames are pinned)");
+// least recently used unpinned frame of a list, -1 if all are pinned; FIFO hits pin without the pool latch
+static int listLruUnpinned(BM_MgmtData *mgmt, FrameList *list) {
+    for (int i = list->head; i != -1; i = mgmt->listNodes[i].next) {
+        if (ATOMIC_LOAD(&mgmt->fixCounts[i]) == 0) return i;
     }
+    return -1;
+}
 
-    // select a victim from candidates to replace
-    switch (bm->strategy) {
-        case RS_FIFO: {
-            // traverse all candidates to find the ealiest frame
-            victimIndex = candidates[0];
-            unsigned int earliestTime = mgmt->frames[victimIndex].enterCounter;
-            for (int j = 0; j < candiCount; j++) {
-                int currIdx = candidates[j];
-                if (mgmt->frames[currIdx].enterCounter < earliestTime) {
-                    earliestTime = mgmt->frames[currIdx].enterCounter;
-                    victimIndex = currIdx;
-                }
-            }
-            break;
-        }
+// number the frames of a list from its head on, the head is evicted first; numbering continues at *next
+static void listRank(BM_MgmtData *mgmt, FrameList *list, unsigned long int *heat, unsigned long int *next) {
+    for (int i = list->head; i != -1; i = mgmt->listNodes[i].next) {
+        heat[i] = (*next)++;
+    }
+}
 
-        case RS_LRU: {
-            victimIndex = candidates[0];
-            unsigned int earliestAccess = mgmt->frames[victimIndex].lastAccessCounter;
-            for (int j = 0; j < candiCount; j++) {
-                int currIdx = candidates[j];
-                if (mgmt->frames[currIdx].lastAccessCounter < earliestAccess) {
-                    earliestAccess = mgmt->frames[currIdx].lastAccessCounter;
-                    victimIndex = currIdx;
-                }
-            }
-            break;
-        }
+/** 
+* @brief reallocate a per-frame policy array, the first entries are kept
+* @param array, input and output value, the array, unchanged if the allocation fails
+* @param elemSize, input value, size of one entry
+* @param count, input value, new number of entries
+* @return bool, false if the allocation failed
+*/
+static bool growArray(void **array, size_t elemSize, int count) {
+    void *grown = realloc(*array, (size_t)count * elemSize);
+    if (grown == NULL) return false;
+    *array = grown;
+    return true;
+}
 
-        case RS_CLOCK: {
-            // CLOCK：从当前clockHand开始寻找clockBit=0的帧
-            int start = mgmt->clockHand;
-                while (1) {
-                    int currIdx = mgmt->clockHand;
-                    // 移动时钟指针（循环）
-                    mgmt->clockHand = (mgmt->clockHand + 1) % numPages;
-                    // 检查当前帧是否为候选（fixCount=0）
-                    if (mgmt->frames[currIdx].fixCount == 0) {
-                        if (mgmt->frames[currIdx].clockBit == 0) {
-                            victimIndex = currIdx;
-                            break;
-                        } else {
-                            // 重置引用位，继续寻找
-                            mgmt->frames[currIdx].clockBit = 0;
-                        }
-                    }
-                    // 防止死循环（理论上不会触发，因为已有候选帧）
-                    if (mgmt->clockHand == start) break;
-                }
-            break;
-        }
-        case RS_LFU: {
-            // LFU：选择引用计数最少的帧
-            victimIndex = candidates[0];
-                int minRefCount = mgmt->frames[victimIndex].refCount;
-                // 寻找引用计数最小的帧
-                for (int j = 1; j < candiCount; j++) {
-                    int currIdx = candidates[j];
-                    if (mgmt->frames[currIdx].refCount < minRefCount) {
-                        minRefCount = mgmt->frames[currIdx].refCount;
-                        victimIndex = currIdx;
-                    }
-                }
-            break;
-        }
-        case RS_LRU_K: {
-            // LRU-K：选择第K次最近访问时间最早的帧
-            victimIndex = -1;
-            unsigned long int minKthTime = ULONG_MAX;
-
-            for (int j = 0; j < bm->numPages; j++) {
-                int currIdx = j;
-                Frame *frame = &mgmt->frames[currIdx];
-                
-                unsigned long int kthTime;
-                if (frame->accessCount < mgmt->k) {
-                    // 访问次数不足K次，使用首次访问时间作为判断依据
-                    kthTime = frame->accessTimes[0];
-                } else {
-                    // 访问次数达到K次，使用第K次访问时间
-                    kthTime = frame->accessTimes[mgmt->k - 1];
-                }
-// 寻找第K次访问时间最早的页面
-                if (kthTime < minKthTime) {
-                    minKthTime = kthTime;
-                    victimIndex = currIdx;
-                }
-            }
-            break;
-        }
-        default:
+// free a policy array and forget it, a later init allocates it again
+#define POLICY_FREE(array) do { free(array); (array) = NULL; } while (0)
 
-            THROW(-1, "Unsupported replacement strategy");
+/** 
+* @brief make the list links of frames [from, to) empty
+*/
+static void listNodesInit(BM_MgmtData *mgmt, int from, int to) {
+    for (int i = from; i < to; i++) {
+        mgmt->listNodes[i].prev = -1;
+        mgmt->listNodes[i].next = -1;
+        mgmt->listNodes[i].listId = LIST_NONE;
     }
+}
 
-    return victimIndex;
+/** 
+* @brief allocate the list links of every frame (FIFO, LRU, LFU, ARC and 2Q)
+* @param bm, input value, a buffer pool structure pointer
+* @return RC, return code
+*/
+static RC listNodesAlloc(BM_BufferPool *bm) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    mgmt->listNodes = (ListNode *)malloc(mgmt->capacity * sizeof(ListNode));
+    if (mgmt->listNodes == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for frame lists");
+    listNodesInit(mgmt, 0, mgmt->capacity);
+    return RC_OK;
 }
 
 /** 
-* @brief flush a frame to disk by frame index
+* @brief make room for the list links of frames [capacity, newCapacity)
 * @param bm, input value, a buffer pool structure pointer
-* @param frameIdx, input value, frame index to flush
+* @param newCapacity, input value, new number of frames
 * @return RC, return code
 */
-static RC  flushFrame(BM_BufferPool *bm, int frameIdx) {
+static RC listNodesGrow(BM_BufferPool *bm, int newCapacity) {
     BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
-    if (mgmt == NULL) THROW(RC_UNVALID_HANDLE, "flushFrame: bm->mgmtData == NULL");
+    if (!growArray((void **)&mgmt->listNodes, sizeof(ListNode), newCapacity)) 
+        THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in resizeBufferPool() for frame lists");
+    listNodesInit(mgmt, mgmt->capacity, newCapacity);
+    return RC_OK;
+}
 
-    // 添加frameIdx范围检查
-    if (frameIdx < 0 || frameIdx >= bm->numPages) {
-        DEBUG_PRINT("Warning: flushFrame: invalid frame index %d\n", frameIdx);
-        return RC_OK;  // 返回OK避免程序崩溃
-    }
+// FIFO and LRU only keep list links
+static void listNodesRelease(BM_BufferPool *bm) {
+    POLICY_FREE(((BM_MgmtData *)bm->mgmtData)->listNodes);
+}
 
-    Frame *frame = &mgmt->frames[frameIdx];
-    if (frame->pageHandle.pageNum == NO_PAGE) 
-        return RC_OK;
+// hook of a policy that has nothing to do at that point
+static void noFrameHook(BM_BufferPool *bm, int frameIdx) {
+    (void)bm;
+    (void)frameIdx;
+}
 
-    if (frame->isDirty) {
-        // write back the dirty frame to pages file
-        DEBUG_PRINT("the frame %d is dirty, write back to pages file\n", frameIdx); // only for debug
+/*----------------------FIFO functions ----------------------*/
+// FIFO keeps the resident frames in one list, the first loaded at its head
+static RC fifoInit(BM_BufferPool *bm, void *stratData) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    (void)stratData;
+    listInit(&mgmt->fifoList);
+    return listNodesAlloc(bm);
+}
 
-        // 1. 检查文件句柄是否有效
-        if (mgmt->fileHandle.mgmtInfo == NULL) {
-            // 文件句柄已无效，无法写回脏页，清除脏位并记录警告
-            DEBUG_PRINT("Warning: Cannot write back dirty frame %d, file handle is invalid\n", frameIdx);
-            frame->isDirty = false;
-            return RC_OK;
-        }
+// a loaded page joins the back of the queue, hits do not move it
+static void fifoOnLoad(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    listUnlink(mgmt, &mgmt->fifoList, frameIdx);
+    listPushBack(mgmt, &mgmt->fifoList, frameIdx);
+}
 
-        // 2. 检查pageNum是否有效（非NO_PAGE且非负值，且在合理范围内）
-        if (frame->pageHandle.pageNum < 0 || frame->pageHandle.pageNum > 1000000) {
-            // 假设合理的页码不会超过100万
-            DEBUG_PRINT("Warning: Cannot write back dirty frame %d, invalid pageNum: %d\n", 
-                    frameIdx, frame->pageHandle.pageNum);
-            frame->isDirty = false;
-            return RC_OK;
-        }
+static void fifoOnEvict(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    listUnlink(mgmt, &mgmt->fifoList, frameIdx);
+}
 
-        // 3. 检查totalNumPages是否为有效正值且在合理范围内
-        if (mgmt->fileHandle.totalNumPages <= 0 || mgmt->fileHandle.totalNumPages > 1000000) {
-            DEBUG_PRINT("Warning: Cannot write back dirty frame %d, invalid totalNumPages: %d\n", 
-                    frameIdx, mgmt->fileHandle.totalNumPages);
-            frame->isDirty = false;
-            return RC_OK;
-        }
+/** 
+* @brief the unpinned frame that was loaded first, only the pinned frames ahead of it in the queue are passed over
+* @return int, victim frame index or -1 if every frame is pinned
+*/
+static int fifoPickVictim(BM_BufferPool *bm) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    return listLruUnpinned(mgmt, &mgmt->fifoList);
+}
 
-        // 4. 检查pageNum是否小于文件总页数
-        if (frame->pageHandle.pageNum >= mgmt->fileHandle.totalNumPages) {
-            DEBUG_PRINT("Warning: Cannot write back dirty frame %d, pageNum %d exceeds totalNumPages %d\n", 
-                    frameIdx, frame->pageHandle.pageNum, mgmt->fileHandle.totalNumPages);
-            frame->isDirty = false;
-            return RC_OK;
-        }
+// a page loaded later is evicted later
+static void fifoRank(BM_BufferPool *bm, unsigned long int *heat) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    unsigned long int next = 1;
+    listRank(mgmt, &mgmt->fifoList, heat, &next);
+}
 
-        // 5. 检查数据指针是否有效
-        if (frame->pageHandle.data == NULL) {
-            DEBUG_PRINT("Warning: Cannot write back dirty frame %d, data pointer is NULL\n", frameIdx);
-            frame->isDirty = false;
-            return RC_OK;
-        }
+/*----------------------CLOCK functions ----------------------*/
+// CLOCK keeps one reference bit per frame and the hand
+static RC clockInit(BM_BufferPool *bm, void *stratData) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    (void)stratData;
+    mgmt->clockHand = 0;
+    mgmt->clockBits = (int *)calloc(mgmt->capacity, sizeof(int));
+    if (mgmt->clockBits == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for CLOCK");
+    return RC_OK;
+}
 
-        // 6. 检查文件名是否有效
-        if (mgmt->fileHandle.fileName == NULL) {
-            DEBUG_PRINT("Warning: Cannot write back dirty frame %d, file name is NULL\n", frameIdx);
-            frame->isDirty = false;
-            return RC_OK;
-        }
+// new frames start with a clear bit
+static RC clockGrow(BM_BufferPool *bm, int newCapacity) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (!growArray((void **)&mgmt->clockBits, sizeof(int), newCapacity)) 
+        THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in resizeBufferPool() for CLOCK");
+    memset(&mgmt->clockBits[mgmt->capacity], 0, (newCapacity - mgmt->capacity) * sizeof(int));
+    return RC_OK;
+}
 
-        // 所有检查通过，可以执行写操作
-        mgmt->numWriteIO++;
-        SM_FileHandle *fh = &mgmt->fileHandle;
+static void clockRelease(BM_BufferPool *bm) {
+    POLICY_FREE(((BM_MgmtData *)bm->mgmtData)->clockBits);
+}
 
-        DEBUG_PRINT("Writing page %d to file, frame %d\n", frame->pageHandle.pageNum, frameIdx);
-        DEBUG_PRINT("File handle: fileName=%s, totalNumPages=%d, curPagePos=%d\n", 
-                    fh->fileName, fh->totalNumPages, fh->curPagePos);
-        DEBUG_PRINT("Data pointer address: %p\n", frame->pageHandle.data);
+// the hand stays inside the frames that remain
+static void clockResize(BM_BufferPool *bm, int newNumPages) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (mgmt->clockHand >= newNumPages) mgmt->clockHand = 0;
+}
 
-        // 添加额外的安全措施：尝试打开文件进行临时检查
-        // 注意：这只是一个临时检查，不应该在生产代码中频繁执行
-        FILE *tempFile = fopen(fh->fileName, "r+b");
-        if (tempFile == NULL) {
-            DEBUG_PRINT("Warning: Cannot open file %s for writing\n", fh->fileName);
-            frame->isDirty = false;
-            return RC_OK;
-        }
-        fclose(tempFile); // 立即关闭，只检查文件是否可访问
+// loads, hits and unpins set the reference bit, hits may do so concurrently under a stripe latch
+static void clockReference(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    ATOMIC_STORE(&mgmt->clockBits[frameIdx], 1);
+}
 
-        // 直接传递frame->pageHandle.data，不需要类型转换
-        RC rc = writeBlock(frame->pageHandle.pageNum, fh, frame->pageHandle.data);
-        if (rc != RC_OK) {
-            // 记录错误但继续执行，而不是退出程序
-            DEBUG_PRINT("Error writing back frame %d: %s\n", frameIdx, errorMessage(rc));
-            return rc;  // 返回错误代码给调用者
-        }
+// a free frame is never referenced
+static void clockOnEvict(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    ATOMIC_STORE(&mgmt->clockBits[frameIdx], 0);
+}
 
-        frame->isDirty = false; // clear dirty bit
-        DEBUG_PRINT("the frame %d is flushed\n", frameIdx);
-    }
-    else {
-        DEBUG_PRINT("the frame %d is not dirty, do nothing\n", frameIdx);
+/** 
+* @brief the first unpinned frame after the hand whose reference bit is clear.
+*        The first round may only clear bits, the second one finds a frame if any is unpinned.
+* @return int, victim frame index or -1 if every frame is pinned
+*/
+static int clockPickVictim(BM_BufferPool *bm) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    int numPages = bm->numPages;
+
+    // CLOCK：从当前clockHand开始寻找clockBit=0的帧
+    for (int steps = 0; steps < 2 * numPages; steps++) {
+        int currIdx = mgmt->clockHand;
+        // 移动时钟指针（循环）
+        mgmt->clockHand = (mgmt->clockHand + 1) % numPages;
+        // 检查当前帧是否为候选（fixCount=0）
+        if (ATOMIC_LOAD(&mgmt->fixCounts[currIdx]) != 0) continue;
+        if (ATOMIC_LOAD(&mgmt->clockBits[currIdx]) == 0) return currIdx;
+        // 重置引用位，继续寻找
+        ATOMIC_STORE(&mgmt->clockBits[currIdx], 0);
     }
-    return RC_OK;
+    return -1;
 }
 
-/**
- * @brief replace a frame by frame index: flush if dirty, then clear metadata
- * @param bm, input value, a buffer pool structure pointer
- * @param frameIdx, input value, frame index to replace
- * @return RC, return code
- */
-static RC replaceFrame(BM_BufferPool *bm, int frameIdx) {
-    // flush the frame if dirty
-    CHECK(flushFrame(bm, frameIdx));
-
+// the hand meets the frames in order from where it stands, a set bit costs it one more round
+static void clockRank(BM_BufferPool *bm, unsigned long int *heat) {
     BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
-    Frame *frame = &mgmt->frames[frameIdx];
-    if (bm->strategy == RS_LRU_K) {
-        memset(frame->accessTimes, 0, mgmt->k * sizeof(unsigned long int));
-        frame->accessCount = 0;
+    int numPages = bm->numPages;
+    for (int i = 0; i < numPages; i++) {
+        unsigned long int rounds = (ATOMIC_LOAD(&mgmt->clockBits[i]) != 0) ? 1 : 0;
+        heat[i] = rounds * numPages + (i - mgmt->clockHand + numPages) % numPages;
     }
-    // clear metadata (only do this when replacing)
-    frame->pageHandle.pageNum = NO_PAGE;
-    frame->fixCount = 0;
-    frame->refCount = 0;
-    frame->clockBit = 0;
-    memset(frame->pageHandle.data, 0, PAGE_SIZE);
+}
 
-    return RC_OK;
+/*----------------------GCLOCK functions ----------------------*/
+// GCLOCK uses CLOCK's arrays, clockBits hold weighted counts
+static RC gclockInit(BM_BufferPool *bm, void *stratData) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    BM_GCLOCKParams *params = (BM_GCLOCKParams *)stratData;
+    mgmt->gclockLoadWeight = (params != NULL && params->loadWeight > 0) ? params->loadWeight : 1;
+    mgmt->gclockHitWeight = (params != NULL && params->hitWeight > 0) ? params->hitWeight : 1;
+    mgmt->gclockMaxCount = (params != NULL && params->maxCount > 0) ? params->maxCount : GCLOCK_DEFAULT_MAX_COUNT;
+    if (mgmt->gclockMaxCount >= GCLOCK_SPARED) mgmt->gclockMaxCount = GCLOCK_SPARED - 1;
+    if (mgmt->gclockLoadWeight > mgmt->gclockMaxCount) mgmt->gclockLoadWeight = mgmt->gclockMaxCount;
+    return clockInit(bm, NULL);
 }
-/*----------------------functions for manipulating buffer pool ----------------------*/
-/** 
-* @brief create and initialize the buffer pool
+
+// a loaded page starts with loadWeight
+static void gclockOnLoad(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    ATOMIC_STORE(&mgmt->clockBits[frameIdx], mgmt->gclockLoadWeight);
+}
+
+// a hit adds hitWeight and takes back the spare of a dirty frame; hits under a stripe latch may race
+// with each other or with the hand, a lost update only shifts one frame's count
+static void gclockOnHit(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    int count = (ATOMIC_LOAD(&mgmt->clockBits[frameIdx]) & ~GCLOCK_SPARED) + mgmt->gclockHitWeight;
+    ATOMIC_STORE(&mgmt->clockBits[frameIdx], (count < mgmt->gclockMaxCount) ? count : mgmt->gclockMaxCount);
+}
+
+/** 
+* @brief the first unpinned frame after the hand whose count is 0 and that is clean or was already
+*        spared once. Every frame the hand passes loses one count, so within maxCount + 2 rounds
+*        a frame is found if any is unpinned. Sparing a dirty frame wakes the background writer.
+* @return int, victim frame index or -1 if every frame is pinned
+*/
+static int gclockPickVictim(BM_BufferPool *bm) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    int numPages = bm->numPages;
+    int victim = -1;
+    bool spared = false;
+
+    for (int steps = 0; steps < (mgmt->gclockMaxCount + 2) * numPages && victim < 0; steps++) {
+        int currIdx = mgmt->clockHand;
+        mgmt->clockHand = (mgmt->clockHand + 1) % numPages;
+        if (ATOMIC_LOAD(&mgmt->fixCounts[currIdx]) != 0) continue;
+        int value = ATOMIC_LOAD(&mgmt->clockBits[currIdx]);
+        if (value > 0 && value != GCLOCK_SPARED) {
+            ATOMIC_STORE(&mgmt->clockBits[currIdx], value - 1);
+        } else if (value == 0 && ATOMIC_LOAD(&mgmt->frames[currIdx].isDirty)) {
+            // 脏页第一次到0时再放过一轮，干净页优先被替换
+            ATOMIC_STORE(&mgmt->clockBits[currIdx], GCLOCK_SPARED);
+            spared = true;
+        } else {
+            victim = currIdx;
+        }
+    }
+    if (spared && mgmt->cleanerRunning) pthread_cond_signal(&mgmt->cleanerCond);
+    return victim;
+}
+
+// each count is one more round of the hand, a spared dirty frame goes before the clean ones at 0
+static void gclockRank(BM_BufferPool *bm, unsigned long int *heat) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    int numPages = bm->numPages;
+    for (int i = 0; i < numPages; i++) {
+        int value = ATOMIC_LOAD(&mgmt->clockBits[i]);
+        unsigned long int rounds = (value == GCLOCK_SPARED) ? 0 : (unsigned long int)value + 1;
+        heat[i] = rounds * numPages + (i - mgmt->clockHand + numPages) % numPages;
+    }
+}
+
+/*----------------------LRU functions ----------------------*/
+// LRU keeps the unpinned frames in one list
+static RC lruInit(BM_BufferPool *bm, void *stratData) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    (void)stratData;
+    listInit(&mgmt->lruList);
+    return listNodesAlloc(bm);
+}
+
+// pinned and evicted frames are not candidates
+static void lruRemove(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    listUnlink(mgmt, &mgmt->lruList, frameIdx);
+}
+
+// the frame becomes a replacement candidate once nobody uses it
+static void lruOnUnpin(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (mgmt->fixCounts[frameIdx] != 0) return;
+    listUnlink(mgmt, &mgmt->lruList, frameIdx);
+    listPushBack(mgmt, &mgmt->lruList, frameIdx);
+}
+
+// the list only holds unpinned frames, its head is the victim
+static int lruPickVictim(BM_BufferPool *bm) {
+    return ((BM_MgmtData *)bm->mgmtData)->lruList.head;
+}
+
+static void lruRank(BM_BufferPool *bm, unsigned long int *heat) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    unsigned long int next = 1;
+    listRank(mgmt, &mgmt->lruList, heat, &next);
+}
+
+/*----------------------LRU-K functions ----------------------*/
+// ring of the last K uncorrelated reference times of a frame
+static inline unsigned long int *lruKTimesOf(BM_MgmtData *mgmt, int frameIdx) {
+    return &mgmt->lruKTimes[(size_t)frameIdx * mgmt->k];
+}
+
+/** 
+* @brief backward K-distance key of a frame: the time of its K-th most recent
+*        reference, 0 (infinitely far) if it has fewer than K references
+* @param mgmt, input value, a buffer pool metadata structure pointer
+* @param frameIdx, input value, frame index
+* @return unsigned long int, the K-th reference time
+*/
+static inline unsigned long int lruKKthTime(BM_MgmtData *mgmt, int frameIdx) {
+    LRUKFrame *frame = &mgmt->lruKFrames[frameIdx];
+    return (frame->accessCount < mgmt->k) ? 0 : lruKTimesOf(mgmt, frameIdx)[frame->accessHead];
+}
+
+/** 
+* @brief heap order: smaller K-th reference time first, ties broken by the older last reference
+* @return bool, true if frame a should be evicted before frame b
+*/
+static inline bool lruKBefore(BM_MgmtData *mgmt, int a, int b) {
+    unsigned long int ka = lruKKthTime(mgmt, a), kb = lruKKthTime(mgmt, b);
+    if (ka != kb) return ka < kb;
+    return mgmt->lruKFrames[a].lastAccess < mgmt->lruKFrames[b].lastAccess;
+}
+
+// place frameIdx at heap position pos
+static inline void lruKHeapSet(BM_MgmtData *mgmt, int pos, int frameIdx) {
+    mgmt->lruKHeap[pos] = frameIdx;
+    mgmt->lruKFrames[frameIdx].heapPos = pos;
+}
+
+// move the frame at pos towards the root until the heap order holds
+static void lruKSiftUp(BM_MgmtData *mgmt, int pos) {
+    int frameIdx = mgmt->lruKHeap[pos];
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (!lruKBefore(mgmt, frameIdx, mgmt->lruKHeap[parent])) break;
+        lruKHeapSet(mgmt, pos, mgmt->lruKHeap[parent]);
+        pos = parent;
+    }
+    lruKHeapSet(mgmt, pos, frameIdx);
+}
+
+// move the frame at pos towards the leaves until the heap order holds
+static void lruKSiftDown(BM_MgmtData *mgmt, int pos) {
+    int frameIdx = mgmt->lruKHeap[pos];
+    while (1) {
+        int child = 2 * pos + 1;
+        if (child >= mgmt->lruKHeapSize) break;
+        if (child + 1 < mgmt->lruKHeapSize && lruKBefore(mgmt, mgmt->lruKHeap[child + 1], mgmt->lruKHeap[child]))
+            child++;
+        if (!lruKBefore(mgmt, mgmt->lruKHeap[child], frameIdx)) break;
+        lruKHeapSet(mgmt, pos, mgmt->lruKHeap[child]);
+        pos = child;
+    }
+    lruKHeapSet(mgmt, pos, frameIdx);
+}
+
+/** 
+* @brief add an unpinned frame to the victim heap, O(log n)
+*/
+static void lruKHeapPush(BM_MgmtData *mgmt, int frameIdx) {
+    if (mgmt->lruKFrames[frameIdx].heapPos != -1) return; // already a candidate
+    lruKHeapSet(mgmt, mgmt->lruKHeapSize++, frameIdx);
+    lruKSiftUp(mgmt, mgmt->lruKHeapSize - 1);
+}
+
+/** 
+* @brief remove a frame from the victim heap, do nothing if it is not in the heap, O(log n)
+*/
+static void lruKHeapRemove(BM_MgmtData *mgmt, int frameIdx) {
+    int pos = mgmt->lruKFrames[frameIdx].heapPos;
+    if (pos == -1) return;
+    mgmt->lruKFrames[frameIdx].heapPos = -1;
+    if (--mgmt->lruKHeapSize == pos) return; // removed the last element
+    int moved = mgmt->lruKHeap[mgmt->lruKHeapSize];
+    lruKHeapSet(mgmt, pos, moved);
+    lruKSiftUp(mgmt, pos);
+    lruKSiftDown(mgmt, mgmt->lruKFrames[moved].heapPos);
+}
+
+// hash a page number to a history bucket
+static inline int lruKHistoryBucket(BM_MgmtData *mgmt, PageNumber pageNum) {
+    return (int)(((unsigned int)pageNum * 2654435761u) & (unsigned int)mgmt->historyMask);
+}
+
+// unlink history entry idx from its bucket and mark it unused
+static void lruKHistoryDrop(BM_MgmtData *mgmt, int idx) {
+    LRUKHistory *entry = &mgmt->history[idx];
+    if (entry->pageNum == NO_PAGE) return;
+    int *link = &mgmt->historyTable[lruKHistoryBucket(mgmt, entry->pageNum)];
+    while (*link != -1) {
+        if (*link == idx) {
+            *link = entry->hashNext;
+            break;
+        }
+        link = &mgmt->history[*link].hashNext;
+    }
+    entry->pageNum = NO_PAGE;
+    entry->hashNext = -1;
+}
+
+/** 
+* @brief keep the reference history of a page that is being evicted,
+*        the oldest retained history is forgotten when the table is full
+*/
+static void lruKSaveHistory(BM_MgmtData *mgmt, int frameIdx) {
+    LRUKFrame *frame = &mgmt->lruKFrames[frameIdx];
+    if (mgmt->historySize <= 0 || frame->accessCount == 0) return;
+
+    int idx = mgmt->historyNext;
+    mgmt->historyNext = (mgmt->historyNext + 1) % mgmt->historySize;
+    lruKHistoryDrop(mgmt, idx);
+
+    LRUKHistory *entry = &mgmt->history[idx];
+    entry->pageNum = mgmt->frames[frameIdx].pageHandle.pageNum;
+    entry->accessCount = frame->accessCount;
+    entry->accessHead = frame->accessHead;
+    entry->lastAccess = frame->lastAccess;
+    memcpy(&mgmt->historyTimes[(size_t)idx * mgmt->k], lruKTimesOf(mgmt, frameIdx), mgmt->k * sizeof(unsigned long int));
+    int bucket = lruKHistoryBucket(mgmt, entry->pageNum);
+    entry->hashNext = mgmt->historyTable[bucket];
+    mgmt->historyTable[bucket] = idx;
+}
+
+/** 
+* @brief give a freshly loaded frame the retained history of its page, or an empty one
+*/
+static void lruKLoadHistory(BM_MgmtData *mgmt, int frameIdx) {
+    LRUKFrame *frame = &mgmt->lruKFrames[frameIdx];
+    PageNumber pageNum = mgmt->frames[frameIdx].pageHandle.pageNum;
+    frame->accessCount = 0;
+    frame->accessHead = 0;
+    frame->lastAccess = 0;
+
+    for (int idx = (mgmt->historySize > 0) ? mgmt->historyTable[lruKHistoryBucket(mgmt, pageNum)] : -1;
+         idx != -1; idx = mgmt->history[idx].hashNext) {
+        LRUKHistory *entry = &mgmt->history[idx];
+        if (entry->pageNum != pageNum) continue;
+        frame->accessCount = entry->accessCount;
+        frame->accessHead = entry->accessHead;
+        frame->lastAccess = entry->lastAccess;
+        memcpy(lruKTimesOf(mgmt, frameIdx), &mgmt->historyTimes[(size_t)idx * mgmt->k], mgmt->k * sizeof(unsigned long int));
+        lruKHistoryDrop(mgmt, idx);
+        break;
+    }
+}
+
+/** 
+* @brief record a reference (a pin) to a frame. A reference within the correlated
+*        period of the previous one only moves lastAccess, otherwise it is written
+*        to the ring over the oldest entry, O(1)
+* @param bm, input value, a buffer pool structure pointer
+* @param frameIndex, input value, frame index
+* @return RC, return code
+*/
+static RC recordAccess(BM_BufferPool *bm, int frameIndex) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (mgmt == NULL) THROW(RC_UNVALID_HANDLE, "recordAccess: bm->mgmtData == NULL");
+
+    LRUKFrame *frame = &mgmt->lruKFrames[frameIndex];
+    unsigned long int now = ++mgmt->globalTime;
+
+    if (frame->accessCount > 0 && now - frame->lastAccess <= (unsigned long int)mgmt->correlatedPeriod) {
+        frame->lastAccess = now; // correlated reference
+        return RC_OK;
+    }
+    lruKTimesOf(mgmt, frameIndex)[frame->accessHead] = now;
+    frame->accessHead = (frame->accessHead + 1) % mgmt->k;
+    if (frame->accessCount < mgmt->k) frame->accessCount++;
+    frame->lastAccess = now;
+    return RC_OK;
+}
+
+/** 
+* @brief pick the LRU-K victim: the unpinned frame with the largest backward K-distance
+*        whose last reference is outside the correlated period. If every candidate is
+*        inside it, the best of them is used anyway. The heap is left unchanged.
+* @return int, victim frame index or -1 if every frame is pinned
+*/
+static int lruKPickVictim(BM_BufferPool *bm) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    int victim = -1;
+    int numDeferred = 0;
+
+    while (mgmt->lruKHeapSize > 0) {
+        int frameIdx = mgmt->lruKHeap[0];
+        lruKHeapRemove(mgmt, frameIdx);
+        mgmt->lruKDeferred[numDeferred++] = frameIdx;
+        // the pin that needs this victim happens at globalTime + 1
+        if (mgmt->globalTime + 1 - mgmt->lruKFrames[frameIdx].lastAccess > (unsigned long int)mgmt->correlatedPeriod) {
+            victim = frameIdx;
+            break;
+        }
+    }
+    if (victim == -1 && numDeferred > 0) victim = mgmt->lruKDeferred[0];
+
+    // the victim is only taken out of the heap by its eviction
+    for (int i = 0; i < numDeferred; i++) {
+        lruKHeapPush(mgmt, mgmt->lruKDeferred[i]);
+    }
+    return victim;
+}
+
+// make the reference histories of frames [from, to) empty
+static void lruKFramesInit(BM_MgmtData *mgmt, int from, int to) {
+    for (int i = from; i < to; i++) {
+        memset(&mgmt->lruKFrames[i], 0, sizeof(LRUKFrame));
+        mgmt->lruKFrames[i].heapPos = -1;
+    }
+}
+
+// LRU-K keeps K reference times per frame, a victim heap and the histories of evicted pages
+static RC lruKInit(BM_BufferPool *bm, void *stratData) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    BM_LRUKParams *params = (BM_LRUKParams *)stratData;
+    int capacity = mgmt->capacity;
+    mgmt->k = (params && params->k > 0) ? params->k : 2;
+    mgmt->correlatedPeriod = (params && params->correlatedPeriod > 0) ? params->correlatedPeriod : 0;
+    mgmt->historySize = (params && params->historySize != 0) ? params->historySize : bm->numPages;
+    if (mgmt->historySize < 0) mgmt->historySize = 0; // negative turns the history off
+    mgmt->lruKHeapSize = 0;
+    mgmt->historyNext = 0;
+
+    mgmt->lruKFrames = (LRUKFrame *)malloc(capacity * sizeof(LRUKFrame));
+    mgmt->lruKTimes = (unsigned long int *)calloc((size_t)capacity * mgmt->k, sizeof(unsigned long int));
+    mgmt->lruKHeap = (int *)malloc(capacity * sizeof(int));
+    mgmt->lruKDeferred = (int *)malloc(capacity * sizeof(int));
+    if (mgmt->lruKFrames == NULL || mgmt->lruKTimes == NULL || mgmt->lruKHeap == NULL || mgmt->lruKDeferred == NULL) 
+        THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for LRU-K");
+    lruKFramesInit(mgmt, 0, capacity);
+
+    if (mgmt->historySize > 0) {
+        int numHistBuckets = 1;
+        while (numHistBuckets < 2 * mgmt->historySize) numHistBuckets <<= 1;
+        mgmt->history = (LRUKHistory *)malloc(mgmt->historySize * sizeof(LRUKHistory));
+        mgmt->historyTimes = (unsigned long int *)malloc((size_t)mgmt->historySize * mgmt->k * sizeof(unsigned long int));
+        mgmt->historyTable = (int *)malloc(numHistBuckets * sizeof(int));
+        if (mgmt->history == NULL || mgmt->historyTimes == NULL || mgmt->historyTable == NULL) 
+            THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for LRU-K history");
+        memset(mgmt->historyTable, -1, numHistBuckets * sizeof(int));
+        mgmt->historyMask = numHistBuckets - 1;
+        for (int i = 0; i < mgmt->historySize; i++) {
+            mgmt->history[i].pageNum = NO_PAGE;
+            mgmt->history[i].hashNext = -1;
+        }
+    }
+    return RC_OK;
+}
+
+// the reference times of existing frames move with lruKTimes, they are indexed not pointed to
+static RC lruKGrow(BM_BufferPool *bm, int newCapacity) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (!growArray((void **)&mgmt->lruKFrames, sizeof(LRUKFrame), newCapacity) 
+        || !growArray((void **)&mgmt->lruKTimes, (size_t)mgmt->k * sizeof(unsigned long int), newCapacity) 
+        || !growArray((void **)&mgmt->lruKHeap, sizeof(int), newCapacity) 
+        || !growArray((void **)&mgmt->lruKDeferred, sizeof(int), newCapacity)) 
+        THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in resizeBufferPool() for LRU-K");
+    lruKFramesInit(mgmt, mgmt->capacity, newCapacity);
+    return RC_OK;
+}
+
+// 释放LRU-K的访问历史、堆和历史表
+static void lruKRelease(BM_BufferPool *bm) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    POLICY_FREE(mgmt->lruKFrames);
+    POLICY_FREE(mgmt->lruKTimes);
+    POLICY_FREE(mgmt->lruKHeap);
+    POLICY_FREE(mgmt->lruKDeferred);
+    POLICY_FREE(mgmt->history);
+    POLICY_FREE(mgmt->historyTimes);
+    POLICY_FREE(mgmt->historyTable);
+}
+
+// 恢复被换出前的访问历史，再记录本次访问
+static void lruKOnLoad(BM_BufferPool *bm, int frameIdx) {
+    lruKLoadHistory((BM_MgmtData *)bm->mgmtData, frameIdx);
+    recordAccess(bm, frameIdx);
+}
+
+// a pinned frame is not a candidate
+static void lruKOnHit(BM_BufferPool *bm, int frameIdx) {
+    lruKHeapRemove((BM_MgmtData *)bm->mgmtData, frameIdx);
+    recordAccess(bm, frameIdx);
+}
+
+// references are recorded on pin, unpinning only makes the frame a candidate
+static void lruKOnUnpin(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (mgmt->fixCounts[frameIdx] == 0) lruKHeapPush(mgmt, frameIdx);
+}
+
+static void lruKOnEvict(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    lruKHeapRemove(mgmt, frameIdx);
+    lruKSaveHistory(mgmt, frameIdx); // keep the history so a re-reference is not treated as new
+    mgmt->lruKFrames[frameIdx].accessCount = 0;
+}
+
+// frames with K references outlive the others, by their K-th reference time; the others go by their last one
+static void lruKRank(BM_BufferPool *bm, unsigned long int *heat) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    for (int i = 0; i < bm->numPages; i++) {
+        LRUKFrame *frame = &mgmt->lruKFrames[i];
+        heat[i] = (frame->accessCount < mgmt->k) ? frame->lastAccess : mgmt->globalTime + 1 + lruKKthTime(mgmt, i);
+    }
+}
+
+/*----------------------ghost list functions ----------------------*/
+// hash a page number to a ghost bucket
+static inline int ghostBucket(BM_MgmtData *mgmt, PageNumber pageNum) {
+    return (int)(((unsigned int)pageNum * 2654435761u) & (unsigned int)mgmt->ghostMask);
+}
+
+// ghost list (B1, B2 or A1out) of a ghost entry
+static inline FrameList *ghostList(BM_MgmtData *mgmt, int listId) {
+    if (listId == Q2_A1OUT) return &mgmt->q2A1out;
+    return (listId == ARC_B1) ? &mgmt->arcB1 : &mgmt->arcB2;
+}
+
+// resident list (T1, T2, A1in or Am) of a frame
+static inline FrameList *residentList(BM_MgmtData *mgmt, int listId) {
+    switch (listId) {
+        case ARC_T1: return &mgmt->arcT1;
+        case ARC_T2: return &mgmt->arcT2;
+        case Q2_A1IN: return &mgmt->q2A1in;
+        default: return &mgmt->q2Am;
+    }
+}
+
+/** 
+* @brief find the ghost entry of a page
+* @return int, ghost entry index or -1 if the page is not a ghost
+*/
+static int ghostFind(BM_MgmtData *mgmt, PageNumber pageNum) {
+    for (int g = mgmt->ghostTable[ghostBucket(mgmt, pageNum)]; g != -1; g = mgmt->ghosts[g].hashNext) {
+        if (mgmt->ghosts[g].pageNum == pageNum) return g;
+    }
+    return -1;
+}
+
+/** 
+* @brief forget a ghost: unlink it from its list and its bucket and free the entry
+*/
+static void ghostRemove(BM_MgmtData *mgmt, int g) {
+    Ghost *ghost = &mgmt->ghosts[g];
+    FrameList *list = ghostList(mgmt, ghost->listId);
+
+    if (ghost->prev != -1) mgmt->ghosts[ghost->prev].next = ghost->next;
+    else list->head = ghost->next;
+    if (ghost->next != -1) mgmt->ghosts[ghost->next].prev = ghost->prev;
+    else list->tail = ghost->prev;
+    list->size--;
+
+    int *link = &mgmt->ghostTable[ghostBucket(mgmt, ghost->pageNum)];
+    while (*link != -1) {
+        if (*link == g) {
+            *link = ghost->hashNext;
+            break;
+        }
+        link = &mgmt->ghosts[*link].hashNext;
+    }
+    ghost->pageNum = NO_PAGE;
+    mgmt->freeGhosts[mgmt->numFreeGhosts++] = g;
+}
+
+/** 
+* @brief remember an evicted page at the most recent end of B1, B2 or A1out.
+*        When every entry is in use the oldest ghost is forgotten.
+*/
+static void ghostAdd(BM_MgmtData *mgmt, PageNumber pageNum, int listId) {
+    // 2Q: A1out is a FIFO of Kout entries
+    // ARC: |B1| + |B2| <= c holds, pinned frames can bend it so make room if needed
+    if (mgmt->numFreeGhosts == 0) {
+        if (listId == Q2_A1OUT) ghostRemove(mgmt, mgmt->q2A1out.head);
+        else ghostRemove(mgmt, (mgmt->arcB1.size > 0) ? mgmt->arcB1.head : mgmt->arcB2.head);
+    }
+    int g = mgmt->freeGhosts[--mgmt->numFreeGhosts];
+    Ghost *ghost = &mgmt->ghosts[g];
+    FrameList *list = ghostList(mgmt, listId);
+
+    ghost->pageNum = pageNum;
+    ghost->listId = listId;
+    ghost->prev = list->tail;
+    ghost->next = -1;
+    if (list->tail != -1) mgmt->ghosts[list->tail].next = g;
+    else list->head = g;
+    list->tail = g;
+    list->size++;
+
+    int bucket = ghostBucket(mgmt, pageNum);
+    ghost->hashNext = mgmt->ghostTable[bucket];
+    mgmt->ghostTable[bucket] = g;
+}
+
+/** 
+* @brief allocate the ghost directory (ARC, 2Q), hashed like the page table
+* @param mgmt, input value, a buffer pool metadata structure pointer
+* @param numGhosts, input value, number of ghost entries
+* @return RC, return code
+*/
+static RC ghostInit(BM_MgmtData *mgmt, int numGhosts) {
+    int numGhostBuckets = 1;
+    while (numGhostBuckets < 2 * numGhosts) numGhostBuckets <<= 1;
+    mgmt->ghostHit = LIST_NONE;
+    mgmt->ghosts = (Ghost *)malloc(numGhosts * sizeof(Ghost));
+    mgmt->freeGhosts = (int *)malloc(numGhosts * sizeof(int));
+    mgmt->ghostTable = (int *)malloc(numGhostBuckets * sizeof(int));
+    if (mgmt->ghosts == NULL || mgmt->freeGhosts == NULL || mgmt->ghostTable == NULL) 
+        THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for ghost lists");
+    memset(mgmt->ghostTable, -1, numGhostBuckets * sizeof(int));
+    mgmt->ghostMask = numGhostBuckets - 1;
+    for (int i = 0; i < numGhosts; i++) {
+        mgmt->ghosts[i].pageNum = NO_PAGE;
+        mgmt->freeGhosts[i] = i;
+    }
+    mgmt->numFreeGhosts = numGhosts;
+    return RC_OK;
+}
+
+/*----------------------LFU functions ----------------------*/
+/** 
+* @brief create an empty bucket for freq right after bucket prev (-1 puts it at the head)
+* @return int, bucket index
+*/
+static int lfuBucketInsert(BM_MgmtData *mgmt, int prev, int freq) {
+    // at most numPages distinct counts, a free bucket always exists
+    int b = mgmt->lfuFreeBuckets[--mgmt->lfuNumFreeBuckets];
+    LFUBucket *bucket = &mgmt->lfuBuckets[b];
+
+    bucket->freq = freq;
+    listInit(&bucket->frames);
+    bucket->numPinned = 0;
+    bucket->prev = prev;
+    bucket->next = (prev == -1) ? mgmt->lfuHead : mgmt->lfuBuckets[prev].next;
+    if (bucket->next != -1) mgmt->lfuBuckets[bucket->next].prev = b;
+    if (prev == -1) mgmt->lfuHead = b;
+    else mgmt->lfuBuckets[prev].next = b;
+    return b;
+}
+
+// whether a frame is in its bucket's list, a pinned frame only counts in numPinned
+static inline bool lfuListed(BM_MgmtData *mgmt, int frameIdx) {
+    int b = mgmt->lfuFrameBucket[frameIdx];
+    return b != -1 && (mgmt->listNodes[frameIdx].prev != -1 || mgmt->lfuBuckets[b].frames.head == frameIdx);
+}
+
+// take a frame out of its bucket, dropping the bucket once no frame has its count
+static void lfuUnlink(BM_MgmtData *mgmt, int frameIdx) {
+    int b = mgmt->lfuFrameBucket[frameIdx];
+    if (b == -1) return;
+    LFUBucket *bucket = &mgmt->lfuBuckets[b];
+
+    if (lfuListed(mgmt, frameIdx)) listUnlink(mgmt, &bucket->frames, frameIdx);
+    else bucket->numPinned--;
+    mgmt->lfuFrameBucket[frameIdx] = -1;
+    if (bucket->frames.size > 0 || bucket->numPinned > 0) return;
+
+    if (bucket->prev != -1) mgmt->lfuBuckets[bucket->prev].next = bucket->next;
+    else mgmt->lfuHead = bucket->next;
+    if (bucket->next != -1) mgmt->lfuBuckets[bucket->next].prev = bucket->prev;
+    mgmt->lfuFreeBuckets[mgmt->lfuNumFreeBuckets++] = b;
+}
+
+// add a frame (in no bucket) to bucket b, to its list only if the frame is unpinned
+static inline void lfuLink(BM_MgmtData *mgmt, int frameIdx, int b) {
+    if (mgmt->fixCounts[frameIdx] == 0) listPushBack(mgmt, &mgmt->lfuBuckets[b].frames, frameIdx);
+    else mgmt->lfuBuckets[b].numPinned++;
+    mgmt->lfuFrameBucket[frameIdx] = b;
+}
+
+/** 
+* @brief halve every reference count so that pages hot long ago can be evicted.
+*        Halving keeps the buckets in ascending order, a bucket whose new count equals the one
+*        before it is merged into that one behind its frames; pinned frames follow their bucket.
+*        The whole pass is O(numPages).
+*/
+static void lfuAge(BM_MgmtData *mgmt) {
+    int *target = mgmt->lfuScratch;
+    int prev = -1;
+    for (int b = mgmt->lfuHead, next; b != -1; b = next) {
+        LFUBucket *bucket = &mgmt->lfuBuckets[b];
+        next = bucket->next;
+        bucket->freq = (bucket->freq / 2 > 1) ? bucket->freq / 2 : 1;
+        target[b] = b;
+        if (prev == -1 || mgmt->lfuBuckets[prev].freq != bucket->freq) {
+            prev = b;
+            continue;
+        }
+        target[b] = prev;
+        while (bucket->frames.head != -1) {
+            int frameIdx = bucket->frames.head;
+            listUnlink(mgmt, &bucket->frames, frameIdx);
+            listPushBack(mgmt, &mgmt->lfuBuckets[prev].frames, frameIdx);
+        }
+        mgmt->lfuBuckets[prev].numPinned += bucket->numPinned;
+        mgmt->lfuBuckets[prev].next = next;
+        if (next != -1) mgmt->lfuBuckets[next].prev = prev;
+        mgmt->lfuFreeBuckets[mgmt->lfuNumFreeBuckets++] = b;
+    }
+    for (int i = 0; i < mgmt->capacity; i++) {
+        if (mgmt->lfuFrameBucket[i] != -1) mgmt->lfuFrameBucket[i] = target[mgmt->lfuFrameBucket[i]];
+    }
+    mgmt->lfuTicks = 0;
+}
+
+// count one reference towards the aging period
+static inline void lfuTick(BM_MgmtData *mgmt) {
+    if (mgmt->lfuAgingPeriod > 0 && ++mgmt->lfuTicks >= mgmt->lfuAgingPeriod) lfuAge(mgmt);
+}
+
+/** 
+* @brief a newly loaded frame starts with one reference, O(1)
+*/
+static void lfuOnLoad(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    int b = mgmt->lfuHead;
+    if (b == -1 || mgmt->lfuBuckets[b].freq != 1) b = lfuBucketInsert(mgmt, -1, 1);
+    lfuLink(mgmt, frameIdx, b);
+    lfuTick(mgmt);
+}
+
+/** 
+* @brief a hit moves the frame to the bucket of the next count, O(1)
+*/
+static void lfuOnHit(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    int b = mgmt->lfuFrameBucket[frameIdx];
+    int freq = mgmt->lfuBuckets[b].freq + 1;
+    int next = mgmt->lfuBuckets[b].next;
+
+    // the hit pinned the frame, it is no candidate until unpinned
+    if (lfuListed(mgmt, frameIdx)) {
+        listUnlink(mgmt, &mgmt->lfuBuckets[b].frames, frameIdx);
+        mgmt->lfuBuckets[b].numPinned++;
+    }
+    // alone in its bucket and no bucket for freq yet: bump the bucket in place
+    if (mgmt->lfuBuckets[b].frames.size + mgmt->lfuBuckets[b].numPinned == 1 
+        && (next == -1 || mgmt->lfuBuckets[next].freq != freq)) {
+        mgmt->lfuBuckets[b].freq = freq;
+        lfuTick(mgmt);
+        return;
+    }
+    if (next == -1 || mgmt->lfuBuckets[next].freq != freq) next = lfuBucketInsert(mgmt, b, freq);
+    lfuUnlink(mgmt, frameIdx); // may free b, next is already linked past it
+    lfuLink(mgmt, frameIdx, next);
+    lfuTick(mgmt);
+}
+
+// an unpinned frame goes back to its bucket's list, behind the frames already there
+static void lfuOnUnpin(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    int b = mgmt->lfuFrameBucket[frameIdx];
+    if (b == -1 || mgmt->fixCounts[frameIdx] != 0 || lfuListed(mgmt, frameIdx)) return;
+    mgmt->lfuBuckets[b].numPinned--;
+    listPushBack(mgmt, &mgmt->lfuBuckets[b].frames, frameIdx);
+}
+
+/** 
+* @brief the least frequently used unpinned frame, among equal counts the one that reached the count or was
+*        unpinned first: the head of the first bucket with a frame in its list, only buckets whose frames
+*        are all pinned are passed over
+* @return int, victim frame index or -1 if every frame is pinned
+*/
+static int lfuPickVictim(BM_BufferPool *bm) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    for (int b = mgmt->lfuHead; b != -1; b = mgmt->lfuBuckets[b].next) {
+        if (mgmt->lfuBuckets[b].frames.head != -1) return mgmt->lfuBuckets[b].frames.head;
+    }
+    return -1;
+}
+
+// LFU keeps each frame's bucket and the buckets in ascending count order
+static RC lfuInit(BM_BufferPool *bm, void *stratData) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    BM_LFUParams *params = (BM_LFUParams *)stratData;
+    int capacity = mgmt->capacity;
+    mgmt->lfuAgingPeriod = (params && params->agingPeriod != 0) ? params->agingPeriod : 10 * bm->numPages;
+    if (mgmt->lfuAgingPeriod < 0) mgmt->lfuAgingPeriod = 0; // negative turns aging off
+    mgmt->lfuTicks = 0;
+    mgmt->lfuHead = -1;
+
+    mgmt->lfuFrameBucket = (int *)malloc(capacity * sizeof(int));
+    mgmt->lfuBuckets = (LFUBucket *)malloc(capacity * sizeof(LFUBucket));
+    mgmt->lfuFreeBuckets = (int *)malloc(capacity * sizeof(int));
+    mgmt->lfuScratch = (int *)malloc(capacity * sizeof(int));
+    if (mgmt->lfuFrameBucket == NULL || mgmt->lfuBuckets == NULL || mgmt->lfuFreeBuckets == NULL || mgmt->lfuScratch == NULL) 
+        THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for LFU");
+    for (int i = 0; i < capacity; i++) {
+        mgmt->lfuFrameBucket[i] = -1;
+        mgmt->lfuFreeBuckets[i] = i;
+    }
+    mgmt->lfuNumFreeBuckets = capacity;
+    return listNodesAlloc(bm);
+}
+
+// there is at most one bucket per frame, the new ones are free
+static RC lfuGrow(BM_BufferPool *bm, int newCapacity) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (!growArray((void **)&mgmt->lfuFrameBucket, sizeof(int), newCapacity) 
+        || !growArray((void **)&mgmt->lfuBuckets, sizeof(LFUBucket), newCapacity) 
+        || !growArray((void **)&mgmt->lfuFreeBuckets, sizeof(int), newCapacity) 
+        || !growArray((void **)&mgmt->lfuScratch, sizeof(int), newCapacity)) 
+        THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in resizeBufferPool() for LFU");
+    for (int i = mgmt->capacity; i < newCapacity; i++) {
+        mgmt->lfuFrameBucket[i] = -1;
+        mgmt->lfuFreeBuckets[mgmt->lfuNumFreeBuckets++] = i;
+    }
+    return listNodesGrow(bm, newCapacity);
+}
+
+// 释放LFU的频率桶
+static void lfuRelease(BM_BufferPool *bm) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    POLICY_FREE(mgmt->lfuFrameBucket);
+    POLICY_FREE(mgmt->lfuBuckets);
+    POLICY_FREE(mgmt->lfuFreeBuckets);
+    POLICY_FREE(mgmt->lfuScratch);
+    POLICY_FREE(mgmt->listNodes);
+}
+
+// the evicted frame leaves its bucket
+static void lfuOnEvict(BM_BufferPool *bm, int frameIdx) {
+    lfuUnlink((BM_MgmtData *)bm->mgmtData, frameIdx);
+}
+
+// buckets in ascending count order, the oldest frame of a bucket first; pinned frames are in no list
+static void lfuRank(BM_BufferPool *bm, unsigned long int *heat) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    unsigned long int next = 1;
+    for (int b = mgmt->lfuHead; b != -1; b = mgmt->lfuBuckets[b].next) {
+        listRank(mgmt, &mgmt->lfuBuckets[b].frames, heat, &next);
+    }
+}
+
+/*----------------------ARC functions ----------------------*/
+/** 
+* @brief ARC bookkeeping for a page that is about to be loaded (cases II-IV of ARC):
+*        adapt p on a ghost hit, or trim the ghost lists on a full miss
+* @param bm, input value, a buffer pool structure pointer
+* @param pageNum, input value, key of the page being loaded
+*/
+static void arcOnMiss(BM_BufferPool *bm, PageNumber pageNum) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    int c = bm->numPages;
+    int g = ghostFind(mgmt, pageNum);
+    mgmt->ghostHit = LIST_NONE;
+    mgmt->arcNoGhost = false;
+
+    if (g != -1) {
+        int b1 = mgmt->arcB1.size, b2 = mgmt->arcB2.size;
+        mgmt->ghostHit = mgmt->ghosts[g].listId;
+        if (mgmt->ghostHit == ARC_B1) {
+            // recency would have hit, grow T1
+            int delta = (b1 > 0 && b2 / b1 > 1) ? b2 / b1 : 1;
+            mgmt->arcP = (mgmt->arcP + delta < c) ? mgmt->arcP + delta : c;
+        } else {
+            // frequency would have hit, shrink T1
+            int delta = (b2 > 0 && b1 / b2 > 1) ? b1 / b2 : 1;
+            mgmt->arcP = (mgmt->arcP - delta > 0) ? mgmt->arcP - delta : 0;
+        }
+        ghostRemove(mgmt, g);
+        return;
+    }
+
+    if (mgmt->arcT1.size + mgmt->arcB1.size >= c) {
+        if (mgmt->arcT1.size < c) ghostRemove(mgmt, mgmt->arcB1.head);
+        else mgmt->arcNoGhost = true; // B1 is empty, the T1 victim is dropped for good
+    } else if (mgmt->arcT1.size + mgmt->arcT2.size + mgmt->arcB1.size + mgmt->arcB2.size >= 2 * c 
+               && mgmt->arcB2.size > 0) {
+        ghostRemove(mgmt, mgmt->arcB2.head);
+    }
+}
+
+/** 
+* @brief ARC's REPLACE: evict from T1 when it is above its target p, else from T2.
+*        Pinned frames are skipped and the other list is used if the preferred one is all pinned.
+* @return int, victim frame index or -1 if every frame is pinned
+*/
+static int arcPickVictim(BM_BufferPool *bm) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    int t1 = mgmt->arcT1.size;
+    bool fromT1 = t1 > 0 && (t1 > mgmt->arcP || (mgmt->ghostHit == ARC_B2 && t1 == mgmt->arcP));
+    int victim = listLruUnpinned(mgmt, fromT1 ? &mgmt->arcT1 : &mgmt->arcT2);
+    if (victim == -1) victim = listLruUnpinned(mgmt, fromT1 ? &mgmt->arcT2 : &mgmt->arcT1);
+    return victim;
+}
+
+/** 
+* @brief ARC case I: a hit moves the page to the most recent end of T2
+*/
+static void arcOnHit(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    ListNode *node = &mgmt->listNodes[frameIdx];
+    listUnlink(mgmt, residentList(mgmt, node->listId), frameIdx);
+    listPushBack(mgmt, &mgmt->arcT2, frameIdx);
+    node->listId = ARC_T2;
+}
+
+// ARC keeps T1/T2 through the list links and B1/B2 in the ghost directory
+static RC arcInit(BM_BufferPool *bm, void *stratData) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    (void)stratData;
+    listInit(&mgmt->arcT1);
+    listInit(&mgmt->arcT2);
+    listInit(&mgmt->arcB1);
+    listInit(&mgmt->arcB2);
+    mgmt->arcP = 0;
+    mgmt->arcNoGhost = false;
+    CHECK(listNodesAlloc(bm));
+    return ghostInit(mgmt, mgmt->capacity); // at most c ghosts: |B1| + |B2| <= c
+}
+
+// c grows with the pool, so does the ghost directory; the ghost table is rehashed
+static RC arcGrow(BM_BufferPool *bm, int newCapacity) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    int oldCapacity = mgmt->capacity;
+
+    // the ghost table keeps at least two buckets per entry like the page table
+    int numBuckets = 1;
+    while (numBuckets < 2 * newCapacity) numBuckets <<= 1;
+    int *ghostTable = (int *)malloc(numBuckets * sizeof(int));
+    if (ghostTable == NULL 
+        || !growArray((void **)&mgmt->ghosts, sizeof(Ghost), newCapacity) 
+        || !growArray((void **)&mgmt->freeGhosts, sizeof(int), newCapacity)) {
+        free(ghostTable);
+        THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in resizeBufferPool() for ghost lists");
+    }
+    for (int g = oldCapacity; g < newCapacity; g++) {
+        mgmt->ghosts[g].pageNum = NO_PAGE;
+        mgmt->freeGhosts[mgmt->numFreeGhosts++] = g;
+    }
+    free(mgmt->ghostTable);
+    mgmt->ghostTable = ghostTable;
+    mgmt->ghostMask = numBuckets - 1;
+    memset(ghostTable, -1, numBuckets * sizeof(int));
+    for (int g = 0; g < oldCapacity; g++) {
+        if (mgmt->ghosts[g].pageNum == NO_PAGE) continue;
+        int bucket = ghostBucket(mgmt, mgmt->ghosts[g].pageNum);
+        mgmt->ghosts[g].hashNext = ghostTable[bucket];
+        ghostTable[bucket] = g;
+    }
+    return listNodesGrow(bm, newCapacity);
+}
+
+// 释放ARC/2Q的幽灵表
+static void ghostPolicyRelease(BM_BufferPool *bm) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    POLICY_FREE(mgmt->ghosts);
+    POLICY_FREE(mgmt->freeGhosts);
+    POLICY_FREE(mgmt->ghostTable);
+    POLICY_FREE(mgmt->listNodes);
+}
+
+// ARC's bounds for c = newNumPages: |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c
+static void arcResize(BM_BufferPool *bm, int newNumPages) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (mgmt->arcP > newNumPages) mgmt->arcP = newNumPages;
+    while (mgmt->arcT1.size + mgmt->arcB1.size > newNumPages && mgmt->arcB1.size > 0) 
+        ghostRemove(mgmt, mgmt->arcB1.head);
+    while (mgmt->arcT1.size + mgmt->arcT2.size + mgmt->arcB1.size + mgmt->arcB2.size > 2 * newNumPages 
+           && mgmt->arcB2.size > 0) 
+        ghostRemove(mgmt, mgmt->arcB2.head);
+}
+
+// 幽灵命中说明页面被重复访问，进入T2；否则进入T1
+static void arcOnLoad(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    int listId = (mgmt->ghostHit != LIST_NONE) ? ARC_T2 : ARC_T1;
+    listPushBack(mgmt, residentList(mgmt, listId), frameIdx);
+    mgmt->listNodes[frameIdx].listId = listId;
+}
+
+// the evicted page becomes a ghost of the list it was in
+static void arcOnEvict(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    ListNode *node = &mgmt->listNodes[frameIdx];
+    if (node->listId == LIST_NONE) return;
+    listUnlink(mgmt, residentList(mgmt, node->listId), frameIdx);
+    if (!mgmt->arcNoGhost)
+        ghostAdd(mgmt, mgmt->frames[frameIdx].pageHandle.pageNum, (node->listId == ARC_T1) ? ARC_B1 : ARC_B2);
+    mgmt->arcNoGhost = false;
+    node->listId = LIST_NONE;
+}
+
+// pages seen once (T1) before pages seen twice (T2)
+static void arcRank(BM_BufferPool *bm, unsigned long int *heat) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    unsigned long int next = 1;
+    listRank(mgmt, &mgmt->arcT1, heat, &next);
+    listRank(mgmt, &mgmt->arcT2, heat, &next);
+}
+
+/*----------------------2Q functions ----------------------*/
+/** 
+* @brief 2Q's reclaim step: evict from A1in (FIFO) while it is above Kin, else the LRU page of Am.
+*        Pinned frames are skipped and the other queue is used if the preferred one is all pinned.
+* @return int, victim frame index or -1 if every frame is pinned
+*/
+static int q2PickVictim(BM_BufferPool *bm) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    bool fromA1in = mgmt->q2A1in.size > mgmt->q2Kin || mgmt->q2Am.size == 0;
+    int victim = listLruUnpinned(mgmt, fromA1in ? &mgmt->q2A1in : &mgmt->q2Am);
+    if (victim == -1) victim = listLruUnpinned(mgmt, fromA1in ? &mgmt->q2Am : &mgmt->q2A1in);
+    return victim;
+}
+
+/** 
+* @brief 2Q hit: a page in Am moves to its most recent end, a page in A1in stays where it is
+*        (repeated references while in A1in are treated as correlated)
+*/
+static void q2OnHit(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (mgmt->listNodes[frameIdx].listId != Q2_AM) return;
+    listUnlink(mgmt, &mgmt->q2Am, frameIdx);
+    listPushBack(mgmt, &mgmt->q2Am, frameIdx);
+}
+
+// 2Q keeps A1in/Am through the list links and A1out (Kout entries) in the ghost directory
+static RC q2Init(BM_BufferPool *bm, void *stratData) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    BM_2QParams *params = (BM_2QParams *)stratData;
+    listInit(&mgmt->q2A1in);
+    listInit(&mgmt->q2Am);
+    listInit(&mgmt->q2A1out);
+    mgmt->q2KinParam = (params && params->kin > 0) ? params->kin : 0;
+    mgmt->q2Kin = (mgmt->q2KinParam > 0) ? mgmt->q2KinParam : bm->numPages / 4;
+    if (mgmt->q2Kin < 1) mgmt->q2Kin = 1;
+    int numGhosts = (params && params->kout > 0) ? params->kout : bm->numPages / 2;
+    if (numGhosts < 1) numGhosts = 1;
+    CHECK(listNodesAlloc(bm));
+    return ghostInit(mgmt, numGhosts);
+}
+
+// Kin = numPages / 4 follows the pool size unless BM_2QParams.kin fixed it
+static void q2Resize(BM_BufferPool *bm, int newNumPages) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (mgmt->q2KinParam == 0) mgmt->q2Kin = (newNumPages / 4 > 0) ? newNumPages / 4 : 1;
+}
+
+// a page found in A1out was referenced again after its first stay, it goes to Am
+static void q2OnMiss(BM_BufferPool *bm, PageNumber key) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    int g = ghostFind(mgmt, key);
+    mgmt->ghostHit = (g != -1) ? Q2_A1OUT : LIST_NONE;
+    if (g != -1) ghostRemove(mgmt, g);
+}
+
+// A1out命中的页面进入Am；首次访问的页面进入A1in
+static void q2OnLoad(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    int listId = (mgmt->ghostHit == Q2_A1OUT) ? Q2_AM : Q2_A1IN;
+    listPushBack(mgmt, residentList(mgmt, listId), frameIdx);
+    mgmt->listNodes[frameIdx].listId = listId;
+}
+
+// only pages leaving A1in are remembered, pages leaving Am are forgotten
+static void q2OnEvict(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    ListNode *node = &mgmt->listNodes[frameIdx];
+    if (node->listId == LIST_NONE) return;
+    listUnlink(mgmt, residentList(mgmt, node->listId), frameIdx);
+    if (node->listId == Q2_A1IN) ghostAdd(mgmt, mgmt->frames[frameIdx].pageHandle.pageNum, Q2_A1OUT);
+    node->listId = LIST_NONE;
+}
+
+// pages seen once (A1in) before re-referenced pages (Am)
+static void q2Rank(BM_BufferPool *bm, unsigned long int *heat) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    unsigned long int next = 1;
+    listRank(mgmt, &mgmt->q2A1in, heat, &next);
+    listRank(mgmt, &mgmt->q2Am, heat, &next);
+}
+
+/*----------------------replacement policy table ----------------------*/
+// RS_ADAPTIVE hooks, defined after the table they take the live policy from
+static RC adaptiveInit(BM_BufferPool *bm, void *stratData);
+static RC adaptiveGrow(BM_BufferPool *bm, int newCapacity);
+static void adaptiveRelease(BM_BufferPool *bm);
+static void adaptiveResize(BM_BufferPool *bm, int newNumPages);
+static void adaptiveOnMiss(BM_BufferPool *bm, PageNumber key);
+static void adaptiveOnLoad(BM_BufferPool *bm, int frameIdx);
+static void adaptiveOnHit(BM_BufferPool *bm, int frameIdx);
+static void adaptiveOnUnpin(BM_BufferPool *bm, int frameIdx);
+static int adaptivePickVictim(BM_BufferPool *bm);
+static void adaptiveOnEvict(BM_BufferPool *bm, int frameIdx);
+static void adaptiveRank(BM_BufferPool *bm, unsigned long int *heat);
+
+// hooks of each ReplacementStrategy, indexed by it
+static const ReplacementPolicy policies[] = {
+    [RS_FIFO] = { .latchFreeHits = true, .init = fifoInit, .grow = listNodesGrow, .release = listNodesRelease, 
+                  .resize = NULL, .onMiss = NULL, .onLoad = fifoOnLoad, .onHit = noFrameHook, 
+                  .onUnpin = noFrameHook, .pickVictim = fifoPickVictim, .onEvict = fifoOnEvict, .rank = fifoRank },
+    [RS_LRU] = { .latchFreeHits = false, .init = lruInit, .grow = listNodesGrow, .release = listNodesRelease, 
+                 .resize = NULL, .onMiss = NULL, .onLoad = noFrameHook, .onHit = lruRemove, 
+                 .onUnpin = lruOnUnpin, .pickVictim = lruPickVictim, .onEvict = lruRemove, .rank = lruRank },
+    [RS_CLOCK] = { .latchFreeHits = true, .init = clockInit, .grow = clockGrow, .release = clockRelease, 
+                   .resize = clockResize, .onMiss = NULL, .onLoad = clockReference, .onHit = clockReference, 
+                   .onUnpin = clockReference, .pickVictim = clockPickVictim, .onEvict = clockOnEvict, .rank = clockRank },
+    [RS_LFU] = { .latchFreeHits = false, .init = lfuInit, .grow = lfuGrow, .release = lfuRelease, 
+                 .resize = NULL, .onMiss = NULL, .onLoad = lfuOnLoad, .onHit = lfuOnHit, 
+                 .onUnpin = lfuOnUnpin, .pickVictim = lfuPickVictim, .onEvict = lfuOnEvict, .rank = lfuRank },
+    [RS_LRU_K] = { .latchFreeHits = false, .init = lruKInit, .grow = lruKGrow, .release = lruKRelease, 
+                   .resize = NULL, .onMiss = NULL, .onLoad = lruKOnLoad, .onHit = lruKOnHit, 
+                   .onUnpin = lruKOnUnpin, .pickVictim = lruKPickVictim, .onEvict = lruKOnEvict, .rank = lruKRank },
+    [RS_ARC] = { .latchFreeHits = false, .init = arcInit, .grow = arcGrow, .release = ghostPolicyRelease, 
+                 .resize = arcResize, .onMiss = arcOnMiss, .onLoad = arcOnLoad, .onHit = arcOnHit, 
+                 .onUnpin = noFrameHook, .pickVictim = arcPickVictim, .onEvict = arcOnEvict, .rank = arcRank },
+    [RS_2Q] = { .latchFreeHits = false, .init = q2Init, .grow = listNodesGrow, .release = ghostPolicyRelease, 
+                .resize = q2Resize, .onMiss = q2OnMiss, .onLoad = q2OnLoad, .onHit = q2OnHit, 
+                .onUnpin = noFrameHook, .pickVictim = q2PickVictim, .onEvict = q2OnEvict, .rank = q2Rank },
+    // the live policy may change on any pin, so hits always take the pool latch
+    [RS_ADAPTIVE] = { .latchFreeHits = false, .init = adaptiveInit, .grow = adaptiveGrow, .release = adaptiveRelease, 
+                      .resize = adaptiveResize, .onMiss = adaptiveOnMiss, .onLoad = adaptiveOnLoad, 
+                      .onHit = adaptiveOnHit, .onUnpin = adaptiveOnUnpin, .pickVictim = adaptivePickVictim, 
+                      .onEvict = adaptiveOnEvict, .rank = adaptiveRank },
+    [RS_GCLOCK] = { .latchFreeHits = true, .init = gclockInit, .grow = clockGrow, .release = clockRelease, 
+                    .resize = clockResize, .onMiss = NULL, .onLoad = gclockOnLoad, .onHit = gclockOnHit, 
+                    .onUnpin = noFrameHook, .pickVictim = gclockPickVictim, .onEvict = clockOnEvict, .rank = gclockRank },
+};
+#define NUM_POLICIES (int)(sizeof(policies) / sizeof(policies[0]))
+
+/*----------------------adaptive policy functions ----------------------*/
+// policies RS_ADAPTIVE chooses from, the first one runs until the shadows have an opinion
+static const ReplacementStrategy adaptiveCandidates[ADAPTIVE_CANDIDATES] = { RS_LRU, RS_LFU, RS_CLOCK };
+
+// the adaptive state of a pool, NULL unless bm->strategy is RS_ADAPTIVE
+static inline AdaptiveState *adaptiveState(BM_BufferPool *bm) {
+    return ((BM_MgmtData *)bm->mgmtData)->adaptive;
+}
+
+// hash a key to a shadow bucket
+static inline int shadowBucket(ShadowCache *shadow, PageNumber key) {
+    return (int)(((unsigned int)key * 2654435761u) & (unsigned int)shadow->tableMask);
+}
+
+// find the slot holding key, -1 if the shadow does not hold it
+static int shadowFind(ShadowCache *shadow, PageNumber key) {
+    for (int s = shadow->table[shadowBucket(shadow, key)]; s != -1; s = shadow->hashNext[s]) {
+        if (shadow->keys[s] == key) return s;
+    }
+    return -1;
+}
+
+// put the key of slot s into the shadow's hash table
+static void shadowLink(ShadowCache *shadow, int s) {
+    int bucket = shadowBucket(shadow, shadow->keys[s]);
+    shadow->hashNext[s] = shadow->table[bucket];
+    shadow->table[bucket] = s;
+}
+
+// take the key of slot s out of the shadow's hash table
+static void shadowUnlink(ShadowCache *shadow, int s) {
+    int *link = &shadow->table[shadowBucket(shadow, shadow->keys[s])];
+    while (*link != -1) {
+        if (*link == s) {
+            *link = shadow->hashNext[s];
+            break;
+        }
+        link = &shadow->hashNext[*link];
+    }
+}
+
+/** 
+* @brief slot the shadow's policy would evict. The shadows only hold the sampled pages,
+*        a scan of them on a sampled miss stays cheap next to the read the miss costs.
+* @param shadow, input value, a full shadow cache
+* @return int, victim slot
+*/
+static int shadowVictim(ShadowCache *shadow) {
+    if (shadow->strategy == RS_CLOCK) {
+        // every slot is seen at most twice: the first round may only clear bits
+        while (shadow->meta[shadow->hand] != 0) {
+            shadow->meta[shadow->hand] = 0;
+            shadow->hand = (shadow->hand + 1) % shadow->size;
+        }
+        int victim = shadow->hand;
+        shadow->hand = (shadow->hand + 1) % shadow->size;
+        return victim;
+    }
+    // LRU: oldest last access; LFU: lowest count, the older last access among equal counts
+    int victim = 0;
+    for (int s = 1; s < shadow->size; s++) {
+        if (shadow->strategy == RS_LFU && shadow->meta[s] != shadow->meta[victim]) {
+            if (shadow->meta[s] < shadow->meta[victim]) victim = s;
+        } else if (shadow->stamp[s] < shadow->stamp[victim]) {
+            victim = s;
+        }
+    }
+    return victim;
+}
+
+/** 
+* @brief drop slot s, the last slot moves into its place
+*/
+static void shadowRemove(ShadowCache *shadow, int s) {
+    int last = --shadow->size;
+    shadowUnlink(shadow, s);
+    if (s != last) {
+        shadowUnlink(shadow, last);
+        shadow->keys[s] = shadow->keys[last];
+        shadow->meta[s] = shadow->meta[last];
+        shadow->stamp[s] = shadow->stamp[last];
+        shadowLink(shadow, s);
+    }
+    if (shadow->hand >= shadow->size) shadow->hand = 0;
+}
+
+/** 
+* @brief replay one sampled pin on a shadow cache
+* @param state, input value, the adaptive state
+* @param shadow, input value, the shadow cache
+* @param key, input value, the pinned page's key
+*/
+static void shadowAccess(AdaptiveState *state, ShadowCache *shadow, PageNumber key) {
+    int s = shadowFind(shadow, key);
+    if (s != -1) {
+        shadow->hits++;
+        shadow->meta[s] = (shadow->strategy == RS_LFU) ? shadow->meta[s] + 1 : 1;
+    } else {
+        while (shadow->size > state->target) shadowRemove(shadow, shadowVictim(shadow)); // the pool shrank
+        if (shadow->size < state->target) {
+            s = shadow->size++;
+        } else {
+            s = shadowVictim(shadow);
+            shadowUnlink(shadow, s);
+        }
+        shadow->keys[s] = key;
+        shadow->meta[s] = 1;
+        shadowLink(shadow, s);
+    }
+    shadow->stamp[s] = state->clock;
+
+    // LFU ages like the live LFU: every count is halved once per 10 shadow sizes of references
+    if (shadow->strategy == RS_LFU && ++shadow->ticks >= 10 * state->target) {
+        for (int i = 0; i < shadow->size; i++) {
+            shadow->meta[i] = (shadow->meta[i] / 2 > 0) ? shadow->meta[i] / 2 : 1;
+        }
+        shadow->ticks = 0;
+    }
+}
+
+/** 
+* @brief make room for slots shadow slots in every shadow, the keys they hold are kept
+* @param state, input value, the adaptive state
+* @param slots, input value, new number of slots
+* @return RC, return code
+*/
+static RC adaptiveAllocShadows(AdaptiveState *state, int slots) {
+    int numBuckets = 1;
+    while (numBuckets < 2 * slots) numBuckets <<= 1;
+    for (int c = 0; c < ADAPTIVE_CANDIDATES; c++) {
+        ShadowCache *shadow = &state->shadows[c];
+        int *table = (int *)malloc(numBuckets * sizeof(int));
+        if (table == NULL 
+            || !growArray((void **)&shadow->keys, sizeof(PageNumber), slots) 
+            || !growArray((void **)&shadow->meta, sizeof(unsigned long int), slots) 
+            || !growArray((void **)&shadow->stamp, sizeof(unsigned long int), slots) 
+            || !growArray((void **)&shadow->hashNext, sizeof(int), slots)) {
+            free(table);
+            THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed for the adaptive policy's shadow caches");
+        }
+        free(shadow->table);
+        shadow->table = table;
+        shadow->tableMask = numBuckets - 1;
+        memset(table, -1, numBuckets * sizeof(int));
+        for (int s = 0; s < shadow->size; s++) {
+            shadowLink(shadow, s);
+        }
+    }
+    state->slots = slots;
+    return RC_OK;
+}
+
+// shadow size for the pool's frames: a cache of n frames sees about n / sampleRate sampled pages
+static inline int adaptiveTarget(AdaptiveState *state, int numPages) {
+    return (numPages / state->sampleRate > 0) ? numPages / state->sampleRate : 1;
+}
+
+/** 
+* @brief hand the frames to another policy: the old one frees its metadata, the new one starts
+*        with every resident page loaded once, unpinned pages as candidates
+* @param bm, input value, a buffer pool structure pointer
+* @param c, input value, index of the new live policy in adaptiveCandidates
+* @return RC, return code
+*/
+static RC adaptiveSwitch(BM_BufferPool *bm, int c) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    AdaptiveState *state = mgmt->adaptive;
+    const ReplacementPolicy *next = &policies[adaptiveCandidates[c]];
+
+    state->live->release(bm);
+    RC rc = next->init(bm, NULL);
+    if (rc != RC_OK) {
+        // keep a working policy: the one that ran before takes the frames back
+        next->release(bm);
+        next = state->live;
+        CHECK(next->init(bm, NULL));
+        c = state->liveIndex;
+    }
+    state->live = next;
+    state->liveIndex = c;
+    for (int i = 0; i < bm->numPages; i++) {
+        if (mgmt->frames[i].pageHandle.pageNum == NO_PAGE) continue;
+        next->onLoad(bm, i);
+        if (ATOMIC_LOAD(&mgmt->fixCounts[i]) == 0) next->onUnpin(bm, i);
+    }
+    if (rc == RC_OK) STAT_ADD(&mgmt->stats.policySwitches, 1);
+    return rc;
+}
+
+/** 
+* @brief feed a pin to the shadows if its page is sampled, and at the end of an epoch
+*        switch to the candidate whose shadow hit most, if it beat the live one by more than 1%
+* @param bm, input value, a buffer pool structure pointer
+* @param key, input value, the pinned page's key
+*/
+static void adaptiveSample(BM_BufferPool *bm, PageNumber key) {
+    AdaptiveState *state = adaptiveState(bm);
+    // sample by page, not by pin: a sampled page is seen on every one of its pins
+    if (((((unsigned int)key * 2246822519u) >> 16) & (unsigned int)(state->sampleRate - 1)) != 0) return;
+
+    state->clock++;
+    for (int c = 0; c < ADAPTIVE_CANDIDATES; c++) {
+        shadowAccess(state, &state->shadows[c], key);
+    }
+    if (++state->epochAccesses < state->epochLength) return;
+
+    int best = state->liveIndex;
+    for (int c = 0; c < ADAPTIVE_CANDIDATES; c++) {
+        if (state->shadows[c].hits > state->shadows[best].hits) best = c;
+    }
+    if (best != state->liveIndex 
+        && state->shadows[best].hits > state->shadows[state->liveIndex].hits + state->epochLength / 100) {
+        adaptiveSwitch(bm, best);
+    }
+    for (int c = 0; c < ADAPTIVE_CANDIDATES; c++) {
+        state->shadows[c].hits = 0;
+    }
+    state->epochAccesses = 0;
+}
+
+// RS_ADAPTIVE sets up the shadows and starts with the first candidate
+static RC adaptiveInit(BM_BufferPool *bm, void *stratData) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    BM_AdaptiveParams *params = (BM_AdaptiveParams *)stratData;
+    AdaptiveState *state = (AdaptiveState *)calloc(1, sizeof(AdaptiveState));
+    if (state == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for the adaptive policy");
+    mgmt->adaptive = state;
+
+    // by default sample so that a shadow keeps at least ADAPTIVE_MIN_SHADOW pages, at most 1 page in 64
+    int rate = (params && params->sampleRate > 0) ? params->sampleRate : 0;
+    if (rate == 0) {
+        rate = 1;
+        while (rate < ADAPTIVE_MAX_SAMPLE_RATE && bm->numPages / (2 * rate) >= ADAPTIVE_MIN_SHADOW) rate <<= 1;
+    }
+    state->sampleRate = 1;
+    while (state->sampleRate < rate) state->sampleRate <<= 1;
+    state->target = adaptiveTarget(state, bm->numPages);
+    state->epochLength = (params && params->epochLength > 0) ? params->epochLength : 8 * state->target;
+    if (state->epochLength < ADAPTIVE_MIN_EPOCH && (params == NULL || params->epochLength <= 0)) 
+        state->epochLength = ADAPTIVE_MIN_EPOCH;
+    for (int c = 0; c < ADAPTIVE_CANDIDATES; c++) {
+        state->shadows[c].strategy = adaptiveCandidates[c];
+    }
+    CHECK(adaptiveAllocShadows(state, adaptiveTarget(state, mgmt->capacity)));
+
+    state->liveIndex = 0;
+    state->live = &policies[adaptiveCandidates[0]];
+    return state->live->init(bm, NULL);
+}
+
+static RC adaptiveGrow(BM_BufferPool *bm, int newCapacity) {
+    AdaptiveState *state = adaptiveState(bm);
+    CHECK(state->live->grow(bm, newCapacity));
+    if (adaptiveTarget(state, newCapacity) > state->slots) 
+        return adaptiveAllocShadows(state, adaptiveTarget(state, newCapacity));
+    return RC_OK;
+}
+
+// the shadows follow the pool size, shrinking ones drop their victims on the next sampled miss
+static void adaptiveResize(BM_BufferPool *bm, int newNumPages) {
+    AdaptiveState *state = adaptiveState(bm);
+    if (state->live->resize != NULL) state->live->resize(bm, newNumPages);
+    state->target = adaptiveTarget(state, newNumPages);
+}
+
+static void adaptiveRelease(BM_BufferPool *bm) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    AdaptiveState *state = mgmt->adaptive;
+    if (state == NULL) return;
+    state->live->release(bm);
+    for (int c = 0; c < ADAPTIVE_CANDIDATES; c++) {
+        free(state->shadows[c].keys);
+        free(state->shadows[c].meta);
+        free(state->shadows[c].stamp);
+        free(state->shadows[c].hashNext);
+        free(state->shadows[c].table);
+    }
+    free(state);
+    mgmt->adaptive = NULL;
+}
+
+// a miss is sampled before the live policy picks a victim, so a switch never splits a miss
+static void adaptiveOnMiss(BM_BufferPool *bm, PageNumber key) {
+    adaptiveSample(bm, key);
+    AdaptiveState *state = adaptiveState(bm);
+    if (state->live->onMiss != NULL) state->live->onMiss(bm, key);
+}
+
+static void adaptiveOnHit(BM_BufferPool *bm, int frameIdx) {
+    AdaptiveState *state = adaptiveState(bm);
+    state->live->onHit(bm, frameIdx);
+    adaptiveSample(bm, ((BM_MgmtData *)bm->mgmtData)->frames[frameIdx].pageHandle.pageNum);
+}
+
+static void adaptiveOnLoad(BM_BufferPool *bm, int frameIdx) {
+    adaptiveState(bm)->live->onLoad(bm, frameIdx);
+}
+
+static void adaptiveOnUnpin(BM_BufferPool *bm, int frameIdx) {
+    adaptiveState(bm)->live->onUnpin(bm, frameIdx);
+}
+
+static int adaptivePickVictim(BM_BufferPool *bm) {
+    return adaptiveState(bm)->live->pickVictim(bm);
+}
+
+static void adaptiveOnEvict(BM_BufferPool *bm, int frameIdx) {
+    adaptiveState(bm)->live->onEvict(bm, frameIdx);
+}
+
+static void adaptiveRank(BM_BufferPool *bm, unsigned long int *heat) {
+    adaptiveState(bm)->live->rank(bm, heat);
+}
+
+/** 
+* @brief select a victim frame in the buffer pool according to the replacement strategy.
+* @param bm, input value, a buffer pool structure pointer
+* @return int, the index of the victim frame in the buffer pool
+*/
+static int selectReplacementFrame(BM_BufferPool *bm) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (mgmt == NULL) 
+        THROW(RC_UNVALID_HANDLE, "selectReplacementFrame: bm->mgmtData == NULL");
+
+    int victimIndex = mgmt->policy->pickVictim(bm);
+    if (victimIndex == -1) 
+        THROW(RC_UNVALID_HANDLE, "No available victim (all frames are pinned)");
+    return victimIndex;
+}
+
+/** 
+* @brief flush a frame to disk by frame index. A frame latched exclusively by the calling thread is written
+*        under that latch; one latched by another thread is skipped, or reported for forcePage.
+* @param bm, input value, a buffer pool structure pointer
+* @param frameIdx, input value, frame index to flush
+* @param force, input value, true for forcePage: a page another thread latches exclusively is RC_PAGE_LATCHED
+* @return RC, return code
+*/
+static RC  flushFrame(BM_BufferPool *bm, int frameIdx, bool force) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (mgmt == NULL) THROW(RC_UNVALID_HANDLE, "flushFrame: bm->mgmtData == NULL");
+
+    // 添加frameIdx范围检查
+    if (frameIdx < 0 || frameIdx >= bm->numPages) {
+        DEBUG_PRINT("Warning: flushFrame: invalid frame index %d\n", frameIdx);
+        return RC_OK;  // 返回OK避免程序崩溃
+    }
+
+    Frame *frame = &mgmt->frames[frameIdx];
+    if (frame->pageHandle.pageNum == NO_PAGE) 
+        return RC_OK;
+
+    if (ATOMIC_LOAD(&frame->isDirty)) {
+        // write back the dirty frame to pages file
+        DEBUG_PRINT("the frame %d is dirty, write back to pages file\n", frameIdx); // only for debug
+        SM_FileHandle *fh = keyFile(mgmt, frame->pageHandle.pageNum); // 页面所属的文件
+        PageNumber pageNum = keyPage(frame->pageHandle.pageNum);     // 文件内的页号
+
+        // 1. 检查文件句柄是否有效
+        if (fh->mgmtInfo == NULL) {
+            // 文件句柄已无效，无法写回脏页，清除脏位并记录警告
+            DEBUG_PRINT("Warning: Cannot write back dirty frame %d, file handle is invalid\n", frameIdx);
+            frame->isDirty = false;
+            return RC_OK;
+        }
+
+        // 2. 检查pageNum是否有效（非NO_PAGE且非负值，且在合理范围内）
+        if (pageNum < 0 || pageNum >= MAX_FILE_PAGES) {
+            DEBUG_PRINT("Warning: Cannot write back dirty frame %d, invalid pageNum: %d\n", 
+                    frameIdx, pageNum);
+            frame->isDirty = false;
+            return RC_OK;
+        }
+
+        // 3. 检查totalNumPages是否为有效正值且在合理范围内（分区池的其他分区可能正在扩展文件）
+        latchFile(mgmt);
+        int totalNumPages = fh->totalNumPages;
+        unlatchFile(mgmt);
+        if (totalNumPages <= 0 || totalNumPages > MAX_FILE_PAGES) {
+            DEBUG_PRINT("Warning: Cannot write back dirty frame %d, invalid totalNumPages: %d\n", 
+                    frameIdx, totalNumPages);
+            frame->isDirty = false;
+            return RC_OK;
+        }
+
+        // 4. pinNewPage的页面可能还不在文件中，写回前再扩展文件（见下）
+
+        // 5. 检查数据指针是否有效
+        if (frame->pageHandle.data == NULL) {
+            DEBUG_PRINT("Warning: Cannot write back dirty frame %d, data pointer is NULL\n", frameIdx);
+            frame->isDirty = false;
+            return RC_OK;
+        }
+
+        // 6. 检查文件名是否有效
+        if (fh->fileName == NULL) {
+            DEBUG_PRINT("Warning: Cannot write back dirty frame %d, file name is NULL\n", frameIdx);
+            frame->isDirty = false;
+            return RC_OK;
+        }
+
+        // 所有检查通过，可以执行写操作
+        DEBUG_PRINT("Writing page %d to file, frame %d\n", pageNum, frameIdx);
+        DEBUG_PRINT("File handle: fileName=%s, totalNumPages=%d\n", fh->fileName, totalNumPages);
+        DEBUG_PRINT("Data pointer address: %p\n", frame->pageHandle.data);
+
+        // a page being changed under another thread's exclusive latch stays dirty and is written later,
+        // waiting here could deadlock with its writer since we may hold the pool latch
+        bool latched = !ownsFrameLatch(mgmt, frameIdx);
+        if (latched && mgmt->concurrent && pthread_rwlock_tryrdlock(&mgmt->frameLatches[frameIdx]) != 0) {
+            if (force) THROW(RC_PAGE_LATCHED, "Page is latched exclusively by another thread");
+            DEBUG_PRINT("frame %d is latched exclusively, skip writing it\n", frameIdx);
+            return RC_OK;
+        }
+        // clear the dirty bit before writing, a markDirty from another thread during the write keeps the page dirty
+        ATOMIC_STORE(&frame->isDirty, false);
+        // 直接传递frame->pageHandle.data，不需要类型转换
+        latchFile(mgmt);
+        RC rc = RC_OK;
+        if (pageNum >= fh->totalNumPages) {
+            // first flush of a page made by pinNewPage: extend the file once for every new page so far
+            PageNumber newPagesEnd = mgmt->fileOwner->files[keyFileId(frame->pageHandle.pageNum)].newPagesEnd;
+            rc = ensureCapacity((newPagesEnd > pageNum) ? newPagesEnd : pageNum + 1, fh);
+        }
+        if (rc == RC_OK) rc = writeBlock(pageNum, fh, frame->pageHandle.data);
+        unlatchFile(mgmt);
+        if (latched) unlatchFrame(mgmt, frameIdx);
+        if (rc != RC_OK) {
+            // 记录错误但继续执行，而不是退出程序
+            DEBUG_PRINT("Error writing back frame %d: %s\n", frameIdx, errorMessage(rc));
+            ATOMIC_STORE(&frame->isDirty, true);
+            return rc;  // 返回错误代码给调用者
+        }
+        STAT_ADD(&mgmt->stats.writeIO, 1); // only writes that reached the file are counted, like flushBatch
+
+        DEBUG_PRINT("the frame %d is flushed\n", frameIdx);
+    }
+    else {
+        DEBUG_PRINT("the frame %d is not dirty, do nothing\n", frameIdx);
+    }
+    return RC_OK;
+}
+
+// file then page order, runs of neighbouring pages end up next to each other
+static int compareCandidateKeys(const void *a, const void *b) {
+    PageNumber ka = ((const CleanCandidate *)a)->pageNum, kb = ((const CleanCandidate *)b)->pageNum;
+    return (ka > kb) - (ka < kb);
+}
+
+/** 
+* @brief write back all dirty frames, or those of one file, in page order: each run of consecutive
+*        pages of a file goes out as one vectored write. The caller holds the pool latch.
+* @param bm, input value, a buffer pool structure pointer
+* @param fileId, input value, file slot whose pages are written, -1 for all files
+* @return RC, return code of the first failed write, the other runs are still written
+*/
+static RC flushBatch(BM_BufferPool *bm, int fileId) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    CleanCandidate *batch = (CleanCandidate *)malloc(bm->numPages * sizeof(CleanCandidate));
+    SM_PageHandle *pages = (SM_PageHandle *)malloc(bm->numPages * sizeof(SM_PageHandle));
+    if (batch == NULL || pages == NULL) {
+        // no memory for the batch, write the frames one by one
+        free(batch);
+        free(pages);
+        RC result = RC_OK;
+        for (int i = 0; i < bm->numPages; i++) {
+            PageNumber key = mgmt->frames[i].pageHandle.pageNum;
+            if (key == NO_PAGE || (fileId >= 0 && keyFileId(key) != fileId)) continue;
+            RC rc = flushFrame(bm, i, false);
+            if (rc != RC_OK && result == RC_OK) result = rc;
+        }
+        return result;
+    }
+
+    int n = 0;
+    for (int i = 0; i < bm->numPages; i++) {
+        Frame *frame = &mgmt->frames[i];
+        PageNumber key = frame->pageHandle.pageNum;
+        if (key == NO_PAGE || !ATOMIC_LOAD(&frame->isDirty)) continue;
+        if (fileId >= 0 && keyFileId(key) != fileId) continue;
+        if (keyFile(mgmt, key)->mgmtInfo == NULL) {
+            ATOMIC_STORE(&frame->isDirty, false); // 文件已关闭，和flushFrame一样丢弃
+            continue;
+        }
+        // same as flushFrame: a page under an exclusive latch is being changed and is written later
+        if (mgmt->concurrent && pthread_rwlock_tryrdlock(&mgmt->frameLatches[i]) != 0) continue;
+        ATOMIC_STORE(&frame->isDirty, false);
+        batch[n].pageNum = key;
+        batch[n].frameIdx = i;
+        n++;
+    }
+    qsort(batch, n, sizeof(CleanCandidate), compareCandidateKeys);
+
+    RC result = RC_OK;
+    for (int start = 0, end; start < n; start = end) {
+        PageNumber firstKey = batch[start].pageNum;
+        for (end = start + 1; end < n && batch[end].pageNum == firstKey + (end - start) 
+             && keyFileId(batch[end].pageNum) == keyFileId(firstKey); end++) 
+            ;
+        for (int j = start; j < end; j++) {
+            pages[j - start] = mgmt->frames[batch[j].frameIdx].pageHandle.data;
+        }
+
+        SM_FileHandle *fh = keyFile(mgmt, firstKey);
+        PageNumber firstPage = keyPage(firstKey), lastPage = firstPage + (end - start) - 1;
+        RC rc = RC_OK;
+        latchFile(mgmt);
+        if (lastPage >= fh->totalNumPages) {
+            // pages made by pinNewPage: extend the file once for every new page so far
+            PageNumber newPagesEnd = mgmt->fileOwner->files[keyFileId(firstKey)].newPagesEnd;
+            rc = ensureCapacity((newPagesEnd > lastPage) ? newPagesEnd : lastPage + 1, fh);
+        }
+        if (rc == RC_OK) rc = writeBlocks(firstPage, end - start, fh, pages);
+        unlatchFile(mgmt);
+
+        if (rc == RC_OK) {
+            STAT_ADD(&mgmt->stats.writeIO, end - start);
+        } else {
+            DEBUG_PRINT("Error writing back pages %d-%d: %s\n", firstPage, lastPage, errorMessage(rc));
+            for (int j = start; j < end; j++) {
+                ATOMIC_STORE(&mgmt->frames[batch[j].frameIdx].isDirty, true);
+            }
+            if (result == RC_OK) result = rc;
+        }
+    }
+    for (int j = 0; j < n; j++) {
+        unlatchFrame(mgmt, batch[j].frameIdx);
+    }
+
+    free(batch);
+    free(pages);
+    return result;
+}
+
+/** 
+* @brief take an unpinned victim out of the page table so that no new pin can reach it.
+*        In concurrent mode a FIFO/CLOCK hit may pin the victim between selection and this call,
+*        the fix count is checked again under the stripe latch that hits take.
+* @param mgmt, input value, a buffer pool metadata structure pointer
+* @param frameIdx, input value, victim frame index
+* @return bool, true if the victim was detached, false if it got pinned meanwhile
+*/
+static bool detachVictim(BM_MgmtData *mgmt, int frameIdx) {
+    PageNumber pageNum = mgmt->frames[frameIdx].pageHandle.pageNum;
+    latchStripe(mgmt, pageNum);
+    bool unpinned = ATOMIC_LOAD(&mgmt->fixCounts[frameIdx]) == 0;
+    if (unpinned) pageTableRemove(mgmt, frameIdx);
+    unlatchStripe(mgmt, pageNum);
+    return unpinned;
+}
+
+/**
+ * @brief replace a frame by frame index: flush if dirty, then clear metadata.
+ *        The frame must already be detached from the page table (detachVictim).
+ * @param bm, input value, a buffer pool structure pointer
+ * @param frameIdx, input value, frame index to replace
+ * @return RC, return code
+ */
+static RC replaceFrame(BM_BufferPool *bm, int frameIdx) {
+    // flush the frame if dirty
+    CHECK(flushFrame(bm, frameIdx, false));
+
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    Frame *frame = &mgmt->frames[frameIdx];
+    mgmt->policy->onEvict(bm, frameIdx); // the policy still sees the page's key
+    // clear metadata (only do this when replacing)
+    frame->pageHandle.pageNum = NO_PAGE;
+    mgmt->fixCounts[frameIdx] = 0;
+    frame->ioState = IO_NONE; // a failed read does not follow the frame to its next page
+    // the data is left as is, the next page read into the frame overwrites all of it
+
+    return RC_OK;
+}
+/*----------------------background writer functions ----------------------*/
+// older dirty pages first
+static int compareCleanCandidates(const void *a, const void *b) {
+    unsigned long int ta = ((const CleanCandidate *)a)->dirtyTime, tb = ((const CleanCandidate *)b)->dirtyTime;
+    return (ta > tb) - (ta < tb);
+}
+
+/** 
+* @brief one pass of the background writer: if more than cleanerDirtyPercent of the unpinned frames
+*        are dirty, write the oldest dirty ones until the share is back under it.
+*        Called with the pool latch held; the latch is dropped between writes so misses are not held up.
+* @param bm, input value, a buffer pool structure pointer
+*/
+static void cleanerPass(BM_BufferPool *bm) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    CleanCandidate *cands = mgmt->cleanerScratch;
+    int numUnpinned = 0, numDirty = 0;
+
+    for (int i = 0; i < bm->numPages; i++) {
+        Frame *frame = &mgmt->frames[i];
+        if (frame->pageHandle.pageNum == NO_PAGE || ATOMIC_LOAD(&mgmt->fixCounts[i]) != 0) continue;
+        numUnpinned++;
+        if (ATOMIC_LOAD(&frame->isDirty)) {
+            cands[numDirty].dirtyTime = frame->dirtyTime;
+            cands[numDirty].pageNum = frame->pageHandle.pageNum;
+            cands[numDirty].frameIdx = i;
+            numDirty++;
+        }
+    }
+
+    int allowed = numUnpinned * mgmt->cleanerDirtyPercent / 100;
+    if (numDirty <= allowed) return;
+    qsort(cands, numDirty, sizeof(CleanCandidate), compareCleanCandidates);
+
+    for (int j = 0; j < numDirty - allowed && !mgmt->cleanerStop; j++) {
+        Frame *frame = &mgmt->frames[cands[j].frameIdx];
+        // the frame may have been replaced, pinned or resized away while the latch was dropped
+        if (cands[j].frameIdx < bm->numPages && frame->pageHandle.pageNum == cands[j].pageNum 
+            && ATOMIC_LOAD(&mgmt->fixCounts[cands[j].frameIdx]) == 0) {
+            flushFrame(bm, cands[j].frameIdx, false);
+        }
+        unlatchPool(mgmt);
+        latchPool(mgmt);
+    }
+}
+
+/** 
+* @brief background writer thread, wakes every cleanerIntervalMs or when a miss had to write a dirty victim
+* @param arg, input value, the buffer pool
+*/
+static void *cleanerMain(void *arg) {
+    BM_BufferPool *bm = (BM_BufferPool *)arg;
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+
+    latchPool(mgmt);
+    while (!mgmt->cleanerStop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += mgmt->cleanerIntervalMs / 1000;
+        deadline.tv_nsec += (long)(mgmt->cleanerIntervalMs % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&mgmt->cleanerCond, &mgmt->poolLatch, &deadline);
+        if (!mgmt->cleanerStop) cleanerPass(bm);
+    }
+    unlatchPool(mgmt);
+    return NULL;
+}
+
+/*----------------------frame allocation functions ----------------------*/
+/** 
+* @brief set up the metadata of a frame that holds no page yet
+* @param mgmt, input value, a buffer pool metadata structure pointer
+* @param frameIdx, input value, frame index
+*/
+static void initFrame(BM_MgmtData *mgmt, int frameIdx) {
+    Frame *frame = &mgmt->frames[frameIdx];
+    char *data = frame->pageHandle.data;
+
+    memset(frame, 0, sizeof(Frame));
+    mgmt->fixCounts[frameIdx] = 0;
+    frame->hashNext = -1;
+    frame->ioState = IO_NONE;
+    frame->pageHandle.pageNum = NO_PAGE; // indicate frame is free
+    frame->pageHandle.data = data;       // set by addArenaSegment
+}
+
+/** 
+* @brief give frames [arenaFrames, endFrame) their page data, one page aligned block for all of them
+* @param mgmt, input value, a buffer pool metadata structure pointer
+* @param endFrame, input value, one past the last frame that needs data
+* @return RC, return code
+*/
+static RC addArenaSegment(BM_MgmtData *mgmt, int endFrame) {
+    int count = endFrame - mgmt->arenaFrames;
+    if (count <= 0) return RC_OK;
+
+    ArenaSegment *arenas = (ArenaSegment *)realloc(mgmt->arenas, (mgmt->numArenas + 1) * sizeof(ArenaSegment));
+    if (arenas == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed for frame data");
+    mgmt->arenas = arenas;
+    char *base;
+    if (posix_memalign((void **)&base, PAGE_SIZE, (size_t)count * PAGE_SIZE) != 0) 
+        THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed for frame data");
+
+    ArenaSegment *seg = &mgmt->arenas[mgmt->numArenas++];
+    seg->base = base;
+    seg->firstFrame = mgmt->arenaFrames;
+    seg->numFrames = count;
+    for (int i = 0; i < count; i++) {
+        mgmt->frames[seg->firstFrame + i].pageHandle.data = base + (size_t)i * PAGE_SIZE; // frame's slot in the block
+    }
+    mgmt->arenaFrames = endFrame;
+    return RC_OK;
+}
+
+/** 
+* @brief free the data blocks that lie entirely past endFrame. A block that straddles endFrame is kept,
+*        the next growth reuses its tail.
+* @param mgmt, input value, a buffer pool metadata structure pointer
+* @param endFrame, input value, one past the last frame that keeps its data
+*/
+static void trimArenaSegments(BM_MgmtData *mgmt, int endFrame) {
+    while (mgmt->numArenas > 0 && mgmt->arenas[mgmt->numArenas - 1].firstFrame >= endFrame) {
+        ArenaSegment *seg = &mgmt->arenas[--mgmt->numArenas];
+        for (int i = 0; i < seg->numFrames; i++) {
+            mgmt->frames[seg->firstFrame + i].pageHandle.data = NULL;
+        }
+        free(seg->base);
+        mgmt->arenaFrames = seg->firstFrame;
+    }
+}
+
+/*----------------------warm restart functions ----------------------*/
+// hotter pages first, then by page number
+static int compareWarmHeat(const void *a, const void *b) {
+    const WarmPage *wa = (const WarmPage *)a, *wb = (const WarmPage *)b;
+    if (wa->heat != wb->heat) return (wa->heat < wb->heat) - (wa->heat > wb->heat);
+    return (wa->pageNum > wb->pageNum) - (wa->pageNum < wb->pageNum);
+}
+
+// lower ranks first, then by page number
+static int compareWarmRank(const void *a, const void *b) {
+    const WarmPage *wa = (const WarmPage *)a, *wb = (const WarmPage *)b;
+    if (wa->rank != wb->rank) return (wa->rank > wb->rank) - (wa->rank < wb->rank);
+    return (wa->pageNum > wb->pageNum) - (wa->pageNum < wb->pageNum);
+}
+
+static int compareWarmPage(const void *a, const void *b) {
+    PageNumber pa = ((const WarmPage *)a)->pageNum, pb = ((const WarmPage *)b)->pageNum;
+    return (pa > pb) - (pa < pb);
+}
+
+// name of the warm restart file of a page file, pairs of ints (page number, rank); freed by the caller
+static char *warmFileName(const char *pageFile) {
+    char *name = (char *)malloc(strlen(pageFile) + strlen(WARM_FILE_SUFFIX) + 1);
+    if (name != NULL) sprintf(name, "%s%s", pageFile, WARM_FILE_SUFFIX);
+    return name;
+}
+
+/** 
+* @brief list the resident pages of one file in a pool, ranked by the pool's policy. Pinned pages rank
+*        first, they are in use right now. The caller holds the pool latch.
+* @param bm, input value, a buffer pool structure pointer, not partitioned
+* @param fileId, input value, file slot whose pages are listed
+* @param pages, output value, room for bm->numPages pages, hottest first with rank 0, 1, ...
+* @return int, number of pages listed
+*/
+static int warmCollect(BM_BufferPool *bm, int fileId, WarmPage *pages) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    unsigned long int *heat = (unsigned long int *)calloc(bm->numPages, sizeof(unsigned long int));
+    if (heat == NULL) return 0;
+
+    mgmt->policy->rank(bm, heat);
+    int n = 0;
+    for (int i = 0; i < bm->numPages; i++) {
+        PageNumber key = mgmt->frames[i].pageHandle.pageNum;
+        if (key == NO_PAGE || keyFileId(key) != fileId) continue;
+        pages[n].pageNum = keyPage(key);
+        pages[n].frameIdx = i;
+        pages[n].heat = (ATOMIC_LOAD(&mgmt->fixCounts[i]) != 0) ? ULONG_MAX : heat[i];
+        n++;
+    }
+    free(heat);
+    if (n > 1) qsort(pages, n, sizeof(WarmPage), compareWarmHeat);
+    for (int i = 0; i < n; i++) {
+        pages[i].rank = i;
+    }
+    return n;
+}
+
+/** 
+* @brief write the resident pages of a handle's file with their ranks to the file's warm restart file.
+*        A partitioned pool merges the rankings of its partitions by rank.
+* @param bm, input value, a buffer pool structure pointer
+* @param pageFile, input value, name of the handle's page file
+* @return RC, return code
+*/
+static RC warmSave(BM_BufferPool *bm, const char *pageFile) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (!mgmt->warmRestart || pageFile == NULL) return RC_OK;
+
+    int numPools = (mgmt->partitions != NULL) ? mgmt->numPartitions : 1;
+    WarmPage *pages = (WarmPage *)malloc((bm->numPages + 1) * sizeof(WarmPage));
+    char *name = warmFileName(pageFile);
+    if (pages == NULL || name == NULL) {
+        free(pages);
+        free(name);
+        THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed for the warm restart file");
+    }
+    int n = 0;
+    for (int p = 0; p < numPools; p++) {
+        BM_BufferPool *pool = (mgmt->partitions != NULL) ? &mgmt->partitions[p] : bm;
+        latchPool((BM_MgmtData *)pool->mgmtData);
+        n += warmCollect(pool, bm->fileId, pages + n);
+        unlatchPool((BM_MgmtData *)pool->mgmtData);
+    }
+    if (numPools > 1 && n > 1) qsort(pages, n, sizeof(WarmPage), compareWarmRank);
+
+    RC rc = RC_OK;
+    FILE *fp = fopen(name, "wb");
+    for (int i = 0; i < n && fp != NULL && rc == RC_OK; i++) {
+        int record[2] = { pages[i].pageNum, pages[i].rank };
+        if (fwrite(record, sizeof(int), 2, fp) != 2) rc = RC_WRITE_FAILED;
+    }
+    if (fp == NULL || fclose(fp) != 0) rc = RC_WRITE_FAILED;
+    free(pages);
+    free(name);
+    if (rc != RC_OK) THROW(rc, "Failed to write the warm restart file");
+    return RC_OK;
+}
+
+/** 
+* @brief read the warm restart file of a page file
+* @param pageFile, input value, name of the page file
+* @param pages, output value, the saved pages by rank, NULL if there are none; freed by the caller
+* @return int, number of saved pages
+*/
+static int warmRead(const char *pageFile, WarmPage **pages) {
+    char *name = warmFileName(pageFile);
+    FILE *fp = (name != NULL) ? fopen(name, "rb") : NULL;
+    free(name);
+    *pages = NULL;
+    if (fp == NULL) return 0;
+
+    fseek(fp, 0L, SEEK_END);
+    int n = (int)(ftell(fp) / (2 * sizeof(int)));
+    fseek(fp, 0L, SEEK_SET);
+    *pages = (WarmPage *)malloc((n + 1) * sizeof(WarmPage));
+    if (*pages == NULL) n = 0;
+    for (int i = 0; i < n; i++) {
+        int record[2];
+        if (fread(record, sizeof(int), 2, fp) != 2) {
+            n = i;
+            break;
+        }
+        (*pages)[i].pageNum = record[0];
+        (*pages)[i].rank = record[1];
+        (*pages)[i].frameIdx = -1;
+        (*pages)[i].heat = 0;
+    }
+    fclose(fp);
+    if (n > 1) qsort(*pages, n, sizeof(WarmPage), compareWarmRank);
+    return n;
+}
+
+/** 
+* @brief load the hottest saved pages that fit in the free frames of a pool, no page is evicted for them.
+*        The frames are taken off the free stack under the pool latch, each run of consecutive pages is read
+*        with one readBlocks without it, then the pages are handed to the policy coldest first under the latch
+*        again, so that recency based policies end up in the saved order. The pages come in unpinned and clean,
+*        pages that are already resident, loaded by a pin during the reads, or past the end of the file are skipped.
+* @param bm, input value, a buffer pool structure pointer, not partitioned
+* @param pages, input value, saved pages of the handle's file by rank, reordered by the call
+* @param numWarm, input value, number of saved pages
+* @return int, number of pages loaded
+*/
+static int warmLoad(BM_BufferPool *bm, WarmPage *pages, int numWarm) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    SM_FileHandle *fh = keyFile(mgmt, pageKey(bm, 0));
+    int n = 0, loaded = 0;
+
+    latchPool(mgmt);
+    latchFile(mgmt);
+    int totalNumPages = (fh->mgmtInfo != NULL) ? fh->totalNumPages : 0;
+    unlatchFile(mgmt);
+    // the hottest pages while free frames last
+    for (int i = 0; i < numWarm && n < mgmt->numFreeFrames; i++) {
+        if (pages[i].pageNum < 0 || pages[i].pageNum >= totalNumPages) continue;
+        PageNumber key = pageKey(bm, pages[i].pageNum);
+        latchStripe(mgmt, key);
+        int frameIdx = getFrameIndex(bm, key);
+        unlatchStripe(mgmt, key);
+        if (frameIdx < 0) pages[n++] = pages[i];
+    }
+    SM_PageHandle *data = (SM_PageHandle *)malloc((n + 1) * sizeof(SM_PageHandle));
+    if (data == NULL) n = 0;
+
+    // in page order, a page listed twice is loaded once
+    if (n > 1) qsort(pages, n, sizeof(WarmPage), compareWarmPage);
+    int m = 0;
+    for (int i = 0; i < n; i++) {
+        if (m > 0 && pages[m - 1].pageNum == pages[i].pageNum) continue;
+        pages[m] = pages[i];
+        pages[m].frameIdx = findFreeFrame(bm);
+        data[m] = mgmt->frames[pages[m].frameIdx].pageHandle.data;
+        m++;
+    }
+    n = m;
+    // the frames are off the free stack and not reachable until published, the reads run without the pool latch
+    unlatchPool(mgmt);
+    for (int first = 0, last; first < n; first = last) {
+        for (last = first + 1; last < n && pages[last].pageNum == pages[last - 1].pageNum + 1; last++) ;
+        latchFile(mgmt);
+        RC rc = readBlocks(pages[first].pageNum, last - first, fh, &data[first]);
+        unlatchFile(mgmt);
+        if (rc == RC_OK) STAT_ADD(&mgmt->stats.readIO, last - first);
+        for (int i = first; i < last && rc != RC_OK; i++) data[i] = NULL;
+    }
+    latchPool(mgmt);
+    for (int i = 0; i < n; i++) {
+        // a pin may have loaded the page meanwhile, a shrink may have dropped the frame
+        PageNumber key = pageKey(bm, pages[i].pageNum);
+        latchStripe(mgmt, key);
+        bool resident = (getFrameIndex(bm, key) >= 0);
+        unlatchStripe(mgmt, key);
+        if (pages[i].frameIdx >= bm->numPages) pages[i].frameIdx = -1;
+        else if (data[i] == NULL || resident) {
+            releaseFreeFrame(mgmt, pages[i].frameIdx); // 帧仍为空，放回空闲栈
+            pages[i].frameIdx = -1;
+        }
+    }
+    free(data);
+
+    // coldest first, each page goes through a miss and an unpin like a pin would
+    if (n > 1) qsort(pages, n, sizeof(WarmPage), compareWarmRank);
+    for (int i = n - 1; i >= 0; i--) {
+        int frameIdx = pages[i].frameIdx;
+        if (frameIdx < 0) continue;
+        PageNumber key = pageKey(bm, pages[i].pageNum);
+        Frame *frame = &mgmt->frames[frameIdx];
+        if (mgmt->policy->onMiss != NULL) mgmt->policy->onMiss(bm, key);
+        frame->pageHandle.pageNum = key;
+        frame->isDirty = false;
+        mgmt->fixCounts[frameIdx] = 1;
+        latchStripe(mgmt, key);
+        pageTableInsert(mgmt, frameIdx);
+        unlatchStripe(mgmt, key);
+        mgmt->policy->onLoad(bm, frameIdx);
+        latchStripe(mgmt, key);
+        fixCountAdd(mgmt, frameIdx, -1);
+        mgmt->policy->onUnpin(bm, frameIdx);
+        unlatchStripe(mgmt, key);
+        loaded++;
+    }
+    unlatchPool(mgmt);
+    return loaded;
+}
+
+/** 
+* @brief preload the hot page set a handle's file had when it was last shut down, if the pool
+*        has warm restart on. A partitioned pool gives each partition the pages hashed to it.
+* @param bm, input value, a buffer pool structure pointer
+* @return int, number of pages loaded
+*/
+static int warmPreload(BM_BufferPool *bm) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (!mgmt->warmRestart || bm->pageFile == NULL) return 0;
+
+    WarmPage *pages;
+    int n = warmRead(bm->pageFile, &pages), loaded = 0;
+    if (mgmt->partitions == NULL) {
+        loaded = warmLoad(bm, pages, n);
+    } else {
+        WarmPage *part = (WarmPage *)malloc((n + 1) * sizeof(WarmPage));
+        for (int p = 0; p < mgmt->numPartitions && part != NULL; p++) {
+            int m = 0;
+            for (int i = 0; i < n; i++) {
+                if (partitionOf(mgmt, pages[i].pageNum) == &mgmt->partitions[p]) part[m++] = pages[i];
+            }
+            loaded += warmLoad(&mgmt->partitions[p], part, m);
+        }
+        free(part);
+    }
+    free(pages);
+    return loaded;
+}
+
+/*----------------------partitioned pool functions ----------------------*/
+static RC initPool(BM_BufferPool *bm, const char *pageFileName, int numPages, ReplacementStrategy strategy, 
+                   void *stratData, const BM_PoolOptions *options, BM_MgmtData *fileOwner);
+
+// frames of partition p when total frames are split between n partitions, the first ones get the remainder
+static inline int partitionShare(int total, int n, int p) {
+    return total / n + (p < total % n);
+}
+
+/** 
+* @brief create a partitioned pool: numPartitions concurrent sub-pools with their share of the frames each.
+*        Partition 0 opens the page file, the others read and write it through its handle and file latch.
+*        The pool's own metadata only routes calls, and detects read-ahead over the whole file since
+*        consecutive pages are hashed to different partitions.
+* @param bm, input value, a buffer pool structure pointer
+* @param pageFileName, input value, page file name
+* @param numPages, input value, number of pages in the buffer pool, at least one per partition
+* @param strategy, input value, replacement strategy of every partition
+* @param stratData, input value, strategy data of every partition
+* @param options, input value, pool options with numPartitions > 1
+* @return RC, return code
+*/
+static RC initPartitions(BM_BufferPool *bm, const char *pageFileName, int numPages, ReplacementStrategy strategy, 
+                         void *stratData, const BM_PoolOptions *options) {
+    int n = options->numPartitions;
+    if (numPages < n) THROW(RC_INVALID_PARAMS, "A partitioned buffer pool needs a frame per partition at least");
+
+    BM_MgmtData *mgmt = (BM_MgmtData *)calloc(1, sizeof(BM_MgmtData));
+    BM_BufferPool *partitions = (BM_BufferPool *)calloc(n, sizeof(BM_BufferPool));
+    char *name = (pageFileName != NULL) ? (char *)malloc(strlen(pageFileName) + 1) : NULL;
+    if (mgmt == NULL || partitions == NULL || (pageFileName != NULL && name == NULL)) {
+        free(mgmt);
+        free(partitions);
+        free(name);
+        THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for partitions");
+    }
+    if (name != NULL) strcpy(name, pageFileName);
+
+    BM_PoolOptions partOptions = *options;
+    partOptions.concurrent = true;
+    partOptions.numPartitions = 0;
+    partOptions.readAheadPages = 0; // detected here, a partition only sees every n-th page of a sequential run
+    partOptions.warmRestart = false; // the hot page set of the whole file is saved and split here
+    // a full partition may hold only the caller's own pins while the other partitions have free frames,
+    // an endless wait could never end, so it is capped
+    if (partOptions.pinWaitMs == PIN_WAIT_FOREVER) partOptions.pinWaitMs = DEFAULT_PIN_WAIT_MS;
+    int maxPages = (options->maxPages > numPages) ? options->maxPages : numPages;
+    for (int p = 0; p < n; p++) {
+        partOptions.maxPages = (maxPages + n - 1) / n; // any split of up to maxPages frames fits
+        BM_MgmtData *fileOwner = (p == 0) ? NULL : (BM_MgmtData *)partitions[0].mgmtData;
+        RC rc = initPool(&partitions[p], (p == 0) ? pageFileName : NULL, partitionShare(numPages, n, p), 
+                         strategy, stratData, &partOptions, fileOwner);
+        if (rc != RC_OK) {
+            while (--p >= 0) shutdownBufferPool(&partitions[p]);
+            free(mgmt);
+            free(partitions);
+            free(name);
+            return rc;
+        }
+    }
+
+    mgmt->partitions = partitions;
+    mgmt->numPartitions = n;
+    mgmt->fileOwner = mgmt;
+    mgmt->concurrent = true;
+    pthread_mutex_init(&mgmt->prefetchLatch, NULL);
+    mgmt->readAheadPages = (options->readAheadPages > 0) ? options->readAheadPages : 0;
+    mgmt->seqLast = NO_PAGE;
+    bm->pageFile = name;
+    bm->numPages = numPages;
+    bm->strategy = strategy;
+    bm->fileId = 0;
+    bm->mgmtData = mgmt;
+    mgmt->warmRestart = options->warmRestart;
+    warmPreload(bm);
+    return RC_OK;
+}
+
+/** 
+* @brief shut down every partition, partition 0 last since it holds the page file, then the routing metadata
+* @param bm, input value, a partitioned buffer pool
+* @return RC, return code
+*/
+static RC shutdownPartitions(BM_BufferPool *bm) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+
+    warmSave(bm, bm->pageFile);
+    stopBufferTrace(bm); // the partitions share the trace file, it is closed once
+    for (int p = mgmt->numPartitions - 1; p >= 0; p--) {
+        shutdownBufferPool(&mgmt->partitions[p]);
+    }
+    pthread_mutex_destroy(&mgmt->prefetchLatch);
+    free(mgmt->partitions);
+    free(mgmt);
+    free(bm->pageFile);
+    bm->pageFile = NULL;
+    bm->mgmtData = NULL;
+    return RC_OK;
+}
+
+/** 
+* @brief resize every partition to its share of newNumPages. A partition that can not shrink keeps its size,
+*        bm->numPages is the sum of what the partitions have afterwards.
+* @param bm, input value, a partitioned buffer pool
+* @param newNumPages, input value, new number of frames, at least one per partition
+* @return RC, return code of the first partition that failed
+*/
+static RC resizePartitions(BM_BufferPool *bm, int newNumPages) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (newNumPages < mgmt->numPartitions) 
+        THROW(RC_INVALID_PARAMS, "A partitioned buffer pool needs a frame per partition at least");
+
+    RC rc = RC_OK;
+    int numPages = 0;
+    for (int p = 0; p < mgmt->numPartitions; p++) {
+        RC partRc = resizeBufferPool(&mgmt->partitions[p], partitionShare(newNumPages, mgmt->numPartitions, p));
+        if (rc == RC_OK) rc = partRc;
+        numPages += mgmt->partitions[p].numPages;
+    }
+    bm->numPages = numPages;
+    return rc;
+}
+
+/** 
+* @brief frame i of the pool for the statistics getters: a partitioned pool lists partition 0's frames first,
+*        then partition 1's and so on
+* @param bm, input value, a buffer pool structure pointer
+* @param i, input and output value, frame index less than bm->numPages, set to the index in the returned pool
+* @return BM_MgmtData *, the pool or partition that holds the frame
+*/
+static BM_MgmtData *frameAt(BM_BufferPool *bm, int *i) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (mgmt->partitions == NULL) return mgmt;
+
+    int p = 0;
+    while (p < mgmt->numPartitions - 1 && *i >= mgmt->partitions[p].numPages) {
+        *i -= mgmt->partitions[p++].numPages;
+    }
+    return (BM_MgmtData *)mgmt->partitions[p].mgmtData;
+}
+
+/*----------------------functions for manipulating buffer pool ----------------------*/
+/** 
+* @brief create and initialize the buffer pool
+* @param bm, input value, a buffer pool structure pointer
+* @param pageFileName, input value, page file name
+* @param numPages, input value, number of pages in the buffer pool
+* @param strategy, input value, replacement strategy
+* @param stratData, input value, strategy data
+* @return RC, return code
+*/
+RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, 
+                 const int numPages, ReplacementStrategy strategy, void *stratData) {
+    return initBufferPoolEx(bm, pageFileName, numPages, strategy, stratData, NULL);
+}
+
+/** 
+* @brief create and initialize the buffer pool with pool options
+* @param bm, input value, a buffer pool structure pointer
+* @param pageFileName, input value, page file name, NULL for a pool that only caches files attached to it
+* @param numPages, input value, number of pages in the buffer pool
+* @param strategy, input value, replacement strategy
+* @param stratData, input value, strategy data
+* @param options, input value, pool options, NULL selects the defaults
+* @return RC, return code
+*/
+RC initBufferPoolEx(BM_BufferPool *const bm, const char *const pageFileName, 
+                 const int numPages, ReplacementStrategy strategy, void *stratData, 
+                 const BM_PoolOptions *options) {
+    
+    if (strategy < 0 || (int)strategy >= NUM_POLICIES) THROW(RC_INVALID_PARAMS, "Unsupported replacement strategy");
+    if (options != NULL && options->numPartitions > 1) 
+        return initPartitions(bm, pageFileName, numPages, strategy, stratData, options);
+    return initPool(bm, pageFileName, numPages, strategy, stratData, options, NULL);
+}
+
+/** 
+* @brief create and initialize one buffer pool, a whole pool or a partition of a partitioned one
+* @param bm, input value, a buffer pool structure pointer
+* @param pageFileName, input value, page file name, NULL for a pool that only caches files attached to it
+* @param numPages, input value, number of pages in the buffer pool
+* @param strategy, input value, replacement strategy
+* @param stratData, input value, strategy data
+* @param options, input value, pool options, NULL selects the defaults
+* @param fileOwner, input value, pool whose page files and file latch this one uses, NULL for its own
+* @return RC, return code
+*/
+static RC initPool(BM_BufferPool *bm, const char *pageFileName, int numPages, ReplacementStrategy strategy, 
+                   void *stratData, const BM_PoolOptions *options, BM_MgmtData *fileOwner) {
+    // initialize buffer pool basic information
+    bm->pageFile = NULL;
+    if (pageFileName != NULL) {
+        bm->pageFile = (char *)malloc(strlen(pageFileName) + 1); 
+        if (bm->pageFile == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed for pageFile");
+        strcpy(bm->pageFile, pageFileName); // copy page file name
+    }
+    bm->fileId = 0; // the pool's own file
+    bm->numPages = numPages; // set number of pages
+    bm->strategy = strategy; // set replacement strategy
+    
+    // initialize buffer pool meta data, the metadata of the policies not in use stays NULL
+    BM_MgmtData *mgmt = (BM_MgmtData *)calloc(1, sizeof(BM_MgmtData)); 
+    if (mgmt == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for BM_MgmtData");
+    mgmt->fileOwner = (fileOwner != NULL) ? fileOwner : mgmt;
+    mgmt->warmRestart = (options != NULL && options->warmRestart);
+    mgmt->concurrent = (options != NULL && (options->concurrent || options->cleanerIntervalMs > 0 || options->readAheadPages > 0));
+    // concurrent pins read the frames and the page table under a stripe latch only, so a concurrent pool
+    // gets them sized for maxPages now and they never move; otherwise resizeBufferPool reallocates them
+    int capacity = numPages;
+    if (mgmt->concurrent && options->maxPages > capacity) capacity = options->maxPages;
+    mgmt->capacity = capacity;
+    mgmt->frames = (Frame *)calloc(capacity, sizeof(Frame)); // allcate frames matadata
+    if (mgmt->frames == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for frames");
+    mgmt->fixCounts = (int *)calloc(capacity, sizeof(int));
+    if (mgmt->fixCounts == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for fix counts");
+    mgmt->arenas = NULL;
+    mgmt->numArenas = 0;
+    mgmt->arenaFrames = 0;
+    
+    memset(&mgmt->stats, 0, sizeof(BM_PoolStats));
+    mgmt->trace = NULL;
+    pthread_mutex_init(&mgmt->traceLatch, NULL);
+    mgmt->numFiles = 1;
+    mgmt->files = (PoolFile *)calloc(1, sizeof(PoolFile));
+    if (mgmt->files == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for files");
+    mgmt->files[0].view = bm;
+    mgmt->policy = &policies[strategy];
+
+    // page table: at least two buckets per frame keeps the chains short
+    int numBuckets = 1;
+    while (numBuckets < 2 * capacity) numBuckets <<= 1;
+    mgmt->pageTable = (int *)malloc(numBuckets * sizeof(int));
+    if (mgmt->pageTable == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for page table");
+    memset(mgmt->pageTable, -1, numBuckets * sizeof(int));
+    mgmt->pageTableMask = numBuckets - 1;
+
+    // latches: stripes partition the page table buckets, so there are never more stripes than buckets
+    mgmt->stripeLatches = NULL;
+    mgmt->stripeMask = 0;
+    mgmt->frameLatches = NULL;
+    mgmt->frameWriters = NULL;
+    mgmt->writeBacks = NULL;
+    mgmt->numWriteBacks = 0;
+    if (mgmt->concurrent) {
+        int numStripes = 1;
+        int wanted = (options->numLatchStripes > 0) ? options->numLatchStripes : DEFAULT_LATCH_STRIPES;
+        while (numStripes < wanted && numStripes < numBuckets) numStripes <<= 1;
+        mgmt->stripeLatches = (pthread_mutex_t *)malloc(numStripes * sizeof(pthread_mutex_t));
+        if (mgmt->stripeLatches == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for latches");
+        for (int i = 0; i < numStripes; i++) {
+            pthread_mutex_init(&mgmt->stripeLatches[i], NULL);
+        }
+        mgmt->stripeMask = numStripes - 1;
+        pthread_mutex_init(&mgmt->poolLatch, NULL);
+        pthread_cond_init(&mgmt->frameCond, NULL);
+
+        mgmt->frameLatches = (pthread_rwlock_t *)malloc(capacity * sizeof(pthread_rwlock_t));
+        if (mgmt->frameLatches == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for frame latches");
+        for (int i = 0; i < capacity; i++) {
+            pthread_rwlock_init(&mgmt->frameLatches[i], NULL);
+        }
+        mgmt->frameWriters = (const char **)calloc(capacity, sizeof(const char *));
+        if (mgmt->frameWriters == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for frame writers");
+        mgmt->writeBacks = (PageNumber *)malloc(capacity * sizeof(PageNumber));
+        if (mgmt->writeBacks == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for write-backs");
+
+        // prefetch requests are queued for an I/O thread that is started by the first one
+        mgmt->prefetchQueue = (PageNumber *)malloc(capacity * sizeof(PageNumber));
+        if (mgmt->prefetchQueue == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for the prefetch queue");
+        pthread_mutex_init(&mgmt->fileLatch, NULL);
+        pthread_cond_init(&mgmt->ioCond, NULL);
+        pthread_mutex_init(&mgmt->prefetchLatch, NULL);
+        pthread_cond_init(&mgmt->prefetchCond, NULL);
+    }
+    mgmt->pinWaitMs = (options != NULL && options->pinWaitMs != 0) ? options->pinWaitMs : DEFAULT_PIN_WAIT_MS;
+    mgmt->frameWaiters = 0;
+    mgmt->prefetchHead = 0;
+    mgmt->prefetchCount = 0;
+    mgmt->prefetcherRunning = false;
+    mgmt->prefetcherStop = false;
+    mgmt->readAheadPages = (options != NULL && options->readAheadPages > 0) ? options->readAheadPages : 0;
+    mgmt->seqLast = NO_PAGE;
+    mgmt->seqRun = 0;
+    mgmt->readAheadNext = 0;
+    mgmt->dirtyClock = 0;
+    mgmt->cleanerRunning = false;
+    mgmt->cleanerStop = false;
+    mgmt->cleanerScratch = NULL;
+    mgmt->cleanerIntervalMs = (options != NULL && options->cleanerIntervalMs > 0) ? options->cleanerIntervalMs : 0;
+    mgmt->cleanerDirtyPercent = (options != NULL && options->cleanerDirtyPercent > 0) ? options->cleanerDirtyPercent 
+                                                                                      : DEFAULT_CLEANER_DIRTY_PERCENT;
+    if (mgmt->cleanerIntervalMs > 0) {
+        mgmt->cleanerScratch = (CleanCandidate *)malloc(capacity * sizeof(CleanCandidate));
+        if (mgmt->cleanerScratch == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for the background writer");
+        pthread_cond_init(&mgmt->cleanerCond, NULL);
+    }
+
+    // free frames are handed out in ascending order, frame 0 first
+    mgmt->freeFrames = (int *)malloc(capacity * sizeof(int));
+    if (mgmt->freeFrames == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for free frames");
+    mgmt->numFreeFrames = numPages;
+    for (int i = 0; i < numPages; i++) {
+        mgmt->freeFrames[i] = numPages - 1 - i;
+    }
+    // initialize frames metadata, frames past numPages wait for resizeBufferPool
+    for (int i = 0; i < capacity; i++) {
+        initFrame(mgmt, i);
+    }
+    // one page aligned block for all frame data: one allocation, and neighbouring frames share TLB entries
+    if (addArenaSegment(mgmt, numPages) != RC_OK) 
+        THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for frame data");
+
+    // open the page file
+    if (pageFileName != NULL && openPageFile((char *)pageFileName, &mgmt->files[0].fileHandle) != RC_OK) {
+        // file does not exist, throw error
+        THROW(RC_FILE_NOT_FOUND, "Page file not found");
+    }
+
+    bm->mgmtData = mgmt;
+    // the policy sets up its own metadata for the frames
+    RC rc = mgmt->policy->init(bm, stratData);
+    if (rc != RC_OK) return rc;
+    warmPreload(bm);
+
+    // the background writer starts once the pool is usable
+    if (mgmt->cleanerIntervalMs > 0) {
+        if (pthread_create(&mgmt->cleaner, NULL, cleanerMain, bm) != 0) 
+            THROW(RC_UNVALID_HANDLE, "Failed to start the background writer");
+        mgmt->cleanerRunning = true;
+    }
+#ifdef DEBUG
+    showBufferPool(bm);// show buffer pool meta data for debug
+    showFrames(bm); // show frames meta data for debug
+#endif
+    return RC_OK;
+}
+
+/** 
+* @brief detach a handle from attachBufferPool: save the file's hot page set if warm restart is on,
+*        write back and evict its file's pages, close the file.
+*        Fails without changing anything if one of the pages is pinned.
+* @param view, input value, a buffer pool structure pointer with fileId != 0
+* @return RC, return code
+*/
+static RC detachFile(BM_BufferPool *view) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)view->mgmtData;
+    int fileId = view->fileId;
+
+    warmSave(view, view->pageFile);
+    latchPool(mgmt);
+    waitForWriteBacks(mgmt); // a victim being written back has left the page table but still holds its key
+    // same as shrinkPool: with every stripe held no hit can pin one of the file's pages
+    latchAllStripes(mgmt);
+    for (int i = 0; i < view->numPages; i++) {
+        PageNumber key = mgmt->frames[i].pageHandle.pageNum;
+        if (key != NO_PAGE && keyFileId(key) == fileId && ATOMIC_LOAD(&mgmt->fixCounts[i]) != 0) {
+            unlatchAllStripes(mgmt);
+            unlatchPool(mgmt);
+            THROW(RC_PINNED_PAGES_IN_BUFFER, "Can not detach the page file, one of its pages is pinned");
+        }
+    }
+    int numDetached = 0;
+    for (int i = 0; i < view->numPages; i++) {
+        PageNumber key = mgmt->frames[i].pageHandle.pageNum;
+        if (key != NO_PAGE && keyFileId(key) == fileId) {
+            pageTableRemove(mgmt, i);
+            numDetached++;
+        }
+    }
+    unlatchAllStripes(mgmt);
+
+    // one batched write-back first, then evicted like victims and the emptied frames go back to the free stack
+    if (numDetached > 0) flushBatch(view, fileId);
+    for (int i = 0; i < view->numPages && numDetached > 0; i++) {
+        PageNumber key = mgmt->frames[i].pageHandle.pageNum;
+        if (key != NO_PAGE && keyFileId(key) == fileId) {
+            CHECK(replaceFrame(view, i));
+            releaseFreeFrame(mgmt, i);
+            numDetached--;
+        }
+    }
+
+    PoolFile *file = &mgmt->files[fileId];
+    latchFile(mgmt);
+    if (file->fileHandle.mgmtInfo != NULL) closePageFile(&file->fileHandle);
+    memset(file, 0, sizeof(PoolFile)); // the slot is free for the next attachBufferPool
+    unlatchFile(mgmt);
+    unlatchPool(mgmt);
+
+    free(view->pageFile);
+    view->pageFile = NULL;
+    view->mgmtData = NULL;
+    return RC_OK;
+}
+
+/** 
+* @brief flush all dirty pages to disk, close the page file, release resources.
+*        On a handle from attachBufferPool only its file is detached, the pool stays open.
+* @param bm, input value, a buffer pool structure pointer
+* @return RC, return code
+*/
+// 修复shutdownBufferPool函数中的Frame成员访问
+RC shutdownBufferPool(BM_BufferPool *const bm) {
+    // 进行最基本的参数检查
+    if (bm == NULL) {
+        DEBUG_PRINT("Warning: shutdownBufferPool called with NULL buffer pool\n");
+        return RC_OK;
+    }
+    if (bm->mgmtData != NULL && bm->fileId != 0) return detachFile(bm);
+    if (bm->mgmtData != NULL && ((BM_MgmtData *)bm->mgmtData)->partitions != NULL) return shutdownPartitions(bm);
+
+    // 保存文件名指针，稍后释放
+    char *pageFileToFree = bm->pageFile;
+    bm->pageFile = NULL; // 防止重复释放
+
+    // 如果管理数据不为空，进行资源释放
+    if (bm->mgmtData != NULL) {
+        BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+        
+        // 0. 停止I/O线程和后台写线程，再写回所有脏页
+        if (mgmt->prefetcherRunning) {
+            pthread_mutex_lock(&mgmt->prefetchLatch);
+            mgmt->prefetcherStop = true;
+            pthread_cond_signal(&mgmt->prefetchCond);
+            pthread_mutex_unlock(&mgmt->prefetchLatch);
+            pthread_join(mgmt->prefetcher, NULL);
+            mgmt->prefetcherRunning = false;
+        }
+        if (mgmt->cleanerRunning) {
+            latchPool(mgmt);
+            mgmt->cleanerStop = true;
+            pthread_cond_signal(&mgmt->cleanerCond);
+            unlatchPool(mgmt);
+            pthread_join(mgmt->cleaner, NULL);
+            mgmt->cleanerRunning = false;
+        }
+        if (mgmt->cleanerIntervalMs > 0) {
+            pthread_cond_destroy(&mgmt->cleanerCond);
+            free(mgmt->cleanerScratch);
+        }
+        warmSave(bm, pageFileToFree); // 记下热页集合，下次打开时预读
+        forceFlushPool(bm);
+        stopBufferTrace(bm);
+        pthread_mutex_destroy(&mgmt->traceLatch);
+
+        // 1. 关闭所有页面文件（如果文件句柄有效），包括仍挂在共享池上的文件
+        for (int f = 0; f < mgmt->numFiles; f++) {
+            SM_FileHandle *fh = &mgmt->files[f].fileHandle;
+            if (fh->fileName != NULL && fh->mgmtInfo != NULL) {
+                closePageFile(fh);
+                // 关闭后立即置空，避免后续操作再次访问
+                fh->mgmtInfo = NULL;
+            }
+        }
+        free(mgmt->files);
+        mgmt->files = NULL;
+        
+        // 2. 释放帧数据区（初始化时一块，每次扩容一块）
+        for (int i = 0; i < mgmt->numArenas; i++) {
+            free(mgmt->arenas[i].base);
+        }
+        free(mgmt->arenas);
+        mgmt->arenas = NULL;
+        if (mgmt->frames != NULL) {
+            // 3. 释放帧数组
+            free(mgmt->frames);
+            mgmt->frames = NULL;
+        }
+        free(mgmt->fixCounts);
+        mgmt->fixCounts = NULL;
+
+        // 释放替换策略的元数据
+        mgmt->policy->release(bm);
+
+        // 释放并发模式的闩锁
+        if (mgmt->concurrent) {
+            for (int i = 0; i <= mgmt->stripeMask; i++) {
+                pthread_mutex_destroy(&mgmt->stripeLatches[i]);
+            }
+            free(mgmt->stripeLatches);
+            pthread_mutex_destroy(&mgmt->poolLatch);
+            pthread_cond_destroy(&mgmt->frameCond);
+            for (int i = 0; i < mgmt->capacity; i++) {
+                pthread_rwlock_destroy(&mgmt->frameLatches[i]);
+            }
+            free(mgmt->frameLatches);
+            free(mgmt->frameWriters);
+            free(mgmt->writeBacks);
+            pthread_mutex_destroy(&mgmt->fileLatch);
+            pthread_cond_destroy(&mgmt->ioCond);
+            pthread_mutex_destroy(&mgmt->prefetchLatch);
+            pthread_cond_destroy(&mgmt->prefetchCond);
+            free(mgmt->prefetchQueue);
+        }
+
+        // 释放页表和空闲帧栈
+        free(mgmt->pageTable);
+        mgmt->pageTable = NULL;
+        free(mgmt->freeFrames);
+        mgmt->freeFrames = NULL;
+        
+        // 4. 释放管理数据结构体
+        free(mgmt);
+        bm->mgmtData = NULL;
+    }
+    
+    // 5. 最后释放页面文件名
+    if (pageFileToFree != NULL) {
+        free(pageFileToFree);
+    }
+    
+    DEBUG_PRINT("shutdownBufferPool: all resources properly released\n");
+    return RC_OK;
+}
+
+/** 
+* @brief flush all dirty pages in the buffer pool to page file, sorted by page so that
+*        neighbouring pages are written together
+* @param bm, input value, a buffer pool structure pointer
+* @return RC, return code
+*/
+RC forceFlushPool(BM_BufferPool *const bm) {
+    if (bm == NULL) {
+        DEBUG_PRINT("Warning: forceFlushPool: bm == NULL\n");
+        return RC_OK;
+    }
+
+    if (bm->mgmtData == NULL) {
+        DEBUG_PRINT("Warning: forceFlushPool: mgmtData is NULL\n");
+        return RC_OK;
+    }
+
+    // the pool latch keeps misses from replacing frames while they are written
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    for (int p = 0; p < mgmt->numPartitions; p++) {
+        forceFlushPool(&mgmt->partitions[p]);
+    }
+    if (mgmt->partitions != NULL) return RC_OK;
+    latchPool(mgmt);
+    // 脏页按页号排序，连续的页合并成一次写
+    RC rc = flushBatch(bm, -1);
+    if (rc != RC_OK) {
+        // 记录错误但不返回，其余的页已经写回
+        DEBUG_PRINT("Warning: forceFlushPool: write back failed: %s\n", errorMessage(rc));
+    }
+    unlatchPool(mgmt);
+
+    return RC_OK;
+}
+
+/** 
+* @brief make every per-frame array room for newCapacity frames. Only for a pool that is not concurrent,
+*        the arrays move. The caller holds the pool latch.
+* @param bm, input value, a buffer pool structure pointer
+* @param newCapacity, input value, new number of entries, larger than the current one
+* @return RC, return code
+*/
+static RC growCapacity(BM_BufferPool *bm, int newCapacity) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    int oldCapacity = mgmt->capacity;
+
+    Frame *frames = (Frame *)realloc(mgmt->frames, newCapacity * sizeof(Frame));
+    if (frames == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in resizeBufferPool() for frames");
+    mgmt->frames = frames;
+    int *fixCounts = (int *)realloc(mgmt->fixCounts, newCapacity * sizeof(int));
+    if (fixCounts == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in resizeBufferPool() for fix counts");
+    mgmt->fixCounts = fixCounts;
+    int *freeFrames = (int *)realloc(mgmt->freeFrames, newCapacity * sizeof(int));
+    if (freeFrames == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in resizeBufferPool() for free frames");
+    mgmt->freeFrames = freeFrames;
+
+    CHECK(mgmt->policy->grow(bm, newCapacity));
+
+    // the page table keeps at least two buckets per frame
+    int numBuckets = 1;
+    while (numBuckets < 2 * newCapacity) numBuckets <<= 1;
+    int *pageTable = (int *)malloc(numBuckets * sizeof(int));
+    if (pageTable == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in resizeBufferPool() for page table");
+    free(mgmt->pageTable);
+    mgmt->pageTable = pageTable;
+    mgmt->pageTableMask = numBuckets - 1;
+    memset(pageTable, -1, numBuckets * sizeof(int));
+    for (int i = 0; i < oldCapacity; i++) {
+        if (mgmt->frames[i].pageHandle.pageNum != NO_PAGE) pageTableInsert(mgmt, i);
+    }
+
+    for (int i = oldCapacity; i < newCapacity; i++) {
+        mgmt->frames[i].pageHandle.data = NULL;
+        initFrame(mgmt, i);
+    }
+    mgmt->capacity = newCapacity;
+    return RC_OK;
+}
+
+/** 
+* @brief add frames [numPages, newNumPages) to the pool as free frames. The caller holds the pool latch.
+* @param bm, input value, a buffer pool structure pointer
+* @param newNumPages, input value, new number of frames
+* @return RC, return code
+*/
+static RC growPool(BM_BufferPool *bm, int newNumPages) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    int added = newNumPages - bm->numPages;
+
+    if (newNumPages > mgmt->capacity) {
+        if (mgmt->concurrent) THROW(RC_INVALID_PARAMS, "A concurrent buffer pool can not grow past BM_PoolOptions.maxPages");
+        RC rc = growCapacity(bm, newNumPages);
+        if (rc != RC_OK) return rc;
+    }
+    RC rc = addArenaSegment(mgmt, newNumPages);
+    if (rc != RC_OK) return rc;
+
+    // the new frames go under the frames that are already free, and are handed out lowest first
+    memmove(&mgmt->freeFrames[added], mgmt->freeFrames, mgmt->numFreeFrames * sizeof(int));
+    for (int j = 0; j < added; j++) {
+        mgmt->freeFrames[j] = newNumPages - 1 - j;
+    }
+    mgmt->numFreeFrames += added;
+    bm->numPages = newNumPages;
+    wakeFrameWaiters(mgmt, true);
+    return RC_OK;
+}
+
+/** 
+* @brief evict the pages of frames [newNumPages, numPages) and drop the frames.
+*        Fails without changing anything if one of them is pinned. The caller holds the pool latch.
+* @param bm, input value, a buffer pool structure pointer
+* @param newNumPages, input value, new number of frames
+* @return RC, return code
+*/
+static RC shrinkPool(BM_BufferPool *bm, int newNumPages) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+
+    waitForWriteBacks(mgmt); // the dropped frames may hold victims being written back
+    // hits pin under a stripe latch, with all of them held the fix counts of the dropped frames stay 0
+    latchAllStripes(mgmt);
+    for (int i = newNumPages; i < bm->numPages; i++) {
+        if (ATOMIC_LOAD(&mgmt->fixCounts[i]) != 0) {
+            unlatchAllStripes(mgmt);
+            THROW(RC_PINNED_PAGES_IN_BUFFER, "Can not shrink the buffer pool, a dropped frame is pinned");
+        }
+    }
+    for (int i = newNumPages; i < bm->numPages; i++) {
+        if (mgmt->frames[i].pageHandle.pageNum != NO_PAGE) pageTableRemove(mgmt, i);
+    }
+    unlatchAllStripes(mgmt);
+
+    // the detached pages are written back and leave the replacement policy like victims,
+    // a pin of one of them waits for the pool latch and loads it into a remaining frame
+    for (int i = newNumPages; i < bm->numPages; i++) {
+        if (mgmt->frames[i].pageHandle.pageNum != NO_PAGE) CHECK(replaceFrame(bm, i));
+    }
+    int n = 0;
+    for (int j = 0; j < mgmt->numFreeFrames; j++) {
+        if (mgmt->freeFrames[j] < newNumPages) mgmt->freeFrames[n++] = mgmt->freeFrames[j];
+    }
+    mgmt->numFreeFrames = n;
+    bm->numPages = newNumPages;
+    trimArenaSegments(mgmt, newNumPages);
+    return RC_OK;
+}
+
+/** 
+* @brief change the number of frames of an open pool. Growing adds free frames; shrinking writes back
+*        and evicts the pages of the frames past newNumPages, which must all be unpinned.
+*        Pages that stay keep their frames, so pinned page handles stay valid either way.
+*        A concurrent pool can grow up to BM_PoolOptions.maxPages.
 * @param bm, input value, a buffer pool structure pointer
+* @param newNumPages, input value, new number of frames
+* @return RC, return code
+*/
+RC resizeBufferPool(BM_BufferPool *const bm, const int newNumPages) {
+    if (bm == NULL || bm->mgmtData == NULL || newNumPages <= 0) 
+        THROW(RC_INVALID_PARAMS, "Invalid buffer pool or number of frames");
+
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (mgmt->partitions != NULL) return resizePartitions(bm, newNumPages);
+    RC rc = RC_OK;
+    latchPool(mgmt);
+    if (newNumPages > bm->numPages) rc = growPool(bm, newNumPages);
+    else if (newNumPages < bm->numPages) rc = shrinkPool(bm, newNumPages);
+    if (rc == RC_OK && mgmt->policy->resize != NULL) mgmt->policy->resize(bm, newNumPages);
+    if (rc == RC_OK) {
+        // every handle on the pool sees the new size, whichever one was resized
+        for (int f = 0; f < mgmt->numFiles; f++) {
+            if (mgmt->files[f].view != NULL) mgmt->files[f].view->numPages = newNumPages;
+        }
+    }
+    unlatchPool(mgmt);
+    return rc;
+}
+
+/** 
+* @brief open another page file in the frames of an open pool. The view shares the pool's frames,
+*        policy and statistics; its pages are keyed by the file slot so equal page numbers of
+*        different files never collide. shutdownBufferPool(view) detaches the file again.
+* @param view, output value, a buffer pool structure pointer for the attached file
+* @param pool, input value, an open buffer pool
 * @param pageFileName, input value, page file name
-* @param numPages, input value, number of pages in the buffer pool
-* @param strategy, input value, replacement strategy
-* @param stratData, input value, strategy data
 * @return RC, return code
 */
-RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, 
-                 const int numPages, ReplacementStrategy strategy, void *stratData) {
-    
-    // initialize buffer pool basic information
-    bm->pageFile = (char *)malloc(strlen(pageFileName) + 1); 
-    if (bm->pageFile == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed for pageFile");
+RC attachBufferPool(BM_BufferPool *const view, BM_BufferPool *const pool, const char *const pageFileName) {
+    if (view == NULL || pool == NULL || pool->mgmtData == NULL || pageFileName == NULL) 
+        THROW(RC_INVALID_PARAMS, "Invalid buffer pool or page file name");
+
+    BM_MgmtData *mgmt = (BM_MgmtData *)pool->mgmtData;
+    // a page key would have to find its partition before the file slot of its handle
+    if (mgmt->partitions != NULL) THROW(RC_INVALID_PARAMS, "Can not attach a page file to a partitioned buffer pool");
+    char *name = (char *)malloc(strlen(pageFileName) + 1);
+    if (name == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed for pageFile");
+    strcpy(name, pageFileName);
+
+    latchPool(mgmt);
+    // slot 0 is the pool's own file, even when it was opened without one
+    int fileId = -1;
+    for (int f = 1; f < mgmt->numFiles; f++) {
+        if (mgmt->files[f].view == NULL) { fileId = f; break; }
+    }
+    if (fileId < 0) {
+        if (mgmt->numFiles >= MAX_POOL_FILES) {
+            unlatchPool(mgmt);
+            free(name);
+            THROW(RC_INVALID_PARAMS, "Too many page files attached to the buffer pool");
+        }
+        // misses read files[] under the pool latch and prefetch reads under the file latch, hold both to move it
+        latchFile(mgmt);
+        PoolFile *files = (PoolFile *)realloc(mgmt->files, (mgmt->numFiles + 1) * sizeof(PoolFile));
+        if (files != NULL) {
+            memset(&files[mgmt->numFiles], 0, sizeof(PoolFile));
+            mgmt->files = files;
+            fileId = mgmt->numFiles++;
+        }
+        unlatchFile(mgmt);
+        if (files == NULL) {
+            unlatchPool(mgmt);
+            free(name);
+            THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in attachBufferPool() for files");
+        }
+    }
+
+    latchFile(mgmt);
+    RC rc = openPageFile(name, &mgmt->files[fileId].fileHandle);
+    unlatchFile(mgmt);
+    if (rc != RC_OK) {
+        memset(&mgmt->files[fileId], 0, sizeof(PoolFile));
+        unlatchPool(mgmt);
+        free(name);
+        THROW(RC_FILE_NOT_FOUND, "Page file not found");
+    }
+
+    view->pageFile = name;
+    view->numPages = pool->numPages;
+    view->strategy = pool->strategy;
+    view->mgmtData = mgmt;
+    view->fileId = fileId;
+    mgmt->files[fileId].view = view;
+    unlatchPool(mgmt);
+    warmPreload(view);
+    return RC_OK;
+}
+
+/*----------------------statistics and trace functions ----------------------*/
+// monotonic clock in ns for the latency histograms and the trace
+static inline unsigned long long nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// bucket b of a latency histogram counts durations in [2^b, 2^(b+1)) ns, the last one everything longer
+static inline void countLatency(unsigned long long *histogram, unsigned long long ns) {
+    int b = (ns == 0) ? 0 : 63 - __builtin_clzll(ns);
+    if (b >= BM_LATENCY_BUCKETS) b = BM_LATENCY_BUCKETS - 1;
+    STAT_ADD(&histogram[b], 1);
+}
+
+// a finished pin, hits are counted by pinHit already
+static inline void countPin(BM_MgmtData *mgmt, bool miss, unsigned long long ns) {
+    countLatency(mgmt->stats.pinLatency, ns);
+    if (miss) {
+        STAT_ADD(&mgmt->stats.misses, 1);
+        countLatency(mgmt->stats.missLatency, ns);
+    }
+}
+
+// append one event to the access trace if startBufferTrace turned it on, a no-op otherwise
+static void traceAccess(BM_MgmtData *mgmt, PageNumber key, int op) {
+    if (ATOMIC_LOAD(&mgmt->trace) == NULL) return;
+    BM_TraceRecord record = { nowNs(), key, op };
+    pthread_mutex_lock(&mgmt->traceLatch);
+    FILE *trace = ATOMIC_LOAD(&mgmt->trace); // stopBufferTrace may have closed it meanwhile
+    if (trace != NULL) fwrite(&record, sizeof(BM_TraceRecord), 1, trace);
+    pthread_mutex_unlock(&mgmt->traceLatch);
+}
+
+/** 
+* @brief set a frame's dirty flag, stamping the clean -> dirty transition: the background writer cleans older pages first
+* @param mgmt, input value, a buffer pool metadata structure pointer
+* @param frameIdx, input value, frame index
+*/
+static void setDirty(BM_MgmtData *mgmt, int frameIdx) {
+    if (ATOMIC_LOAD(&mgmt->frames[frameIdx].isDirty)) return;
+    mgmt->frames[frameIdx].dirtyTime = mgmt->concurrent ? ATOMIC_ADD(&mgmt->dirtyClock, 1) : ++mgmt->dirtyClock;
+    ATOMIC_STORE(&mgmt->frames[frameIdx].isDirty, true);
+}
+
+/** 
+* @brief mark a page as dirty
+* @param bm, input value, a buffer pool structure pointer
+* @param page, input value, a page handle structure pointer
+* @return RC, return code
+*/
+RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page) {
+
+    if (bm == NULL || bm->mgmtData == NULL || page == NULL) THROW(RC_UNVALID_HANDLE, "markDirty: Invalid buffer pool or page handle");
+
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (mgmt->partitions != NULL) return markDirty(partitionOf(mgmt, page->pageNum), page);
+    PageNumber key = pageKey(bm, page->pageNum);
+    latchStripe(mgmt, key);
+    int frameIdx = getFrameIndex(bm, key);
+    if (frameIdx != -1) setDirty(mgmt, frameIdx);
+    unlatchStripe(mgmt, key);
+
+    if (frameIdx == -1) THROW(RC_UNVALID_HANDLE, "Can not mark page as dirty, Page not in buffer pool");
+    return RC_OK;
+}
+
+/** 
+* @brief release a pin by page key
+* @param bm, input value, a buffer pool structure pointer
+* @param key, input value, the page's key
+* @return RC, return code
+*/
+static RC unpinKey(BM_BufferPool *bm, PageNumber key) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    bool poolLatched = hitNeedsPoolLatch(bm);
+    if (poolLatched) latchPool(mgmt);
+
+    // the fix count of a resident page only changes under its stripe latch
+    latchStripe(mgmt, key);
+    int frameIdx = getFrameIndex(bm, key);
+    bool unpinned = false;
+    if (frameIdx != -1) {
+        if (mgmt->fixCounts[frameIdx] > 0) 
+            unpinned = (fixCountAdd(mgmt, frameIdx, -1) == 0);
+        mgmt->policy->onUnpin(bm, frameIdx);
+    }
+    unlatchStripe(mgmt, key);
+
+    if (frameIdx == -1) {
+        if (poolLatched) unlatchPool(mgmt);
+        THROW(RC_UNVALID_HANDLE, "Page not in buffer pool");
+    }
+    if (unpinned) wakeFrameWaiters(mgmt, poolLatched);
+    if (poolLatched) unlatchPool(mgmt);
+    return RC_OK;
+}
+
+/** 
+* @brief release a frame in the buffer pool, if needed, write back to page file.
+* @param bm, input value, a buffer pool structure pointer
+* @param page, input value, a page handle structure pointer
+* @return RC, return code
+*/
+RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page) {
+
+    if (bm == NULL || bm->mgmtData == NULL || page == NULL) THROW(RC_UNVALID_HANDLE, "Invalid buffer pool or page handle");
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (mgmt->partitions != NULL) return unpinPage(partitionOf(mgmt, page->pageNum), page);
+    PageNumber key = pageKey(bm, page->pageNum);
+    RC rc = unpinKey(bm, key);
+    if (rc == RC_OK) traceAccess((BM_MgmtData *)bm->mgmtData, key, TRACE_UNPIN);
+    return rc;
+}
+
+/** 
+* @brief write back a page to pages file
+* @param bm, input value, a buffer pool structure pointer
+* @param page, input value, a page handle structure pointer
+* @return RC, return code
+*/
+RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page) {
+
+    if (bm == NULL || bm->mgmtData == NULL || page == NULL) THROW(RC_FILE_HANDLE_NOT_INIT, "Invalid buffer pool or page handle");
     
-    strcpy(bm->pageFile, pageFileName); // copy page file name
-    bm->numPages = numPages; // set number of pages
-    bm->strategy = strategy; // set replacement strategy
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (mgmt->partitions != NULL) return forcePage(partitionOf(mgmt, page->pageNum), page);
+    latchPool(mgmt);
+    int frameIdx = getFrameIndex(bm, pageKey(bm, page->pageNum));
+    RC rc = (frameIdx < 0) ? RC_READ_NON_EXISTING_PAGE : flushFrame(bm, frameIdx, true);
+    unlatchPool(mgmt);
+
+    if (rc == RC_READ_NON_EXISTING_PAGE) THROW(RC_READ_NON_EXISTING_PAGE, "Page not in buffer pool");
+    return rc;
+}
+
+/** 
+* @brief pin a resident page. The caller holds the page's stripe latch, and the pool latch
+*        if hitNeedsPoolLatch()
+* @param bm, input value, a buffer pool structure pointer
+* @param page, output value, a page handle structure pointer
+* @param frameIdx, input value, frame holding the page
+*/
+static void pinHit(BM_BufferPool *bm, BM_PageHandle *page, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+
+    fixCountAdd(mgmt, frameIdx, 1); // increase fix count
+    STAT_ADD(&mgmt->stats.hits, 1);
+    mgmt->policy->onHit(bm, frameIdx);
     
-    gLoadCounter = 0; // initialize global load counter
-    gAccessCounter = 0; // initialize access counter
+    page->pageNum = keyPage(mgmt->frames[frameIdx].pageHandle.pageNum);
+    page->data = mgmt->frames[frameIdx].pageHandle.data;
+}
 
-    // initialize buffer pool meta data
-    BM_MgmtData *mgmt = (BM_MgmtData *)malloc(sizeof(BM_MgmtData)); 
-    if (mgmt == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for BM_MgmtData");
-    mgmt->frames = (Frame *)calloc(numPages, sizeof(Frame)); // allcate frames matadata
-    if (mgmt->frames == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for frames");
+// a victim is about to be replaced, dirty ones cost a write on the miss path
+static inline void countEviction(BM_MgmtData *mgmt, int frameIdx) {
+    if (ATOMIC_LOAD(&mgmt->frames[frameIdx].isDirty)) STAT_ADD(&mgmt->stats.dirtyEvictions, 1);
+    else STAT_ADD(&mgmt->stats.cleanEvictions, 1);
+}
+
+/** 
+* @brief replace a victim that has left the page table. In concurrent mode a dirty victim is written back
+*        without the pool latch: the policy forgets it and it stays pinned, and its key stays in writeBacks
+*        until the write is done so that a miss on the page waits for it instead of reading the old data.
+*        The caller holds the pool latch.
+* @param bm, input value, a buffer pool structure pointer
+* @param frameIdx, input value, the detached victim
+* @param unlatched, output value, set to true if the pool latch was dropped
+* @return RC, return code
+*/
+static RC evictVictim(BM_BufferPool *bm, int frameIdx, bool *unlatched) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    Frame *frame = &mgmt->frames[frameIdx];
+
+    countEviction(mgmt, frameIdx);
+    if (!mgmt->concurrent || !ATOMIC_LOAD(&frame->isDirty)) return replaceFrame(bm, frameIdx);
+
+    PageNumber key = frame->pageHandle.pageNum;
+    mgmt->policy->onEvict(bm, frameIdx);
+    mgmt->fixCounts[frameIdx] = 1; // keeps the CLOCK/FIFO scans and the writer thread off the frame
+    mgmt->writeBacks[mgmt->numWriteBacks++] = key;
+    unlatchPool(mgmt);
+    RC rc = flushFrame(bm, frameIdx, false);
+    latchPool(mgmt);
+    *unlatched = true;
+    for (int i = 0; i < mgmt->numWriteBacks; i++) {
+        if (mgmt->writeBacks[i] == key) {
+            mgmt->writeBacks[i] = mgmt->writeBacks[--mgmt->numWriteBacks];
+            break;
+        }
+    }
+    pthread_cond_broadcast(&mgmt->ioCond);
+    if (rc != RC_OK) return rc;
+
+    frame->pageHandle.pageNum = NO_PAGE;
+    mgmt->fixCounts[frameIdx] = 0;
+    frame->ioState = IO_NONE;
+    return RC_OK;
+}
+
+/** 
+* @brief find a frame for a page that is not resident: a free frame, or a victim that is written back
+*        and cleared. The caller holds the pool latch, which a dirty victim's write-back drops for a while:
+*        if the page was loaded meanwhile, or is itself a victim being written back, *frameIdx is -1
+*        and the caller looks the page up again.
+* @param bm, input value, a buffer pool structure pointer
+* @param pageNum, input value, the page that will be loaded
+* @param frameIdx, output value, the frame to load the page into, -1 if the page must be looked up again
+* @param strategy, input value, ring the frame is taken from and recorded in, NULL for the shared pool
+* @return RC, return code
+*/
+static RC reserveFrame(BM_BufferPool *bm, const PageNumber pageNum, int *frameIdx, BM_AccessStrategy *strategy) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+
+    *frameIdx = -1;
+    if (isWrittenBack(mgmt, pageNum)) {
+        // its new data is not in the file yet, read it once the write-back is done
+        STAT_ADD(&mgmt->stats.pinWaits, 1);
+        while (isWrittenBack(mgmt, pageNum)) pthread_cond_wait(&mgmt->ioCond, &mgmt->poolLatch);
+        return RC_OK;
+    }
+    if (mgmt->policy->onMiss != NULL) mgmt->policy->onMiss(bm, pageNum);
     
-    mgmt->numReadIO = 0;
-    mgmt->numWriteIO = 0;
-    mgmt->clockHand = 0;
-    mgmt->k = (strategy == RS_LRU_K) ? (stratData ? *(int *)stratData : 2) : 0; // set k for LRU-K
-    mgmt->globalTime = 0;
-    // initialize frames metadata
+    int slot = -1;
+    bool unlatched = false;
+    if (strategy != NULL) {
+        // a ring recycles the frame it loaded ringSize misses ago, if nobody else uses that page now
+        int ringSize = strategy->ringSize;
+        if (ringSize > bm->numPages / 4) ringSize = (bm->numPages / 4 > 0) ? bm->numPages / 4 : 1;
+        slot = strategy->current = (strategy->current + 1) % ringSize;
+        int f = strategy->frames[slot];
+        if (f >= 0 && f < bm->numPages && mgmt->frames[f].pageHandle.pageNum == strategy->pages[slot] 
+            && ATOMIC_LOAD(&mgmt->fixCounts[f]) == 0 && detachVictim(mgmt, f)) {
+            *frameIdx = f;
+            CHECK(evictVictim(bm, f, &unlatched));
+        }
+    }
+    if (*frameIdx == -1) *frameIdx = findFreeFrame(bm); // find a free frame
+    if (*frameIdx == -1) {
+        // if no free frame, select a victim frame to replace; retry if a concurrent hit pinned it
+        do {
+            *frameIdx = selectReplacementFrame(bm);
+            DEBUG_PRINT("no free frame, select a victim frame %d to replace\n", *frameIdx); // only for debug
+            if (*frameIdx < 0) 
+                THROW(RC_NO_FREE_FRAME, "No victim frame found, every frame is pinned");
+        } while (!detachVictim(mgmt, *frameIdx));
+
+        // a dirty victim is written on the read path, let the background writer catch up
+        if (mgmt->cleanerRunning && ATOMIC_LOAD(&mgmt->frames[*frameIdx].isDirty)) 
+            pthread_cond_signal(&mgmt->cleanerCond);
+        CHECK(evictVictim(bm, *frameIdx, &unlatched)); // replace the victim frame if dirty
+    }
+    if (unlatched) {
+        // another thread may have loaded the page or evicted it while the victim was written
+        latchStripe(mgmt, pageNum);
+        bool resident = (getFrameIndex(bm, pageNum) >= 0);
+        unlatchStripe(mgmt, pageNum);
+        if (resident || isWrittenBack(mgmt, pageNum)) {
+            releaseFreeFrame(mgmt, *frameIdx);
+            *frameIdx = -1;
+            return RC_OK;
+        }
+    }
+    if (slot != -1) {
+        strategy->frames[slot] = *frameIdx;
+        strategy->pages[slot] = pageNum;
+    }
+    return RC_OK;
+}
+
+/** 
+* @brief load a page that is not resident into a free or victim frame. The caller holds the pool latch,
+*        which is dropped during the read.
+* @param bm, input value, a buffer pool structure pointer
+* @param page, output value, a page handle structure pointer
+* @param key, input value, the page's key
+* @param strategy, input value, ring of frames for a bulk access, NULL for the shared pool
+* @return RC, return code
+*/
+static RC pinMiss(BM_BufferPool *bm, BM_PageHandle *page, const PageNumber key, BM_AccessStrategy *strategy) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    SM_FileHandle *fh = keyFile(mgmt, key);
+    PageNumber pageNum = keyPage(key);
+    if (fh->mgmtInfo == NULL) THROW(RC_FILE_HANDLE_NOT_INIT, "No page file to read the page from");
+    // if the page is not in the buffer pool, find a free frame or select a victim frame to replace
+    // DEBUG_PRINT("the page %d is not in the buffer pool, find a free frame or select a victim frame to replace\n", pageNum); // only for debug
+
+    int frameIdx;
+    RC rc = reserveFrame(bm, key, &frameIdx, strategy);
+    if (rc != RC_OK) return rc;
+    if (frameIdx < 0) return RC_PIN_AGAIN;
+
+    // publish the frame pinned and IO_PENDING like a prefetch, the read runs without the pool latch and
+    // a pin of the page meanwhile waits for it in waitForIO
+    Frame *frame = &mgmt->frames[frameIdx];
+    frame->pageHandle.pageNum = key;
+    frame->isDirty = false;
+    mgmt->fixCounts[frameIdx] = 1;
+    frame->ioState = mgmt->concurrent ? IO_PENDING : IO_NONE;
+    latchStripe(mgmt, key);
+    pageTableInsert(mgmt, frameIdx);
+    unlatchStripe(mgmt, key);
+    mgmt->policy->onLoad(bm, frameIdx);
+    unlatchPool(mgmt);
+
+    DEBUG_PRINT("read the page %d from pages file to frame %d\n", pageNum, frameIdx); // only for debug
+    // ensure the page exists in the page file, the size is checked under the file latch, other partitions may extend the file
+    latchFile(mgmt);
+    if (pageNum > fh->totalNumPages - 1) rc = ensureCapacity(pageNum + 1, fh);
+    if (rc == RC_OK) rc = readBlock(pageNum, fh, frame->pageHandle.data);
+    unlatchFile(mgmt);
+
+    latchPool(mgmt);
+    if (rc == RC_OK) STAT_ADD(&mgmt->stats.readIO, 1);
+    ATOMIC_STORE(&frame->ioState, (rc == RC_OK) ? IO_NONE : IO_FAILED);
+    if (mgmt->concurrent) pthread_cond_broadcast(&mgmt->ioCond);
+    if (rc != RC_OK) {
+        // 页面保持IO_FAILED，下一次pin在waitForIO中重读；放掉我们的pin
+        latchStripe(mgmt, key);
+        fixCountAdd(mgmt, frameIdx, -1);
+        mgmt->policy->onUnpin(bm, frameIdx);
+        unlatchStripe(mgmt, key);
+        wakeFrameWaiters(mgmt, true);
+        THROW(rc, "Failed to read block in pinPage()");
+    }
+
+    // update page handle
+    page->pageNum = pageNum;
+    page->data = frame->pageHandle.data;
+
+    DEBUG_PRINT("the page %d is pinned\n", key); // only for debug
+
+    return RC_OK;
+}
+
+/** 
+* @brief wait until a read into a frame we pinned is complete. If it failed, read the page here.
+*        The caller holds the pool latch.
+* @param bm, input value, a buffer pool structure pointer
+* @param frameIdx, input value, the pinned frame
+* @return RC, return code
+*/
+static RC waitForIO(BM_BufferPool *bm, int frameIdx) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    Frame *frame = &mgmt->frames[frameIdx];
+
+    if (frame->ioState == IO_PENDING) STAT_ADD(&mgmt->stats.pinWaits, 1);
+    while (frame->ioState == IO_PENDING) {
+        pthread_cond_wait(&mgmt->ioCond, &mgmt->poolLatch);
+    }
+    if (frame->ioState == IO_FAILED) {
+        latchFile(mgmt);
+        RC rc = readBlock(keyPage(frame->pageHandle.pageNum), keyFile(mgmt, frame->pageHandle.pageNum), frame->pageHandle.data);
+        unlatchFile(mgmt);
+        if (rc != RC_OK) THROW(rc, "Failed to read block in pinPage()");
+        STAT_ADD(&mgmt->stats.readIO, 1);
+        ATOMIC_STORE(&frame->ioState, IO_NONE);
+    }
+    return RC_OK;
+}
+
+/** 
+* @brief let a pin that found every frame pinned wait for an unpin. The caller holds the pool latch.
+*        The first call only registers the pin in frameWaiters and asks for one more look at the frames:
+*        an unpin that runs without the pool latch either shows in that look or sees the waiter and wakes it.
+*        Each later call waits for such a wake-up, the page is then looked up again since another pin may
+*        have loaded it meanwhile. The caller takes the pin out of frameWaiters once it is done.
+* @param bm, input value, a buffer pool structure pointer
+* @param waiting, input and output value, false before the first call, true once the pin is registered
+* @param deadline, input and output value, set by the first call unless the pool waits with PIN_WAIT_FOREVER
+* @return bool, true if the pin should look again, false if pins do not wait or the wait timed out
+*/
+static bool waitForFrame(BM_BufferPool *bm, bool *waiting, struct timespec *deadline) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (!mgmt->concurrent || (mgmt->pinWaitMs < 0 && mgmt->pinWaitMs != PIN_WAIT_FOREVER)) return false;
+
+    if (!*waiting) {
+        *waiting = true;
+        __atomic_add_fetch(&mgmt->frameWaiters, 1, __ATOMIC_SEQ_CST);
+        STAT_ADD(&mgmt->stats.frameWaits, 1);
+        if (mgmt->pinWaitMs == PIN_WAIT_FOREVER) return true;
+        clock_gettime(CLOCK_REALTIME, deadline);
+        deadline->tv_sec += mgmt->pinWaitMs / 1000;
+        deadline->tv_nsec += (long)(mgmt->pinWaitMs % 1000) * 1000000L;
+        if (deadline->tv_nsec >= 1000000000L) {
+            deadline->tv_sec++;
+            deadline->tv_nsec -= 1000000000L;
+        }
+        return true;
+    }
+    if (mgmt->pinWaitMs == PIN_WAIT_FOREVER) return pthread_cond_wait(&mgmt->frameCond, &mgmt->poolLatch) == 0;
+    return pthread_cond_timedwait(&mgmt->frameCond, &mgmt->poolLatch, deadline) != ETIMEDOUT;
+}
+
+/*----------------------prefetch functions ----------------------*/
+/** 
+* @brief queue a prefetch request for the I/O thread, the caller holds prefetchLatch.
+*        The request is dropped when the queue is full, prefetching is only a hint.
+* @param mgmt, input value, a buffer pool metadata structure pointer
+* @param capacity, input value, number of entries in prefetchQueue
+* @param pageNum, input value, the page to prefetch
+* @return bool, false if the queue is full
+*/
+static bool prefetchQueuePush(BM_MgmtData *mgmt, int capacity, PageNumber pageNum) {
+    if (mgmt->prefetchCount == capacity) return false;
+    mgmt->prefetchQueue[(mgmt->prefetchHead + mgmt->prefetchCount) % capacity] = pageNum;
+    mgmt->prefetchCount++;
+    return true;
+}
+
+/** 
+* @brief load a run of consecutive pages for the I/O thread, or for prefetchRange without one. The frames are
+*        reserved and published under the pool latch with the pages pinned and marked IO_PENDING, then each
+*        stretch of pages that were not resident is read with one readBlocks without the pool latch, so that
+*        hits and misses on other pages go on meanwhile. Pages that are resident, past the end of the file
+*        or find no frame are skipped, prefetching is only a hint; no pin is counted or traced.
+* @param bm, input value, a buffer pool structure pointer
+* @param firstKey, input value, key of the first page
+* @param numPages, input value, number of pages, at most PREFETCH_MAX_RUN, all of the same file
+*/
+static void prefetchLoadRun(BM_BufferPool *bm, PageNumber firstKey, int numPages) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    SM_FileHandle *fh = keyFile(mgmt, firstKey);
+    int frameIdx[PREFETCH_MAX_RUN];
+    SM_PageHandle data[PREFETCH_MAX_RUN];
+
+    latchPool(mgmt);
+    latchFile(mgmt);
+    int totalNumPages = (fh->mgmtInfo != NULL) ? fh->totalNumPages : 0;
+    unlatchFile(mgmt);
+    bool reserving = true;
     for (int i = 0; i < numPages; i++) {
-        mgmt->frames[i].isDirty = false;
-        mgmt->frames[i].fixCount = 0;
-        mgmt->frames[i].enterCounter = 0;
-        mgmt->frames[i].lastAccessCounter = 0;
-        mgmt->frames[i].refCount = 0;
-        mgmt->frames[i].clockBit = 0;
-        mgmt->frames[i].pageHandle.pageNum = NO_PAGE; // indicate frame is free
-        mgmt->frames[i].pageHandle.data = (char *)malloc(PAGE_SIZE); // allcate real frame for page data
-        if (mgmt->frames[i].pageHandle.data == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in initBufferPool() for frame data");
-        if (strategy == RS_LRU_K) {
-            mgmt->frames[i].accessTimes = (long unsigned int *)malloc(mgmt->k * sizeof(long unsigned int));
-            mgmt->frames[i].accessCount = 0;
+        PageNumber key = firstKey + i;
+        latchStripe(mgmt, key);
+        bool resident = (getFrameIndex(bm, key) >= 0);
+        unlatchStripe(mgmt, key);
+        frameIdx[i] = -1;
+        // resident or in flight, past the end of the file, or every frame is pinned
+        if (resident || keyPage(key) >= totalNumPages || !reserving) continue;
+        reserving = (reserveFrame(bm, key, &frameIdx[i], NULL) == RC_OK);
+        if (!reserving || frameIdx[i] < 0) {
+            frameIdx[i] = -1;
+            continue;
         }
+
+        Frame *frame = &mgmt->frames[frameIdx[i]];
+        frame->pageHandle.pageNum = key;
+        frame->isDirty = false;
+        mgmt->fixCounts[frameIdx[i]] = 1; // our pin keeps the frame from being replaced during the read
+        frame->ioState = IO_PENDING;
+        latchStripe(mgmt, key);
+        pageTableInsert(mgmt, frameIdx[i]);
+        unlatchStripe(mgmt, key);
+        mgmt->policy->onLoad(bm, frameIdx[i]);
+        data[i] = frame->pageHandle.data;
     }
+    unlatchPool(mgmt);
 
-    // open the page file
-    if (openPageFile((char *)pageFileName, &mgmt->fileHandle) != RC_OK) {
-        // file does not exist, throw error
-        THROW(RC_FILE_NOT_FOUND, "Page file not found");
+    for (int first = 0, last; first < numPages; first = last) {
+        for (last = first + 1; last < numPages && (frameIdx[last] >= 0) == (frameIdx[first] >= 0); last++) ;
+        if (frameIdx[first] < 0) continue;
+
+        latchFile(mgmt);
+        RC rc = readBlocks(keyPage(firstKey + first), last - first, fh, &data[first]);
+        unlatchFile(mgmt);
+
+        latchPool(mgmt);
+        if (rc == RC_OK) STAT_ADD(&mgmt->stats.readIO, last - first);
+        for (int i = first; i < last; i++) {
+            ATOMIC_STORE(&mgmt->frames[frameIdx[i]].ioState, (rc == RC_OK) ? IO_NONE : IO_FAILED);
+        }
+        if (mgmt->concurrent) pthread_cond_broadcast(&mgmt->ioCond);
+        unlatchPool(mgmt);
+
+        for (int i = first; i < last; i++) {
+            unpinKey(bm, firstKey + i);
+        }
     }
+}
+
+/** 
+* @brief I/O thread, loads queued prefetch requests in order
+* @param arg, input value, the buffer pool
+*/
+static void *prefetcherMain(void *arg) {
+    BM_BufferPool *bm = (BM_BufferPool *)arg;
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
 
-    bm->mgmtData = mgmt;
-#ifdef DEBUG
-    showBufferPool(bm);// show buffer pool meta data for debug
-    showFrames(bm); // show frames meta data for debug
-#endif
-    return RC_OK;
+    pthread_mutex_lock(&mgmt->prefetchLatch);
+    while (!mgmt->prefetcherStop) {
+        if (mgmt->prefetchCount == 0) {
+            pthread_cond_wait(&mgmt->prefetchCond, &mgmt->prefetchLatch);
+            continue;
+        }
+        // take the run of consecutive pages at the head of the queue, it is read with one readBlocks
+        PageNumber firstKey = mgmt->prefetchQueue[mgmt->prefetchHead];
+        int numPages = 0;
+        do {
+            mgmt->prefetchHead = (mgmt->prefetchHead + 1) % mgmt->capacity;
+            mgmt->prefetchCount--;
+            numPages++;
+        } while (mgmt->prefetchCount > 0 && numPages < PREFETCH_MAX_RUN
+                 && mgmt->prefetchQueue[mgmt->prefetchHead] == firstKey + numPages
+                 && keyFileId(firstKey + numPages) == keyFileId(firstKey));
+        pthread_mutex_unlock(&mgmt->prefetchLatch);
+        prefetchLoadRun(bm, firstKey, numPages);
+        pthread_mutex_lock(&mgmt->prefetchLatch);
+    }
+    pthread_mutex_unlock(&mgmt->prefetchLatch);
+    return NULL;
 }
 
 /** 
-* @brief flush all dirty pages to disk, close the page file, release resources
+* @brief wake the I/O thread, starting it on first use. The caller holds prefetchLatch.
 * @param bm, input value, a buffer pool structure pointer
 * @return RC, return code
 */
-// 修复shutdownBufferPool函数中的Frame成员访问
-RC shutdownBufferPool(BM_BufferPool *const bm) {
-    // 进行最基本的参数检查
-    if (bm == NULL) {
-        DEBUG_PRINT("Warning: shutdownBufferPool called with NULL buffer pool\n");
-        return RC_OK;
+static RC wakePrefetcher(BM_BufferPool *bm) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+
+    if (!mgmt->prefetcherRunning) {
+        // the thread runs on the pool's own handle, an attached handle may be gone before the pool
+        if (pthread_create(&mgmt->prefetcher, NULL, prefetcherMain, mgmt->files[0].view) != 0) 
+            THROW(RC_UNVALID_HANDLE, "Failed to start the I/O thread");
+        mgmt->prefetcherRunning = true;
     }
+    pthread_cond_signal(&mgmt->prefetchCond);
+    return RC_OK;
+}
 
-    // 保存文件名指针，稍后释放
-    char *pageFileToFree = bm->pageFile;
-    bm->pageFile = NULL; // 防止重复释放
+// queue one read-ahead page, a partitioned pool hands it to the I/O thread of the page's partition
+static bool readAheadQueue(BM_BufferPool *bm, PageNumber pageNum) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (mgmt->partitions == NULL) return prefetchQueuePush(mgmt, mgmt->capacity, pageNum);
+    return prefetchPage(partitionOf(mgmt, pageNum), pageNum) == RC_OK;
+}
 
-    // 如果管理数据不为空，进行资源释放
-    if (bm->mgmtData != NULL) {
-        BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
-        
-        // 1. 关闭页面文件（如果文件句柄有效）
-        if (mgmt->fileHandle.fileName != NULL && mgmt->fileHandle.mgmtInfo != NULL) {
-            closePageFile(&mgmt->fileHandle);
-            // 关闭后立即置空，避免后续操作再次访问
-            mgmt->fileHandle.mgmtInfo = NULL;
-        }
-        
-        // 2. 释放每个帧中的数据缓冲区和LRU-K的accessTimes数组
-        if (mgmt->frames != NULL) {
-            for (int i = 0; i < bm->numPages; i++) {
-                // 修复：使用正确的路径访问数据缓冲区
-                if (mgmt->frames[i].pageHandle.data != NULL) {
-                    free(mgmt->frames[i].pageHandle.data);
-                    mgmt->frames[i].pageHandle.data = NULL;
-                }
-                
-                // 释放LRU-K的accessTimes数组
-                if (mgmt->frames[i].accessTimes != NULL) {
-                    free(mgmt->frames[i].accessTimes);
-                    mgmt->frames[i].accessTimes = NULL;
-                }
-            }
-            
-            // 3. 释放帧数组
-            free(mgmt->frames);
-            mgmt->frames = NULL;
-        }
-        
-        // 4. 释放管理数据结构体
-        free(mgmt);
-        bm->mgmtData = NULL;
+/** 
+* @brief sequential pin detector: once READ_AHEAD_TRIGGER pins in a row each asked for the page after
+*        the previous one, keep the next readAheadPages pages queued for the I/O thread.
+*        Pins of other pages reset the run, repeated pins of the same page do not.
+* @param bm, input value, a buffer pool structure pointer
+* @param pageNum, input value, the page just pinned
+*/
+static void readAhead(BM_BufferPool *bm, PageNumber pageNum) {
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+
+    pthread_mutex_lock(&mgmt->prefetchLatch);
+    if (pageNum == mgmt->seqLast + 1) {
+        mgmt->seqRun++;
+    } else if (pageNum != mgmt->seqLast) {
+        mgmt->seqRun = 0;
+        mgmt->readAheadNext = 0;
     }
-    
-    // 5. 最后释放页面文件名
-    if (pageFileToFree != NULL) {
-        free(pageFileToFree);
+    mgmt->seqLast = pageNum;
+
+    if (mgmt->seqRun >= READ_AHEAD_TRIGGER) {
+        PageNumber next = (mgmt->readAheadNext > pageNum) ? mgmt->readAheadNext : pageNum + 1;
+        PageNumber last = pageNum + mgmt->readAheadPages;
+        while (next <= last && readAheadQueue(bm, next)) next++;
+        if (next > mgmt->readAheadNext) {
+            mgmt->readAheadNext = next;
+            if (mgmt->partitions == NULL) wakePrefetcher(bm);
+        }
     }
-    
-    DEBUG_PRINT("shutdownBufferPool: all resources properly released\n");
-    return RC_OK;
+    pthread_mutex_unlock(&mgmt->prefetchLatch);
 }
 
 /** 
-* @brief flush all dirty pages in the buffer pool to page file
+* @brief pin a page, a miss takes its frame from the strategy's ring if there is one
 * @param bm, input value, a buffer pool structure pointer
+* @param page, output value, a page handle structure pointer
+* @param pageNum, input value, a page number
+* @param strategy, input value, ring of frames for a bulk access, NULL for the shared pool
 * @return RC, return code
 */
-RC forceFlushPool(BM_BufferPool *const bm) {
-    if (bm == NULL) {
-        DEBUG_PRINT("Warning: forceFlushPool: bm == NULL\n");
-        return RC_OK;
-    }
+static RC pinPageWith(BM_BufferPool *bm, BM_PageHandle *page, const PageNumber pageNum, BM_AccessStrategy *strategy) {
 
-    if (bm->mgmtData == NULL) {
-        DEBUG_PRINT("Warning: forceFlushPool: mgmtData is NULL\n");
-        return RC_OK;
+    if (bm == NULL || bm->mgmtData == NULL || page == NULL || pageNum < 0 || pageNum >= MAX_FILE_PAGES) 
+        THROW(RC_FILE_HANDLE_NOT_INIT, "Invalid buffer pool, page handle or page number");
+
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (mgmt->partitions != NULL) {
+        // the page's partition pins it, read-ahead watches the pins of every partition here
+        RC rc = pinPageWith(partitionOf(mgmt, pageNum), page, pageNum, strategy);
+        if (rc == RC_OK && mgmt->readAheadPages > 0) readAhead(bm, pageNum);
+        return rc;
     }
+    unsigned long long start = nowNs();
+    PageNumber key = pageKey(bm, pageNum);
+    struct timespec deadline;
+    bool waiting = false, retry;
+    int frameIdx;
+    RC rc;
+    do {
+        bool poolLatched = hitNeedsPoolLatch(bm);
+        if (poolLatched) latchPool(mgmt);
 
-    // 遍历所有帧的索引（0到numPages-1），直接刷新每个帧
-    for (int frameIdx = 0; frameIdx < bm->numPages; frameIdx++) {
-        RC rc = flushFrame(bm, frameIdx);
-        if (rc != RC_OK) {
-            // 记录错误但继续刷新其他页
-            DEBUG_PRINT("Warning: flushFrame failed for frame %d: %s\n", frameIdx, errorMessage(rc));
-            // 不立即返回错误，继续尝试刷新其他页面
+        latchStripe(mgmt, key);
+        frameIdx = getFrameIndex(bm, key);
+        if (frameIdx < 0 && !poolLatched) {
+            // misses are serialized by the pool latch, another thread may load the page while we wait for it
+            unlatchStripe(mgmt, key);
+            latchPool(mgmt);
+            poolLatched = true;
+            latchStripe(mgmt, key);
+            frameIdx = getFrameIndex(bm, key);
         }
-    }
+        // if the page is already in the buffer pool
+        if (frameIdx >= 0) pinHit(bm, page, frameIdx);
+        unlatchStripe(mgmt, key);
 
-    return RC_OK;
+        rc = RC_OK;
+        if (frameIdx < 0) rc = pinMiss(bm, page, key, strategy); // the page table only changes under the pool latch
+        else if (ATOMIC_LOAD(&mgmt->frames[frameIdx].ioState) != IO_NONE) {
+            // the page's read, by a miss or a prefetch, is still in flight
+            if (!poolLatched) latchPool(mgmt);
+            poolLatched = true;
+            rc = waitForIO(bm, frameIdx);
+        }
+        // every frame is pinned: in concurrent mode wait for an unpin instead of failing
+        retry = (rc == RC_PIN_AGAIN || (rc == RC_NO_FREE_FRAME && waitForFrame(bm, &waiting, &deadline)));
+        if (poolLatched) unlatchPool(mgmt);
+    } while (retry);
+    if (waiting) __atomic_sub_fetch(&mgmt->frameWaiters, 1, __ATOMIC_SEQ_CST);
+
+    if (rc != RC_OK && frameIdx >= 0) unpinKey(bm, key);
+    if (rc == RC_OK) {
+        countPin(mgmt, frameIdx < 0, nowNs() - start);
+        traceAccess(mgmt, key, TRACE_PIN);
+    }
+    if (rc == RC_OK && mgmt->readAheadPages > 0) readAhead(bm, key);
+    return rc;
 }
 
 /** 
-* @brief mark a page as dirty
+* @brief load a page to buffer pool frame, if frame is existing, increase fix count...
 * @param bm, input value, a buffer pool structure pointer
-* @param page, input value, a page handle structure pointer
+* @param page, output value, a page handle structure pointer
+* @param pageNum, input value, a page number
 * @return RC, return code
 */
-RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page) {
+RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum) {
+    return pinPageWith(bm, page, pageNum, NULL);
+}
 
-    if (bm == NULL || bm->mgmtData == NULL || page == NULL) THROW(RC_UNVALID_HANDLE, "markDirty: Invalid buffer pool or page handle");
+/** 
+* @brief pin a page for a bulk access: a miss recycles a frame of the strategy's ring
+*        instead of evicting the shared working set, a hit is an ordinary pin
+* @param bm, input value, a buffer pool structure pointer
+* @param page, output value, a page handle structure pointer
+* @param pageNum, input value, a page number
+* @param strategy, input value, ring from createAccessStrategy, NULL behaves like pinPage
+* @return RC, return code
+*/
+RC pinPageWithStrategy(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum, 
+                       BM_AccessStrategy *strategy) {
+    return pinPageWith(bm, page, pageNum, strategy);
+}
 
-    int frameIdx = getFrameIndex(bm, page->pageNum);
-    if (frameIdx == -1) THROW(RC_UNVALID_HANDLE, "Can not mark page as dirty, Page not in buffer pool");
+/** 
+* @brief pin a page, then latch its frame
+* @param bm, input value, a buffer pool structure pointer
+* @param page, output value, a page handle structure pointer
+* @param pageNum, input value, a page number
+* @param exclusive, input value, true for a writer latch, false for a reader latch
+* @param strategy, input value, ring of frames for a bulk access, NULL for the shared pool
+* @return RC, return code
+*/
+static RC pinPageLatched(BM_BufferPool *bm, BM_PageHandle *page, const PageNumber pageNum, bool exclusive, 
+                         BM_AccessStrategy *strategy) {
+    RC rc = pinPageWith(bm, page, pageNum, strategy);
+    if (rc != RC_OK) return rc;
 
+    // the pin keeps the page in its frame, so the lookup stays valid after the stripe latch is gone
     BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
-    mgmt->frames[frameIdx].isDirty = true;
+    if (mgmt->partitions != NULL) {
+        bm = partitionOf(mgmt, pageNum);
+        mgmt = (BM_MgmtData *)bm->mgmtData;
+    }
+    PageNumber key = pageKey(bm, pageNum);
+    latchStripe(mgmt, key);
+    int frameIdx = getFrameIndex(bm, key);
+    unlatchStripe(mgmt, key);
+    latchFrame(mgmt, frameIdx, exclusive);
     return RC_OK;
 }
 
 /** 
-* @brief release a frame in the buffer pool, if needed, write back to page file.
+* @brief pin a page for reading, several readers can hold the same page at once
 * @param bm, input value, a buffer pool structure pointer
-* @param page, input value, a page handle structure pointer
+* @param page, output value, a page handle structure pointer
+* @param pageNum, input value, a page number
 * @return RC, return code
 */
-RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page) {
+RC pinPageShared(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum) {
+    return pinPageLatched(bm, page, pageNum, false, NULL);
+}
 
-    if (bm == NULL || bm->mgmtData == NULL || page == NULL) THROW(RC_UNVALID_HANDLE, "Invalid buffer pool or page handle");
+/** 
+* @brief pin a page for reading during a bulk access, see pinPageShared and pinPageWithStrategy
+* @param bm, input value, a buffer pool structure pointer
+* @param page, output value, a page handle structure pointer
+* @param pageNum, input value, a page number
+* @param strategy, input value, ring from createAccessStrategy
+* @return RC, return code
+*/
+RC pinPageSharedWithStrategy(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum, 
+                             BM_AccessStrategy *strategy) {
+    return pinPageLatched(bm, page, pageNum, false, strategy);
+}
 
-    int frameIdx = getFrameIndex(bm, page->pageNum);
-    if (frameIdx == -1) THROW(RC_UNVALID_HANDLE, "Page not in buffer pool");
+/** 
+* @brief pin a page for writing, the caller is the only one latching the page
+* @param bm, input value, a buffer pool structure pointer
+* @param page, output value, a page handle structure pointer
+* @param pageNum, input value, a page number
+* @return RC, return code
+*/
+RC pinPageExclusive(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum) {
+    return pinPageLatched(bm, page, pageNum, true, NULL);
+}
 
-    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
-    if (mgmt->frames[frameIdx].fixCount > 0) 
-        mgmt->frames[frameIdx].fixCount--;
+/** 
+* @brief pin a page the caller is creating: a miss hands out a zeroed dirty frame without reading the file,
+*        which is extended only when the page is first written back. A resident page is pinned as it is.
+*        The page comes back exclusively latched, release it with unpinPageLatched.
+* @param bm, input value, a buffer pool structure pointer
+* @param page, output value, a page handle structure pointer
+* @param pageNum, input value, a page number, usually the first one past the end of the file
+* @return RC, return code
+*/
+RC pinNewPage(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum) {
 
-    gAccessCounter++; // increment global access counter every time a page is accessed
+    if (bm == NULL || bm->mgmtData == NULL || page == NULL || pageNum < 0 || pageNum >= MAX_FILE_PAGES) 
+        THROW(RC_FILE_HANDLE_NOT_INIT, "Invalid buffer pool, page handle or page number");
 
-    switch(bm->strategy)
-    {
-        case RS_LFU: {
-            mgmt->frames[frameIdx].refCount++;  // 访问时递增引用计数
-            break;
-        }
-        case RS_LRU:{
-            mgmt->frames[frameIdx].lastAccessCounter = gAccessCounter;
-            break;
-        }
-        case RS_LRU_K:{
-            recordAccess(bm, frameIdx);
-            break;
-        }
-        case RS_CLOCK:{
-            mgmt->frames[frameIdx].clockBit = 1;
-            break;
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (mgmt->partitions != NULL) return pinNewPage(partitionOf(mgmt, pageNum), page, pageNum);
+    unsigned long long start = nowNs();
+    PageNumber key = pageKey(bm, pageNum);
+    struct timespec deadline;
+    bool waiting = false, hit;
+    int frameIdx;
+    RC rc;
+    latchPool(mgmt);
+    do {
+        latchStripe(mgmt, key);
+        frameIdx = getFrameIndex(bm, key);
+        hit = (frameIdx >= 0);
+        if (hit) pinHit(bm, page, frameIdx);
+        unlatchStripe(mgmt, key);
+
+        if (hit) {
+            rc = (ATOMIC_LOAD(&mgmt->frames[frameIdx].ioState) != IO_NONE) ? waitForIO(bm, frameIdx) : RC_OK;
+        } else {
+            rc = reserveFrame(bm, key, &frameIdx, NULL);
         }
-        default:
-            DEBUG_PRINT("Can not support %d stratagy\n",bm->strategy);
+        // every frame is pinned: wait for an unpin like pinPage, the wait keeps the pool latch afterwards;
+        // no frame and no error: the pool latch was dropped for a victim's write-back, look again
+    } while ((rc == RC_OK && frameIdx < 0) || (rc == RC_NO_FREE_FRAME && waitForFrame(bm, &waiting, &deadline)));
+    if (waiting) __atomic_sub_fetch(&mgmt->frameWaiters, 1, __ATOMIC_SEQ_CST);
+    if (rc == RC_OK && !hit) {
+        Frame *frame = &mgmt->frames[frameIdx];
+        memset(frame->pageHandle.data, 0, PAGE_SIZE);
+        frame->pageHandle.pageNum = key;
+        mgmt->fixCounts[frameIdx] = 1;
+        frame->isDirty = false;
+        setDirty(mgmt, frameIdx); // the page is only in memory until it is written back
+        // kept by the file's owner like the file handle, so that every partition extends to the same end
+        latchFile(mgmt);
+        PoolFile *file = &mgmt->fileOwner->files[keyFileId(key)];
+        if (pageNum >= file->newPagesEnd) file->newPagesEnd = pageNum + 1;
+        unlatchFile(mgmt);
+        latchStripe(mgmt, key);
+        pageTableInsert(mgmt, frameIdx);
+        unlatchStripe(mgmt, key);
+        mgmt->policy->onLoad(bm, frameIdx);
+        page->pageNum = pageNum;
+        page->data = frame->pageHandle.data;
+    }
+    unlatchPool(mgmt);
+
+    if (rc != RC_OK) {
+        if (hit) unpinKey(bm, key);
+        return rc;
     }
+    countPin(mgmt, !hit, nowNs() - start);
+    traceAccess(mgmt, key, TRACE_PIN);
+    latchFrame(mgmt, frameIdx, true);
     return RC_OK;
 }
 
 /** 
-* @brief write back a page to pages file
+* @brief release the latch taken by pinPageShared/pinPageExclusive, then unpin the page
 * @param bm, input value, a buffer pool structure pointer
 * @param page, input value, a page handle structure pointer
 * @return RC, return code
 */
-RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page) {
+RC unpinPageLatched(BM_BufferPool *const bm, BM_PageHandle *const page) {
+    if (bm == NULL || bm->mgmtData == NULL || page == NULL) THROW(RC_UNVALID_HANDLE, "Invalid buffer pool or page handle");
 
-    if (bm == NULL || bm->mgmtData == NULL || page == NULL) THROW(RC_FILE_HANDLE_NOT_INIT, "Invalid buffer pool or page handle");
-    
-    int frameIdx = getFrameIndex(bm, page->pageNum);
-    if (frameIdx < 0) THROW(RC_READ_NON_EXISTING_PAGE, "Page not in buffer pool");
-    
-    return flushFrame(bm, frameIdx);
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (mgmt->partitions != NULL) return unpinPageLatched(partitionOf(mgmt, page->pageNum), page);
+    PageNumber key = pageKey(bm, page->pageNum);
+    latchStripe(mgmt, key);
+    int frameIdx = getFrameIndex(bm, key);
+    unlatchStripe(mgmt, key);
+    if (frameIdx == -1) THROW(RC_UNVALID_HANDLE, "Page not in buffer pool");
+
+    unlatchFrame(mgmt, frameIdx);
+    return unpinPage(bm, page);
 }
 
 /** 
-* @brief load a page to buffer pool frame, if frame is existing, increase fix count...
-* @param bm, input value, a buffer pool structure pointer
-* @param page, output value, a page handle structure pointer
-* @param pageNum, input value, a page number
+* @brief create a ring of frames for a bulk access such as a sequential scan. The ring is used with
+*        one buffer pool and by one thread at a time, and is capped at a quarter of the pool.
+* @param strategy, output value, the new ring
+* @param ringSize, input value, number of frames the bulk access may occupy
 * @return RC, return code
 */
-RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum) {
+RC createAccessStrategy(BM_AccessStrategy **strategy, int ringSize) {
+    if (strategy == NULL || ringSize <= 0) THROW(RC_UNVALID_HANDLE, "Invalid access strategy or ring size");
 
-    if (bm == NULL || bm->mgmtData == NULL || page == NULL || pageNum < 0) 
-        THROW(RC_FILE_HANDLE_NOT_INIT, "Invalid buffer pool, page handle or page number");
+    BM_AccessStrategy *s = (BM_AccessStrategy *)malloc(sizeof(BM_AccessStrategy));
+    if (s == NULL) THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in createAccessStrategy()");
+    s->ringSize = ringSize;
+    s->current = -1;
+    s->frames = (int *)malloc(ringSize * sizeof(int));
+    s->pages = (PageNumber *)malloc(ringSize * sizeof(PageNumber));
+    if (s->frames == NULL || s->pages == NULL) {
+        free(s->frames);
+        free(s->pages);
+        free(s);
+        THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in createAccessStrategy()");
+    }
+    for (int i = 0; i < ringSize; i++) {
+        s->frames[i] = -1;
+        s->pages[i] = NO_PAGE;
+    }
+    *strategy = s;
+    return RC_OK;
+}
 
-    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+/** 
+* @brief release a ring, its frames stay in the pool as ordinary pages
+* @param strategy, input value, the ring
+* @return RC, return code
+*/
+RC freeAccessStrategy(BM_AccessStrategy *strategy) {
+    if (strategy == NULL) return RC_OK;
+    free(strategy->frames);
+    free(strategy->pages);
+    free(strategy);
+    return RC_OK;
+}
 
-    int frameIdx = getFrameIndex(bm, pageNum);
+/** 
+* @brief load a page into an unpinned frame. In concurrent mode the request is queued for the I/O thread
+*        and the call does not wait for the read.
+* @param bm, input value, a buffer pool structure pointer
+* @param pageNum, input value, a page number, pages past the end of the file are ignored
+* @return RC, return code
+*/
+RC prefetchPage(BM_BufferPool *const bm, const PageNumber pageNum) {
+    return prefetchRange(bm, pageNum, 1);
+}
 
-    gAccessCounter++; // increment global access counter every time a page is accessed
+/** 
+* @brief load numPages consecutive pages into unpinned frames, see prefetchPage
+* @param bm, input value, a buffer pool structure pointer
+* @param firstPage, input value, the first page number
+* @param numPages, input value, number of pages
+* @return RC, return code
+*/
+RC prefetchRange(BM_BufferPool *const bm, const PageNumber firstPage, const int numPages) {
 
-    // if the page is already in the buffer pool
-    if (frameIdx >= 0) {
-        // DEBUG_PRINT("the page %d is already in the buffer pool\n", pageNum); // only for debug
+    if (bm == NULL || bm->mgmtData == NULL || firstPage < 0 || numPages < 0 || firstPage > MAX_FILE_PAGES - numPages) 
+        THROW(RC_UNVALID_HANDLE, "Invalid buffer pool or page range");
 
-        mgmt->frames[frameIdx].fixCount++; // increase fix count
-        mgmt->frames[frameIdx].lastAccessCounter = gAccessCounter; // update last access time
-        mgmt->frames[frameIdx].refCount++; // increase ref count
-        mgmt->frames[frameIdx].clockBit = 1; // set clock bit
-        
-        page->pageNum = pageNum;
-        page->data = mgmt->frames[frameIdx].pageHandle.data;
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    RC rc = RC_OK;
+    for (int i = 0; i < numPages && mgmt->partitions != NULL && rc == RC_OK; i++) {
+        rc = prefetchPage(partitionOf(mgmt, firstPage + i), firstPage + i);
     }
-    else{
-        // if the page is not in the buffer pool, find a free frame or select a victim frame to replace
-        // DEBUG_PRINT("the page %d is not in the buffer pool, find a free frame or select a victim frame to replace\n", pageNum); // only for debug
-        
-        gLoadCounter++; // increment global load counter every time a page is loaded
-        
-        frameIdx = findFreeFrame(bm); // find a free frame
-        if (frameIdx == -1) {
-            // if no free frame, select a victim frame to replace
-            frameIdx = selectReplacementFrame(bm);
-            DEBUG_PRINT("no free frame, select a victim frame %d to replace\n", frameIdx); // only for debug
-            if (frameIdx == -1) 
-                THROW(RC_PAGE_NOT_FOUND, "No victim frame found");
-
-            CHECK(replaceFrame(bm, frameIdx)); // replace the victim frame if dirty
-        }
-
-        DEBUG_PRINT("ensure the page %d exists in the page file\n", pageNum); // only for debug
-        // ensure the page exists in the page file
-        if (pageNum > mgmt->fileHandle.totalNumPages - 1) 
-        {
-            int pagesToAdd = pageNum - (mgmt->fileHandle.totalNumPages - 1);
-            for (int i = 0; i < pagesToAdd; i++) {
-                CHECK(appendEmptyBlock(&mgmt->fileHandle));
-            }
-        }
-
-        DEBUG_PRINT("read the page %d from pages file to frame %d\n", pageNum, frameIdx); // only for debug
-        // read the page from pages file
-        // 修复：使用goto语句确保在任何路径下都释放pageData
-        SM_PageHandle pageData = (SM_PageHandle)malloc(PAGE_SIZE);
-        if (pageData == NULL) 
-            THROW(RC_MEMORY_ALLOC_FAILED, "Memory allocation failed in pinPage() for pageData");
-    
-        mgmt->numReadIO++;
-        RC rc = readBlock(pageNum, &mgmt->fileHandle, pageData);
-        if (rc != RC_OK) {
-            free(pageData);  // 确保在出错时释放内存
-            THROW(rc, "Failed to read block in pinPage()");
+    if (mgmt->partitions != NULL) return rc;
+    if (mgmt->concurrent) {
+        pthread_mutex_lock(&mgmt->prefetchLatch);
+        for (int i = 0; i < numPages; i++) {
+            if (!prefetchQueuePush(mgmt, mgmt->capacity, pageKey(bm, firstPage + i))) break; // queue full, drop the rest
         }
-    
-        // DEBUG_PRINT("reset the frame metadata\n"); // only for debug
-        // update frame metadata
-        Frame *frame = &mgmt->frames[frameIdx];
-        frame->pageHandle.pageNum = pageNum;
-        frame->isDirty = false;
-        frame->fixCount = 1;
-
-        memcpy(frame->pageHandle.data, pageData, PAGE_SIZE); // 复制页面数据
-        free(pageData);
-        pageData = NULL;
-
-        // according to the replacement strategy to update access info
-        switch (bm->strategy) {
-            case RS_FIFO:
-                // FIFO: 
-                frame->enterCounter = gLoadCounter;
-                break;
-            case RS_LRU:
-                frame->lastAccessCounter = gAccessCounter; // 更新最近访问时间
-                break;
-            case RS_CLOCK:
-                frame->clockBit = 1; // 标记为被引用
-                break;
-            case RS_LFU:
-                frame->refCount = 1; // 增加引用计数
-                break;
-            case RS_LRU_K: 
-                // 更新访问历史（保留最近k次访问）
-                recordAccess(bm, frameIdx);
-                break;
-
-            default:
-                break;
-        }
-
-        // update page handle
-        page->pageNum = pageNum;
-        page->data = frame->pageHandle.data;
-
-        DEBUG_PRINT("the page %d is pinned\n", pageNum); // only for debug
+        if (numPages > 0) rc = wakePrefetcher(bm);
+        pthread_mutex_unlock(&mgmt->prefetchLatch);
+        return rc;
     }
 
+    // without an I/O thread the pages are loaded here, in runs like the I/O thread loads them
+    for (int i = 0; i < numPages; i += PREFETCH_MAX_RUN) {
+        prefetchLoadRun(bm, pageKey(bm, firstPage + i), (numPages - i < PREFETCH_MAX_RUN) ? numPages - i : PREFETCH_MAX_RUN);
+    }
     return RC_OK;
 }
 
@@ -769,10 +4477,11 @@ RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber
 PageNumber *getFrameContents(BM_BufferPool *const bm) {
     if (bm == NULL || bm->mgmtData == NULL) return NULL;
 
-    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
     PageNumber *contents = (PageNumber *)malloc(bm->numPages * sizeof(PageNumber));
     for (int i = 0; i < bm->numPages; i++) {
-        contents[i] = mgmt->frames[i].pageHandle.pageNum;
+        int frameIdx = i;
+        BM_MgmtData *owner = frameAt(bm, &frameIdx);
+        contents[i] = keyPage(owner->frames[frameIdx].pageHandle.pageNum);
     }
     return contents;
 }
@@ -785,10 +4494,11 @@ PageNumber *getFrameContents(BM_BufferPool *const bm) {
 bool *getDirtyFlags(BM_BufferPool *const bm) {
     if (bm == NULL || bm->mgmtData == NULL) return NULL;
 
-    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
     bool *dirtyFlags = (bool *)malloc(bm->numPages * sizeof(bool));
     for (int i = 0; i < bm->numPages; i++) {
-        dirtyFlags[i] = mgmt->frames[i].isDirty;
+        int frameIdx = i;
+        BM_MgmtData *owner = frameAt(bm, &frameIdx);
+        dirtyFlags[i] = ATOMIC_LOAD(&owner->frames[frameIdx].isDirty);
     }
     return dirtyFlags;
 }
@@ -801,10 +4511,11 @@ bool *getDirtyFlags(BM_BufferPool *const bm) {
 int *getFixCounts(BM_BufferPool *const bm) {
     if (bm == NULL || bm->mgmtData == NULL) return NULL;
 
-    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
     int *fixCounts = (int *)malloc(bm->numPages * sizeof(int));
     for (int i = 0; i < bm->numPages; i++) {
-        fixCounts[i] = mgmt->frames[i].fixCount;
+        int frameIdx = i;
+        BM_MgmtData *owner = frameAt(bm, &frameIdx);
+        fixCounts[i] = ATOMIC_LOAD(&owner->fixCounts[frameIdx]);
     }
     return fixCounts;
 }
@@ -816,7 +4527,18 @@ int *getFixCounts(BM_BufferPool *const bm) {
 */
 int getNumReadIO(BM_BufferPool *const bm) {
     if (bm == NULL || bm->mgmtData == NULL) return -1;
-    return ((BM_MgmtData *)bm->mgmtData)->numReadIO;
+
+    // taken under the pool latch like the frame state, a caller polling it sees the loads it counts
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    int num = 0;
+    for (int p = 0; p < mgmt->numPartitions; p++) {
+        num += getNumReadIO(&mgmt->partitions[p]);
+    }
+    if (mgmt->partitions != NULL) return num;
+    latchPool(mgmt);
+    num = (int)__atomic_load_n(&mgmt->stats.readIO, __ATOMIC_RELAXED);
+    unlatchPool(mgmt);
+    return num;
 }
 
 /** 
@@ -826,5 +4548,138 @@ int getNumReadIO(BM_BufferPool *const bm) {
 */
 int getNumWriteIO(BM_BufferPool *const bm) {
     if (bm == NULL || bm->mgmtData == NULL) return -1;
-    return ((BM_MgmtData *)bm->mgmtData)->numWriteIO;
+
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    int num = 0;
+    for (int p = 0; p < mgmt->numPartitions; p++) {
+        num += getNumWriteIO(&mgmt->partitions[p]);
+    }
+    if (mgmt->partitions != NULL) return num;
+    latchPool(mgmt);
+    num = (int)__atomic_load_n(&mgmt->stats.writeIO, __ATOMIC_RELAXED);
+    unlatchPool(mgmt);
+    return num;
+}
+
+/** 
+* @brief copy the pool's statistics, the sums over the partitions of a partitioned pool.
+*        The counters are read one by one while pins may go on, so they need not add up exactly in a busy pool.
+* @param bm, input value, a buffer pool structure pointer
+* @param stats, output value, the counters
+* @return RC, return code
+*/
+RC getPoolStats(BM_BufferPool *const bm, BM_PoolStats *stats) {
+    if (bm == NULL || bm->mgmtData == NULL || stats == NULL) 
+        THROW(RC_INVALID_PARAMS, "Invalid buffer pool or statistics pointer");
+
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    size_t numCounters = sizeof(BM_PoolStats) / sizeof(unsigned long long);
+    unsigned long long *to = (unsigned long long *)stats;
+    if (mgmt->partitions != NULL) {
+        BM_PoolStats part;
+        unsigned long long *from = (unsigned long long *)&part;
+        memset(stats, 0, sizeof(BM_PoolStats));
+        for (int p = 0; p < mgmt->numPartitions; p++) {
+            getPoolStats(&mgmt->partitions[p], &part);
+            for (size_t i = 0; i < numCounters; i++) to[i] += from[i];
+        }
+        return RC_OK;
+    }
+    unsigned long long *from = (unsigned long long *)&mgmt->stats;
+    for (size_t i = 0; i < numCounters; i++) {
+        to[i] = __atomic_load_n(&from[i], __ATOMIC_RELAXED);
+    }
+    return RC_OK;
+}
+
+/** 
+* @brief set all statistics of the pool back to 0, e.g. after a warm-up phase
+* @param bm, input value, a buffer pool structure pointer
+* @return RC, return code
+*/
+RC resetPoolStats(BM_BufferPool *const bm) {
+    if (bm == NULL || bm->mgmtData == NULL) 
+        THROW(RC_INVALID_PARAMS, "Invalid buffer pool");
+
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    for (int p = 0; p < mgmt->numPartitions; p++) {
+        resetPoolStats(&mgmt->partitions[p]);
+    }
+    unsigned long long *counters = (unsigned long long *)&mgmt->stats;
+    for (size_t i = 0; i < sizeof(BM_PoolStats) / sizeof(unsigned long long); i++) {
+        __atomic_store_n(&counters[i], 0, __ATOMIC_RELAXED);
+    }
+    return RC_OK;
+}
+
+/**
+* @brief the policy that manages the frames now, the candidate RS_ADAPTIVE runs or bm->strategy.
+*        Each partition of a partitioned pool adapts on its own, partition 0's policy is reported.
+* @param bm, input value, a buffer pool structure pointer
+* @param strategy, output value, the live strategy
+* @return RC, return code
+*/
+RC getLiveStrategy(BM_BufferPool *const bm, ReplacementStrategy *strategy) {
+    if (bm == NULL || bm->mgmtData == NULL || strategy == NULL)
+        THROW(RC_INVALID_PARAMS, "Invalid buffer pool or strategy");
+
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    if (mgmt->partitions != NULL) return getLiveStrategy(&mgmt->partitions[0], strategy);
+    latchPool(mgmt); // the live policy only changes under the pool latch
+    *strategy = (mgmt->adaptive != NULL) ? adaptiveCandidates[mgmt->adaptive->liveIndex] : bm->strategy;
+    unlatchPool(mgmt);
+    return RC_OK;
+}
+
+// install a pool's trace file under its trace latch, returns the one it replaces
+static FILE *swapTrace(BM_MgmtData *mgmt, FILE *trace) {
+    pthread_mutex_lock(&mgmt->traceLatch);
+    FILE *old = ATOMIC_LOAD(&mgmt->trace);
+    ATOMIC_STORE(&mgmt->trace, trace);
+    pthread_mutex_unlock(&mgmt->traceLatch);
+    return old;
+}
+
+/** 
+* @brief record every pin and unpin of the pool, through any of its handles, to a binary trace file
+*        of BM_TraceRecord. The partitions of a partitioned pool append to the same file.
+*        A trace already running is closed first.
+* @param bm, input value, a buffer pool structure pointer
+* @param traceFile, input value, name of the trace file, it is overwritten
+* @return RC, return code
+*/
+RC startBufferTrace(BM_BufferPool *const bm, const char *const traceFile) {
+    if (bm == NULL || bm->mgmtData == NULL || traceFile == NULL) 
+        THROW(RC_INVALID_PARAMS, "Invalid buffer pool or trace file name");
+
+    FILE *trace = fopen(traceFile, "wb");
+    if (trace == NULL) THROW(RC_FILE_NOT_FOUND, "Can not create the trace file");
+    setvbuf(trace, NULL, _IOFBF, 1 << 16); // records are small, write them out in large blocks
+
+    stopBufferTrace(bm);
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    for (int p = 0; p < mgmt->numPartitions; p++) {
+        swapTrace((BM_MgmtData *)mgmt->partitions[p].mgmtData, trace);
+    }
+    if (mgmt->partitions == NULL) swapTrace(mgmt, trace);
+    return RC_OK;
+}
+
+/** 
+* @brief stop the trace of startBufferTrace and close its file, nothing to do if none is running
+* @param bm, input value, a buffer pool structure pointer
+* @return RC, return code
+*/
+RC stopBufferTrace(BM_BufferPool *const bm) {
+    if (bm == NULL || bm->mgmtData == NULL) 
+        THROW(RC_INVALID_PARAMS, "Invalid buffer pool");
+
+    BM_MgmtData *mgmt = (BM_MgmtData *)bm->mgmtData;
+    FILE *trace = NULL;
+    for (int p = 0; p < mgmt->numPartitions; p++) {
+        trace = swapTrace((BM_MgmtData *)mgmt->partitions[p].mgmtData, NULL);
+    }
+    if (mgmt->partitions == NULL) trace = swapTrace(mgmt, NULL);
+    if (trace != NULL && fclose(trace) != 0) THROW(RC_WRITE_FAILED, "Failed to write the trace file");
+    return RC_OK;
 }
\ No newline at end of file
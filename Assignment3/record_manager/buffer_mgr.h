@@ -13,7 +13,11 @@ typedef enum ReplacementStrategy {
 	RS_LRU = 1,
 	RS_CLOCK = 2,
 	RS_LFU = 3,
-	RS_LRU_K = 4
+	RS_LRU_K = 4,
+	RS_ARC = 5,
+	RS_2Q = 6,
+	RS_ADAPTIVE = 7,       // switches between LRU, LFU and CLOCK, see BM_AdaptiveParams
+	RS_GCLOCK = 8          // CLOCK with weighted reference counts that spares dirty pages once, see BM_GCLOCKParams
 } ReplacementStrategy;
 
 // Data Types and Structures
@@ -26,6 +30,7 @@ typedef struct BM_BufferPool {
 	ReplacementStrategy strategy;
 	void *mgmtData; // use this one to store the bookkeeping info your buffer
 	// manager needs for a buffer pool
+	int fileId;     // file of the pool this handle pins from, 0 = the one the pool was opened with
 } BM_BufferPool;
 
 typedef struct BM_PageHandle {
@@ -33,6 +38,100 @@ typedef struct BM_PageHandle {
 	char *data;
 } BM_PageHandle;
 
+// stratData for RS_LRU_K, NULL selects the defaults
+typedef struct BM_LRUKParams {
+	int k;                 // number of references tracked per page (default 2)
+	int correlatedPeriod;  // pins within this many references of the last one count as one reference (default 0)
+	int historySize;       // evicted pages whose history is retained (0 = numPages, < 0 = none)
+} BM_LRUKParams;
+
+// stratData for RS_LFU, NULL selects the defaults
+typedef struct BM_LFUParams {
+	int agingPeriod;       // every reference count is halved after this many references (0 = 10 * numPages, < 0 = never)
+} BM_LFUParams;
+
+// stratData for RS_2Q, NULL selects the defaults
+typedef struct BM_2QParams {
+	int kin;               // target number of frames in A1in (0 = numPages / 4)
+	int kout;              // number of page numbers remembered in A1out (0 = numPages / 2)
+} BM_2QParams;
+
+// stratData for RS_GCLOCK, NULL selects the defaults. The hand decrements the count of every unpinned
+// frame it passes and evicts the first one at 0, a dirty frame at 0 is passed over once more so that
+// clean pages go first at equal recency and the background writer gets time to clean it.
+typedef struct BM_GCLOCKParams {
+	int loadWeight;        // count of a page when it is loaded (default 1)
+	int hitWeight;         // count added by each later pin (default 1)
+	int maxCount;          // counts never grow past this (default 4)
+} BM_GCLOCKParams;
+
+// stratData for RS_ADAPTIVE, NULL selects the defaults. Every candidate policy is replayed on a
+// key-only shadow cache of the sampled pages; after each epoch the frames are handed to the candidate
+// whose shadow hit most, if it beat the live policy by more than 1% of the epoch's sampled pins.
+typedef struct BM_AdaptiveParams {
+	int sampleRate;        // 1 page in sampleRate is sampled, rounded up to a power of 2 (0 = keep >= 64 pages per shadow, at most 1 in 64)
+	int epochLength;       // sampled pins between two decisions (0 = 8 shadow sizes, at least 256)
+} BM_AdaptiveParams;
+
+// options for initBufferPoolEx, NULL selects the defaults
+typedef struct BM_PoolOptions {
+	bool concurrent;       // latch the pool so that several threads can use it at once
+	int numLatchStripes;   // page table latch stripes in concurrent mode (0 = 16), rounded up to a power of 2
+	int cleanerIntervalMs; // period of the background dirty page writer in ms (0 = no writer), implies concurrent
+	int cleanerDirtyPercent; // the writer cleans until at most this % of unpinned frames are dirty (0 = 10)
+	int readAheadPages;    // pages read ahead once pins walk the file sequentially (0 = no read-ahead), implies concurrent
+	int maxPages;          // frames resizeBufferPool can grow a concurrent pool to (0 = numPages)
+	int numPartitions;     // independent sub-pools the pages are hashed to (0 or 1 = one pool), implies concurrent
+	bool warmRestart;      // save the hot page set on shutdown and preload it when the file is opened again
+	int pinWaitMs;         // concurrent mode: a pin that finds every frame pinned waits this long for an unpin
+	                       // before it fails with RC_NO_FREE_FRAME (0 = 100 ms, PIN_NO_WAIT, PIN_WAIT_FOREVER)
+} BM_PoolOptions;
+
+// BM_PoolOptions.pinWaitMs: fail at once like a pool that is not concurrent, or wait until a frame is free.
+// A thread that waits forever while it holds pins of its own can deadlock; a partitioned pool caps the
+// wait at the default, since a full partition may hold only the caller's pins.
+#define PIN_NO_WAIT (-1)
+#define PIN_WAIT_FOREVER (-2)
+
+// suffix of the file a warm restart saves a page file's hot page set to, see BM_PoolOptions.warmRestart
+#define WARM_FILE_SUFFIX ".warm"
+
+// statistics since initBufferPool or the last resetPoolStats, see getPoolStats
+#define BM_LATENCY_BUCKETS 32
+typedef struct BM_PoolStats {
+	unsigned long long hits;           // pins of pages already in the pool
+	unsigned long long misses;         // pins that had to load the page into a frame
+	unsigned long long readIO;         // pages read, prefetches included
+	unsigned long long writeIO;        // pages written
+	unsigned long long cleanEvictions; // victims dropped without a write
+	unsigned long long dirtyEvictions; // victims written back before their frame was reused
+	unsigned long long pinWaits;       // pins that waited for a read in flight
+	unsigned long long frameWaits;     // pins that found every frame pinned and waited for an unpin
+	unsigned long long policySwitches; // RS_ADAPTIVE: times the live policy changed
+	unsigned long long pinLatency[BM_LATENCY_BUCKETS];  // pins by duration, bucket b: [2^b, 2^(b+1)) ns
+	unsigned long long missLatency[BM_LATENCY_BUCKETS]; // misses by duration, the read included
+} BM_PoolStats;
+
+// one event of an access trace, see startBufferTrace
+typedef enum BM_TraceOp {
+	TRACE_PIN = 0,
+	TRACE_UNPIN = 1
+} BM_TraceOp;
+
+typedef struct BM_TraceRecord {
+	unsigned long long timeNs; // CLOCK_MONOTONIC time of the event
+	PageNumber page;           // file slot of the handle (see attachBufferPool) * 2^20 + page number
+	int op;                    // BM_TraceOp
+} BM_TraceRecord;
+
+// ring of frames a bulk access recycles instead of evicting the shared working set, see createAccessStrategy
+typedef struct BM_AccessStrategy {
+	int ringSize;          // frames the bulk access may occupy, at most a quarter of the pool is used
+	int current;           // ring slot of the last miss
+	int *frames;           // frame loaded by each slot, -1 if none yet
+	PageNumber *pages;     // page each slot loaded, the frame is only recycled while it still holds it
+} BM_AccessStrategy;
+
 // convenience macros
 #define MAKE_POOL()					\
 		((BM_BufferPool *) malloc (sizeof(BM_BufferPool)))
@@ -44,8 +143,26 @@ typedef struct BM_PageHandle {
 RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, 
 		const int numPages, ReplacementStrategy strategy,
 		void *stratData);
+RC initBufferPoolEx(BM_BufferPool *const bm, const char *const pageFileName, 
+		const int numPages, ReplacementStrategy strategy,
+		void *stratData, const BM_PoolOptions *options);
 RC shutdownBufferPool(BM_BufferPool *const bm);
 RC forceFlushPool(BM_BufferPool *const bm);
+// Grow or shrink an open pool; shrinking evicts the pages of the dropped frames, which must be unpinned.
+RC resizeBufferPool(BM_BufferPool *const bm, const int newNumPages);
+// Open another page file in the frames of an open pool: view becomes a handle that pins that file's pages
+// and competes for the same frames under the pool's policy. shutdownBufferPool on the view writes back
+// and evicts the file's pages, which must be unpinned, and closes the file; the pool itself stays open.
+// Views have to be shut down before the pool. initBufferPool(Ex) accepts a NULL file for a pool that
+// only serves views.
+// A partitioned pool (BM_PoolOptions.numPartitions) hashes every page to one of its sub-pools, each with
+// its own frames, page table, replacement state and latches; numPages and maxPages are split between them.
+// The handle is used like any other pool, only attachBufferPool is not supported on it.
+// Warm restart (BM_PoolOptions.warmRestart): shutting down a handle writes the resident pages of its file,
+// hottest first by the policy's ranking, to the sidecar file <pageFile>.warm. initBufferPool(Ex) and
+// attachBufferPool read it back and load the hottest pages that fit in the free frames, sorted into runs
+// of consecutive pages that are read with one vectored read each.
+RC attachBufferPool(BM_BufferPool *const view, BM_BufferPool *const pool, const char *const pageFileName);
 
 // Buffer Manager Interface Access Pages
 RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page);
@@ -54,11 +171,53 @@ RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, 
 		const PageNumber pageNum);
 
+// Pin and latch a page: shared for readers, exclusive for writers of the page content.
+// The latch is a per-frame rwlock taken after the pin, unpinPageLatched releases both.
+// Outside concurrent mode these behave like pinPage / unpinPage. forcePage writes a page for the thread
+// holding its exclusive latch; another thread's forcePage fails with RC_PAGE_LATCHED instead of waiting.
+RC pinPageShared (BM_BufferPool *const bm, BM_PageHandle *const page, 
+		const PageNumber pageNum);
+RC pinPageExclusive (BM_BufferPool *const bm, BM_PageHandle *const page, 
+		const PageNumber pageNum);
+RC unpinPageLatched (BM_BufferPool *const bm, BM_PageHandle *const page);
+
+// Access strategies: a sequential scan or bulk load pins through a small private ring of frames.
+// Its misses recycle the ring's own frames instead of evicting the shared working set.
+RC createAccessStrategy (BM_AccessStrategy **strategy, int ringSize);
+RC freeAccessStrategy (BM_AccessStrategy *strategy);
+RC pinPageWithStrategy (BM_BufferPool *const bm, BM_PageHandle *const page, 
+		const PageNumber pageNum, BM_AccessStrategy *strategy);
+RC pinPageSharedWithStrategy (BM_BufferPool *const bm, BM_PageHandle *const page, 
+		const PageNumber pageNum, BM_AccessStrategy *strategy);
+
+// Pin a page the caller is creating, usually the first one past the end of the file: a miss hands out
+// a zeroed dirty frame without reading the file, which is extended when the page is first written back.
+// The page comes back exclusively latched like pinPageExclusive, release it with unpinPageLatched.
+RC pinNewPage (BM_BufferPool *const bm, BM_PageHandle *const page, 
+		const PageNumber pageNum);
+
+// Prefetch: load pages into unpinned frames. In concurrent mode the request is queued for the
+// pool's I/O thread and the call returns at once, a later pin of the page waits for the read in flight.
+// Otherwise the page is loaded before the call returns. Pages past the end of the file, or that find
+// no frame, are ignored.
+RC prefetchPage (BM_BufferPool *const bm, const PageNumber pageNum);
+RC prefetchRange (BM_BufferPool *const bm, const PageNumber firstPage, const int numPages);
+
 // Statistics Interface
 PageNumber *getFrameContents (BM_BufferPool *const bm);
 bool *getDirtyFlags (BM_BufferPool *const bm);
 int *getFixCounts (BM_BufferPool *const bm);
 int getNumReadIO (BM_BufferPool *const bm);
 int getNumWriteIO (BM_BufferPool *const bm);
+// Copy the pool's counters, they are shared by every handle of the pool and cheap enough to stay on.
+RC getPoolStats (BM_BufferPool *const bm, BM_PoolStats *stats);
+RC resetPoolStats (BM_BufferPool *const bm);
+// Policy managing the frames now: bm->strategy, or for RS_ADAPTIVE the candidate it runs.
+RC getLiveStrategy (BM_BufferPool *const bm, ReplacementStrategy *strategy);
+
+// Access trace: every successful pin and unpin is appended to a binary file of BM_TraceRecord,
+// sim_buffer_mgr replays it against each replacement strategy and Belady's OPT.
+RC startBufferTrace (BM_BufferPool *const bm, const char *const traceFile);
+RC stopBufferTrace (BM_BufferPool *const bm);
 
 #endif
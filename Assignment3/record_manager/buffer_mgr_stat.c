@@ -6,6 +6,8 @@
 
 // local functions
 static void printStrat (BM_BufferPool *const bm);
+static void printStrategyName (ReplacementStrategy strategy);
+static void printLatency (const char *name, const unsigned long long *histogram);
 
 // external functions
 void 
@@ -51,6 +53,34 @@ sprintPoolContent (BM_BufferPool *const bm)
 }
 
 
+void
+printPoolStats (BM_BufferPool *const bm)
+{
+	BM_PoolStats stats;
+	ReplacementStrategy live;
+	unsigned long long pins;
+
+	if (getPoolStats(bm, &stats) != RC_OK)
+		return;
+	pins = stats.hits + stats.misses;
+
+	printf("{");
+	printStrat(bm);
+	printf(" %i}: ", bm->numPages);
+	printf("pins %llu, hits %llu, misses %llu, hit ratio %.2f%%\n", pins, stats.hits, stats.misses,
+			(pins == 0) ? 0.0 : 100.0 * stats.hits / pins);
+	printf("reads %llu, writes %llu, evictions %llu clean %llu dirty, pin waits %llu, frame waits %llu\n",
+			stats.readIO, stats.writeIO, stats.cleanEvictions, stats.dirtyEvictions, stats.pinWaits, stats.frameWaits);
+	if (bm->strategy == RS_ADAPTIVE && getLiveStrategy(bm, &live) == RC_OK)
+	{
+		printf("policy switches %llu, live policy ", stats.policySwitches);
+		printStrategyName(live);
+		printf("\n");
+	}
+	printLatency("pin", stats.pinLatency);
+	printLatency("miss", stats.missLatency);
+}
+
 void
 printPageContent (BM_PageHandle *const page)
 {
@@ -81,7 +111,13 @@ sprintPageContent (BM_PageHandle *const page)
 void
 printStrat (BM_BufferPool *const bm)
 {
-	switch (bm->strategy)
+	printStrategyName(bm->strategy);
+}
+
+void
+printStrategyName (ReplacementStrategy strategy)
+{
+	switch (strategy)
 	{
 	case RS_FIFO:
 		printf("FIFO");
@@ -98,8 +134,41 @@ printStrat (BM_BufferPool *const bm)
 	case RS_LRU_K:
 		printf("LRU-K");
 		break;
+	case RS_ARC:
+		printf("ARC");
+		break;
+	case RS_2Q:
+		printf("2Q");
+		break;
+	case RS_ADAPTIVE:
+		printf("ADAPTIVE");
+		break;
+	case RS_GCLOCK:
+		printf("GCLOCK");
+		break;
 	default:
-		printf("%i", bm->strategy);
+		printf("%i", strategy);
 		break;
 	}
 }
+
+// non-empty buckets of a latency histogram, bucket b is [2^b, 2^(b+1)) ns
+void
+printLatency (const char *name, const unsigned long long *histogram)
+{
+	int b;
+
+	printf("%s latency:", name);
+	for (b = 0; b < BM_LATENCY_BUCKETS; b++)
+	{
+		if (histogram[b] == 0)
+			continue;
+		if (b < 10)
+			printf(" <%lluns:%llu", 1ULL << (b + 1), histogram[b]);
+		else if (b < 20)
+			printf(" <%lluus:%llu", 1ULL << (b - 9), histogram[b]);
+		else
+			printf(" <%llums:%llu", 1ULL << (b - 19), histogram[b]);
+	}
+	printf("\n");
+}
@@ -22,6 +22,8 @@ typedef int RC; // define a new type for error code
 #define RC_INVALID_PARAMS (-3)
 #define RC_PAGE_NOT_FOUND (-4)
 #define RC_NO_FREE_FRAME (-5)
+#define RC_PINNED_PAGES_IN_BUFFER (-6)
+#define RC_PAGE_LATCHED (-7) // forcePage: another thread holds the page's exclusive latch
 
 #define RC_FILE_ALREADY_EXISTS 9
 #define RC_OUT_OF_MEMORY 100       // 内存不足
@@ -14,6 +14,12 @@
 #endif
 
 #define DEFAULT_BUFFER_POOL_SIZE 10
+#define SHARED_BUFFER_POOL_SIZE 64 // frames all tables opened after initRecordManager share
+#define MAX_BUFFER_POOL_SIZE 256 // frames resizeTableBuffer can grow a table's pool to
+#define DEFAULT_BUFFER_POOL_STRATEGY RS_2Q // scan resistant: pages read once stay in A1in
+#define DEFAULT_READ_AHEAD_PAGES 0 // off: bench_buffer_mgr's cold scan is not faster with read-ahead yet
+#define PIN_WAIT_MS 50 // a pin waits this long for a frame: writers pin page 0 while they hold a data page
+#define SCAN_RING_FRAMES 4 // frames a scan recycles, the buffer manager caps it at a quarter of the pool
 #define MAX_ATTR_NUM 10
 
 // 槽位目录项（每个槽位的元数据，存储在页头后的槽位目录中）
@@ -58,16 +64,17 @@ typedef struct RM_TableMgmt {
     int numWriteIO;            // 写IO统计
 } RM_TableMgmt;
 
-// // 扫描状态管理（RM_ScanHandle的mgmtData实际类型）
-// typedef struct ScanMgmtData {
-//     Expr *cond;                // 扫描条件表达式（NULL表示全表扫描）
-//     int currentPage;           // 当前扫描的页号
-//     int currentSlot;           // 当前页内扫描的槽位
-//     bool isEnd;                // 扫描是否结束
-//     // 缓存当前页的槽位目录（减少重复IO）
-//     SlotDirEntry *slotDir;
-//     int slotDirSize;
-// } ScanMgmtData;
+// 扫描状态管理（RM_ScanHandle的mgmtData实际类型）
+typedef struct ScanMgmtData {
+    Expr *cond;                // 扫描条件表达式（NULL表示全表扫描）
+    int currentPage;           // 当前扫描的页号
+    int currentSlot;           // 当前页内下一个要检查的槽位
+    BM_AccessStrategy *ring;   // 扫描专用的环形帧，不挤占其他访问的热点页
+} ScanMgmtData;
+
+// 共享缓冲池：initRecordManager打开，之后打开的表都挂在上面
+static BM_BufferPool sharedPool;
+static bool sharedPoolOpen = false;
 
 // ------------------------------
 // Schema functions
@@ -155,7 +162,7 @@ static RC findFreeSlotInPage(BM_BufferPool *bp, BM_PageHandle *ph, int *slotNum)
     }
     
     // 计算页中剩余空间是否足够新增一个槽位和记录
-    int recordSize = ((RM_TableMgmt *)bp->mgmtData)->tableInfo.recordSize;
+    int recordSize = ((RM_TableMgmt *)bp)->tableInfo.recordSize;
     int pageDataAreaSize = PAGE_SIZE - header->slotDirOffset - (header->slotCount + 1) * sizeof(SlotDirEntry);
     int remainingFreeSpace = pageDataAreaSize - (header->slotCount * recordSize);
     
@@ -188,15 +195,28 @@ static RC insertRecordIntoSlot(BM_BufferPool *bp, BM_PageHandle *ph, int slotNum
 }
 // 辅助函数：从缓冲区获取页
 // 修改getPageFromBuffer函数，确保正确处理页面固定
-static RC getPageFromBuffer(BM_BufferPool *bp, BM_PageHandle *ph, PageNumber pageNum) {
-    RC rc = pinPage(bp, ph, pageNum);
+// 读记录用共享闩锁，修改页面内容用排他闩锁
+static RC getPageFromBuffer(BM_BufferPool *bp, BM_PageHandle *ph, PageNumber pageNum, bool exclusive) {
+    RC rc = exclusive ? pinPageExclusive(bp, ph, pageNum) : pinPageShared(bp, ph, pageNum);
     if (rc != RC_OK) {
         DEBUG_PRINT("Failed to pin page %d: %s\n", pageNum, errorMessage(rc));
         return rc;
     }
     // 确保mgmtData不为空再增加IO计数
     if (bp->mgmtData != NULL) {
-        ((RM_TableMgmt *)bp->mgmtData)->numReadIO++;
+        ((RM_TableMgmt *)bp)->numReadIO++;
+    }
+    return RC_OK;
+}
+// 辅助函数：扫描时通过环形帧获取页（共享闩锁）
+static RC getScanPageFromBuffer(BM_BufferPool *bp, BM_PageHandle *ph, PageNumber pageNum, BM_AccessStrategy *ring) {
+    RC rc = pinPageSharedWithStrategy(bp, ph, pageNum, ring);
+    if (rc != RC_OK) {
+        DEBUG_PRINT("Failed to pin page %d: %s\n", pageNum, errorMessage(rc));
+        return rc;
+    }
+    if (bp->mgmtData != NULL) {
+        ((RM_TableMgmt *)bp)->numReadIO++;
     }
     return RC_OK;
 }
@@ -207,10 +227,10 @@ static RC releasePageToBuffer(BM_BufferPool *bp, BM_PageHandle *ph, bool isDirty
         markDirty(bp, ph);
         // 确保mgmtData不为空再增加IO计数
         if (bp->mgmtData != NULL) {
-            ((RM_TableMgmt *)bp->mgmtData)->numWriteIO++;
+            ((RM_TableMgmt *)bp)->numWriteIO++;
         }
     }
-    RC rc = unpinPage(bp, ph);
+    RC rc = unpinPageLatched(bp, ph);
     if (rc != RC_OK) {
         DEBUG_PRINT("Failed to unpin page %d: %s\n", ph->pageNum, errorMessage(rc));
     }
@@ -227,17 +247,26 @@ static RC releasePageToBuffer(BM_BufferPool *bp, BM_PageHandle *ph, bool isDirty
 RC initRecordManager (void *mgmtData)
 {
     initStorageManager(); // 依赖存储管理器初始化
+    if (sharedPoolOpen) return RC_OK;
+
+    // 所有表共用一个缓冲池，页面按文件区分，热表自然占用更多帧；关表时记下热页，再打开时预读
+    BM_PoolOptions poolOptions = { TRUE, 0, 0, 0, DEFAULT_READ_AHEAD_PAGES, MAX_BUFFER_POOL_SIZE, 0, TRUE, PIN_WAIT_MS };
+    RC rc = initBufferPoolEx(&sharedPool, NULL, SHARED_BUFFER_POOL_SIZE, DEFAULT_BUFFER_POOL_STRATEGY, NULL, &poolOptions);
+    if (rc != RC_OK) return rc;
+    sharedPoolOpen = true;
     return RC_OK;
 }
 
 /**
- * @brief record manager shutdown
+ * @brief record manager shutdown, all tables must be closed before
  * 
  * @return RC_OK
  */
 RC shutdownRecordManager ()
 {
-    return RC_OK;
+    if (!sharedPoolOpen) return RC_OK;
+    sharedPoolOpen = false;
+    return shutdownBufferPool(&sharedPool);
 }
 /**
  * @brief create a table, write table info to page 0
@@ -362,8 +391,13 @@ RC openTable (RM_TableData *rel, char *name)
         return RC_OUT_OF_MEMORY;
     }
 
-    // 5. 初始化缓冲池
-    rc = initBufferPool(&mgmt->bufferPool, name, DEFAULT_BUFFER_POOL_SIZE, RS_FIFO, NULL);
+    // 5. 挂到共享缓冲池上；没有调用initRecordManager时使用表自己的缓冲池（并发模式，页面访问由页闩锁保护）
+    if (sharedPoolOpen) {
+        rc = attachBufferPool(&mgmt->bufferPool, &sharedPool, name);
+    } else {
+        BM_PoolOptions poolOptions = { TRUE, 0, 0, 0, DEFAULT_READ_AHEAD_PAGES, MAX_BUFFER_POOL_SIZE, 0, TRUE, PIN_WAIT_MS };
+        rc = initBufferPoolEx(&mgmt->bufferPool, name, DEFAULT_BUFFER_POOL_SIZE, DEFAULT_BUFFER_POOL_STRATEGY, NULL, &poolOptions);
+    }
     if (rc != RC_OK) {
         freeSchema(mgmt->schema);
         closePageFile(&mgmt->fileHandle);
@@ -430,6 +464,14 @@ RC closeTable(RM_TableData *rel) {
 RC deleteTable (char *name)
 {
     if (name == NULL) return RC_INVALID_PARAMS;
+
+    // 热页集合文件随表一起删除
+    char *warmFile = (char *)malloc(strlen(name) + strlen(WARM_FILE_SUFFIX) + 1);
+    if (warmFile != NULL) {
+        sprintf(warmFile, "%s%s", name, WARM_FILE_SUFFIX);
+        remove(warmFile);
+        free(warmFile);
+    }
     return destroyPageFile(name);
 }
 
@@ -471,6 +513,20 @@ char* getTableName(RM_TableData *rel) {
     strcpy(name, mgmt->tableInfo.tableName);
     return name;
 }
+
+/**
+ * @brief resize the buffer pool of an open table, e.g. to give busy tables more memory.
+ *        Tables opened after initRecordManager share one pool, resizing it affects all of them.
+ * 
+ * @param rel, pointer to the table data
+ * @param numPages, new number of frames, at most MAX_BUFFER_POOL_SIZE
+ * @return RC_OK, or an error if the pool can not shrink because pages are pinned
+ */
+RC resizeTableBuffer(RM_TableData *rel, int numPages) {
+    if (rel == NULL || rel->mgmtData == NULL) return RC_INVALID_PARAMS;
+    RM_TableMgmt *mgmt = (RM_TableMgmt *)rel->mgmtData;
+    return resizeBufferPool(&mgmt->bufferPool, numPages);
+}
 /**
  * @brief get number of tuples in a table
  * 
@@ -503,12 +559,13 @@ RC insertRecord(RM_TableData *rel, Record *record) {
     
     // 1. 查找可用页面（优先使用空闲页链表中的页面）
     int pageNum = -1;
+    bool newPage = FALSE;
     if (mgmt->tableInfo.freePageListHead != -1) {
         // 使用空闲页链表中的页面
         pageNum = mgmt->tableInfo.freePageListHead;
         
         // 获取该页面
-        rc = getPageFromBuffer(bp, &ph, pageNum);
+        rc = getPageFromBuffer(bp, &ph, pageNum, TRUE);
         if (rc != RC_OK) {
             DEBUG_PRINT("insertRecord: Failed to get free page %d\n", pageNum);
             return rc;
@@ -524,10 +581,11 @@ RC insertRecord(RM_TableData *rel, Record *record) {
         // 创建新页面
         pageNum = mgmt->tableInfo.totalPages;
         mgmt->tableInfo.totalPages++;
+        newPage = TRUE;
     }
     
-    // 2. 获取目标页面
-    rc = getPageFromBuffer(bp, &ph, pageNum);
+    // 2. 获取目标页面，新页面不必从文件读取
+    rc = newPage ? pinNewPage(bp, &ph, pageNum) : getPageFromBuffer(bp, &ph, pageNum, TRUE);
     if (rc != RC_OK) {
         DEBUG_PRINT("insertRecord: Failed to get page %d\n", pageNum);
         return rc;
@@ -548,7 +606,7 @@ RC insertRecord(RM_TableData *rel, Record *record) {
         pageNum = mgmt->tableInfo.totalPages;
         mgmt->tableInfo.totalPages++;
         
-        rc = getPageFromBuffer(bp, &ph, pageNum);
+        rc = pinNewPage(bp, &ph, pageNum);
         if (rc != RC_OK) {
             DEBUG_PRINT("insertRecord: Failed to get new page %d\n", pageNum);
             return rc;
@@ -583,11 +641,11 @@ RC insertRecord(RM_TableData *rel, Record *record) {
     
     // 9. 更新第0页的表信息
     BM_PageHandle infoPage;
-    rc = pinPage(bp, &infoPage, 0);
+    rc = pinPageExclusive(bp, &infoPage, 0);
     if (rc == RC_OK) {
         memcpy(infoPage.data, &mgmt->tableInfo, sizeof(TableInfo));
         markDirty(bp, &infoPage);
-        unpinPage(bp, &infoPage);
+        unpinPageLatched(bp, &infoPage);
     }
     
     // 10. 释放页面
@@ -621,7 +679,7 @@ RC getRecord(RM_TableData *rel, RID id, Record *record) {
     }
     
     // 2. 从缓冲区获取页面
-    rc = getPageFromBuffer(bp, &ph, id.page);
+    rc = getPageFromBuffer(bp, &ph, id.page, FALSE);
     if (rc != RC_OK) return rc;
     
     // 3. 检查页面结构
@@ -663,7 +721,7 @@ RC deleteRecord(RM_TableData *rel, RID id) {
     RC rc = RC_OK;
     
     // 1. 从缓冲区获取页面
-    rc = getPageFromBuffer(bp, &ph, id.page);
+    rc = getPageFromBuffer(bp, &ph, id.page, TRUE);
     if (rc != RC_OK) return rc;
     
     // 2. 检查页面结构
@@ -685,11 +743,11 @@ RC deleteRecord(RM_TableData *rel, RID id) {
     
     // 6. 更新第0页的表信息
     BM_PageHandle infoPage;
-    rc = pinPage(bp, &infoPage, 0);
+    rc = pinPageExclusive(bp, &infoPage, 0);
     if (rc == RC_OK) {
         memcpy(infoPage.data, &mgmt->tableInfo, sizeof(TableInfo));
         markDirty(bp, &infoPage);
-        unpinPage(bp, &infoPage);
+        unpinPageLatched(bp, &infoPage);
     }
     
     // 7. 释放页面
@@ -716,7 +774,7 @@ RC updateRecord(RM_TableData *rel, Record *record) {
     int recordSize = mgmt->tableInfo.recordSize;
     
     // 1. 从缓冲区获取页面
-    rc = getPageFromBuffer(bp, &ph, record->id.page);
+    rc = getPageFromBuffer(bp, &ph, record->id.page, TRUE);
     if (rc != RC_OK) {
         DEBUG_PRINT("updateRecord: Failed to get page %d\n", record->id.page);
         return rc;
@@ -745,16 +803,109 @@ RC updateRecord(RM_TableData *rel, Record *record) {
     
     return RC_OK;
 }
+/**
+ * @brief start a scan over all records of a table
+ * 
+ * @param rel, input parameter, pointer to the table data
+ * @param scan, output parameter, pointer to the scan handle
+ * @param cond, input parameter, condition the returned records satisfy, NULL for all records
+ * @return RC_OK
+ */
 RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond)
 {
+    if (rel == NULL || scan == NULL || rel->mgmtData == NULL) 
+        return RC_INVALID_PARAMS;
+
+    ScanMgmtData *scanMgmt = (ScanMgmtData *)malloc(sizeof(ScanMgmtData));
+    if (scanMgmt == NULL) return RC_OUT_OF_MEMORY;
+    // 扫描的页通过自己的环形帧读入，全表扫描不会换出其他访问的热点页
+    RC rc = createAccessStrategy(&scanMgmt->ring, SCAN_RING_FRAMES);
+    if (rc != RC_OK) {
+        free(scanMgmt);
+        return rc;
+    }
+    scanMgmt->cond = cond;
+    scanMgmt->currentPage = 1; // 第0页是表信息
+    scanMgmt->currentSlot = 0;
+
+    scan->rel = rel;
+    scan->mgmtData = scanMgmt;
     return RC_OK;
 }
+/**
+ * @brief return the next record that satisfies the scan condition
+ * 
+ * @param scan, input parameter, pointer to the scan handle
+ * @param record, output parameter, pointer to the record
+ * @return RC_OK, or RC_RM_NO_MORE_TUPLES once the table is exhausted
+ */
 RC next (RM_ScanHandle *scan, Record *record)
 {
-    return RC_OK;
+    if (scan == NULL || record == NULL || scan->mgmtData == NULL || scan->rel == NULL) 
+        return RC_INVALID_PARAMS;
+
+    ScanMgmtData *scanMgmt = (ScanMgmtData *)scan->mgmtData;
+    RM_TableMgmt *mgmt = (RM_TableMgmt *)scan->rel->mgmtData;
+    BM_BufferPool *bp = &mgmt->bufferPool;
+    int recordSize = mgmt->tableInfo.recordSize;
+    BM_PageHandle ph;
+    RC rc = RC_OK;
+
+    if (record->data == NULL) {
+        record->data = malloc(recordSize);
+        if (record->data == NULL) return RC_OUT_OF_MEMORY;
+    }
+
+    // 逐页逐槽位查找，位置保存在scanMgmt中，下次调用从这里继续
+    while (scanMgmt->currentPage < mgmt->tableInfo.totalPages) {
+        rc = getScanPageFromBuffer(bp, &ph, scanMgmt->currentPage, scanMgmt->ring);
+        if (rc != RC_OK) return rc;
+
+        PageHeader *header = (PageHeader *)ph.data;
+        SlotDirEntry *slotDir = (SlotDirEntry *)(ph.data + header->slotDirOffset);
+        while (scanMgmt->currentSlot < header->slotCount) {
+            int slot = scanMgmt->currentSlot++;
+            if (!slotDir[slot].isValid) continue;
+
+            memcpy(record->data, ph.data + slotDir[slot].offset, recordSize);
+            record->id.page = scanMgmt->currentPage;
+            record->id.slot = slot;
+            if (scanMgmt->cond == NULL) {
+                releasePageToBuffer(bp, &ph, FALSE);
+                return RC_OK;
+            }
+
+            Value *result = NULL;
+            rc = evalExpr(record, mgmt->schema, scanMgmt->cond, &result);
+            bool match = (rc == RC_OK && result->dt == DT_BOOL && result->v.boolV);
+            if (result != NULL) freeVal(result);
+            if (rc != RC_OK || match) {
+                releasePageToBuffer(bp, &ph, FALSE);
+                return rc;
+            }
+        }
+        releasePageToBuffer(bp, &ph, FALSE);
+        scanMgmt->currentPage++;
+        scanMgmt->currentSlot = 0;
+    }
+    return RC_RM_NO_MORE_TUPLES;
 }
+/**
+ * @brief close a scan and release its ring of frames
+ * 
+ * @param scan, input parameter, pointer to the scan handle
+ * @return RC_OK
+ */
 RC closeScan (RM_ScanHandle *scan)
 {
+    if (scan == NULL) return RC_INVALID_PARAMS;
+
+    ScanMgmtData *scanMgmt = (ScanMgmtData *)scan->mgmtData;
+    if (scanMgmt != NULL) {
+        freeAccessStrategy(scanMgmt->ring);
+        free(scanMgmt);
+        scan->mgmtData = NULL;
+    }
     return RC_OK;
 }
 
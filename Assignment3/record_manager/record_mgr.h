@@ -24,6 +24,7 @@ extern int getNumTuples (RM_TableData *rel);
 extern int getTableTotalPages(RM_TableData *rel);       // 获取表总页数
 extern int getTableRecordSize(RM_TableData *rel);       // 获取记录大小
 extern char* getTableName(RM_TableData *rel);           // 获取表名
+extern RC resizeTableBuffer(RM_TableData *rel, int numPages); // 调整表的缓冲池大小
 // handling records in a table
 extern RC insertRecord (RM_TableData *rel, Record *record);
 extern RC deleteRecord (RM_TableData *rel, RID id);
@@ -0,0 +1,272 @@
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "dberror.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+/*----------------------macros----------------------*/
+#define SIM_FILE "simbuffer.bin"
+#define NO_NEXT_USE INT_MAX     // the page is never pinned again
+
+/*----------------------strategies compared----------------------*/
+static const ReplacementStrategy simStrategies[] = { RS_FIFO, RS_LRU, RS_CLOCK, RS_LFU, RS_LRU_K, RS_ARC, RS_2Q, RS_ADAPTIVE, RS_GCLOCK };
+static const char *simNames[] = { "FIFO", "LRU", "CLOCK", "LFU", "LRU-K", "ARC", "2Q", "ADAPTIVE", "GCLOCK" };
+#define NUM_STRATEGIES (int)(sizeof(simStrategies) / sizeof(simStrategies[0]))
+static const int defaultPercents[] = { 1, 5, 10, 25, 50 }; // default pool sizes, % of the distinct pages
+
+/*----------------------trace----------------------*/
+typedef struct Trace {
+    int numEvents;
+    int *page;     // dense page number of each event, 0 .. numPages - 1
+    int *op;       // BM_TraceOp of each event
+    int numPages;  // distinct pages in the trace
+    int numPins;
+} Trace;
+
+// (next use, page) entry of the OPT heap
+typedef struct OptEntry {
+    int nextUse;
+    int page;
+} OptEntry;
+
+/*----------------------local auxiliary functions----------------------*/
+static int compareInts(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+* @brief read a trace file and renumber its pages densely, pages of several files become distinct pages
+* @param fileName, input value, trace written by startBufferTrace
+* @param trace, output value, the events
+* @return RC, return code
+*/
+static RC loadTrace(const char *fileName, Trace *trace)
+{
+    FILE *fp = fopen(fileName, "rb");
+    if (fp == NULL) THROW(RC_FILE_NOT_FOUND, "Trace file not found");
+    fseek(fp, 0L, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0L, SEEK_SET);
+
+    trace->numEvents = (int)(size / sizeof(BM_TraceRecord));
+    BM_TraceRecord *records = (BM_TraceRecord *)malloc((trace->numEvents + 1) * sizeof(BM_TraceRecord));
+    trace->page = (int *)malloc((trace->numEvents + 1) * sizeof(int));
+    trace->op = (int *)malloc((trace->numEvents + 1) * sizeof(int));
+    int *keys = (int *)malloc((trace->numEvents + 1) * sizeof(int));
+    if (records == NULL || trace->page == NULL || trace->op == NULL || keys == NULL) {
+        fclose(fp);
+        THROW(RC_MEMORY_ALLOC_FAILED, "Not enough memory for the trace");
+    }
+    trace->numEvents = (int)fread(records, sizeof(BM_TraceRecord), trace->numEvents, fp);
+    fclose(fp);
+
+    // distinct keys in order, an event's page is the index of its key
+    for (int i = 0; i < trace->numEvents; i++) keys[i] = records[i].page;
+    qsort(keys, trace->numEvents, sizeof(int), compareInts);
+    int n = 0;
+    for (int i = 0; i < trace->numEvents; i++) {
+        if (n == 0 || keys[n - 1] != keys[i]) keys[n++] = keys[i];
+    }
+    trace->numPages = n;
+    trace->numPins = 0;
+    for (int i = 0; i < trace->numEvents; i++) {
+        int *found = (int *)bsearch(&records[i].page, keys, n, sizeof(int), compareInts);
+        trace->page[i] = (int)(found - keys);
+        trace->op[i] = records[i].op;
+        if (trace->op[i] == TRACE_PIN) trace->numPins++;
+    }
+    free(keys);
+    free(records);
+    return RC_OK;
+}
+
+/**
+* @brief replay a trace through a real buffer pool
+* @param trace, input value, the events
+* @param strategy, input value, replacement strategy
+* @param numFrames, input value, pool size
+* @param failed, output value, pins that failed because every frame was pinned
+* @return double, hit ratio of the pins
+*/
+static double simStrategy(const Trace *trace, ReplacementStrategy strategy, int numFrames, int *failed)
+{
+    BM_BufferPool bm;
+    BM_PageHandle h;
+    BM_PoolStats stats;
+    int *pins = (int *)calloc(trace->numPages, sizeof(int)); // pins the replay holds on each page
+
+    *failed = 0;
+    CHECK(initBufferPool(&bm, SIM_FILE, numFrames, strategy, NULL));
+    for (int i = 0; i < trace->numEvents; i++) {
+        int page = trace->page[i];
+        if (trace->op[i] == TRACE_PIN) {
+            if (pinPage(&bm, &h, page) == RC_OK) pins[page]++;
+            else (*failed)++;
+        } else if (pins[page] > 0) {
+            // an unpin of a page pinned before the trace started, or whose pin failed, is dropped
+            h.pageNum = page;
+            CHECK(unpinPage(&bm, &h));
+            pins[page]--;
+        }
+    }
+    CHECK(getPoolStats(&bm, &stats));
+    for (int page = 0; page < trace->numPages; page++) {
+        h.pageNum = page;
+        while (pins[page]-- > 0) CHECK(unpinPage(&bm, &h));
+    }
+    CHECK(shutdownBufferPool(&bm));
+    free(pins);
+
+    unsigned long long total = stats.hits + stats.misses;
+    return (total == 0) ? 0.0 : (double)stats.hits / total;
+}
+
+static void heapPush(OptEntry *heap, int *size, OptEntry e)
+{
+    int i = (*size)++;
+    while (i > 0 && heap[(i - 1) / 2].nextUse < e.nextUse) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = e;
+}
+
+static OptEntry heapPop(OptEntry *heap, int *size)
+{
+    OptEntry top = heap[0], last = heap[--(*size)];
+    int i = 0;
+    for (;;) {
+        int c = 2 * i + 1;
+        if (c >= *size) break;
+        if (c + 1 < *size && heap[c + 1].nextUse > heap[c].nextUse) c++;
+        if (heap[c].nextUse <= last.nextUse) break;
+        heap[i] = heap[c];
+        i = c;
+    }
+    heap[i] = last;
+    return top;
+}
+
+/**
+* @brief Belady's OPT: on a miss evict the unpinned page whose next pin is furthest away.
+*        No online policy can do better with the same pins, it bounds what a strategy can gain.
+* @param trace, input value, the events
+* @param numFrames, input value, pool size
+* @return double, hit ratio of the pins
+*/
+static double simOpt(const Trace *trace, int numFrames)
+{
+    int *nextUse = (int *)malloc(trace->numEvents * sizeof(int)); // next pin of the same page after event i
+    int *upcoming = (int *)malloc(trace->numPages * sizeof(int));
+    int *current = (int *)malloc(trace->numPages * sizeof(int)); // next pin of each resident page
+    int *pins = (int *)calloc(trace->numPages, sizeof(int));
+    char *resident = (char *)calloc(trace->numPages, 1);
+    // one live entry per resident page plus stale ones, each pin adds one
+    OptEntry *heap = (OptEntry *)malloc((trace->numPins + 1) * sizeof(OptEntry));
+    OptEntry *pinned = (OptEntry *)malloc((numFrames + 1) * sizeof(OptEntry));
+    int heapSize = 0, numResident = 0, hits = 0, pinsDone = 0;
+
+    for (int p = 0; p < trace->numPages; p++) upcoming[p] = NO_NEXT_USE;
+    for (int i = trace->numEvents - 1; i >= 0; i--) {
+        if (trace->op[i] != TRACE_PIN) continue;
+        nextUse[i] = upcoming[trace->page[i]];
+        upcoming[trace->page[i]] = i;
+    }
+
+    for (int i = 0; i < trace->numEvents; i++) {
+        int page = trace->page[i];
+        if (trace->op[i] != TRACE_PIN) {
+            if (pins[page] > 0) pins[page]--;
+            continue;
+        }
+        if (resident[page]) {
+            hits++;
+        } else {
+            if (numResident == numFrames) {
+                // furthest next use first; stale entries are dropped, pinned pages are put back afterwards
+                int numPinned = 0, victim = -1;
+                while (heapSize > 0 && victim < 0) {
+                    OptEntry e = heapPop(heap, &heapSize);
+                    if (!resident[e.page] || current[e.page] != e.nextUse) continue;
+                    if (pins[e.page] > 0) pinned[numPinned++] = e;
+                    else victim = e.page;
+                }
+                for (int j = 0; j < numPinned; j++) heapPush(heap, &heapSize, pinned[j]);
+                if (victim < 0) continue; // every frame is pinned, the pin fails like in the pool
+                resident[victim] = 0;
+                numResident--;
+            }
+            resident[page] = 1;
+            numResident++;
+        }
+        pins[page]++;
+        pinsDone++;
+        current[page] = nextUse[i];
+        heapPush(heap, &heapSize, (OptEntry){ nextUse[i], page });
+    }
+
+    free(nextUse);
+    free(upcoming);
+    free(current);
+    free(pins);
+    free(resident);
+    free(heap);
+    free(pinned);
+    return (pinsDone == 0) ? 0.0 : (double)hits / pinsDone;
+}
+
+/*----------------------main----------------------*/
+/**
+* @brief replay an access trace against every replacement strategy and Belady's OPT
+*        usage: sim_buffer_mgr traceFile [poolSize ...]
+*/
+int main(int argc, char **argv)
+{
+    Trace trace;
+    SM_FileHandle fh;
+
+    if (argc < 2) {
+        printf("usage: %s traceFile [poolSize ...]\n", argv[0]);
+        return 1;
+    }
+    initStorageManager();
+    CHECK(loadTrace(argv[1], &trace));
+    printf("%s: %d events, %d pins, %d distinct pages\n", argv[1], trace.numEvents, trace.numPins, trace.numPages);
+    if (trace.numPins == 0) return 0;
+
+    // the replay reads real pages, one for each distinct page of the trace
+    CHECK(createPageFile(SIM_FILE));
+    CHECK(openPageFile(SIM_FILE, &fh));
+    CHECK(ensureCapacity(trace.numPages, &fh));
+    CHECK(closePageFile(&fh));
+
+    int numSizes = (argc > 2) ? argc - 2 : (int)(sizeof(defaultPercents) / sizeof(defaultPercents[0]));
+    printf("%10s", "frames");
+    for (int s = 0; s < NUM_STRATEGIES; s++) printf(" %8s", simNames[s]);
+    printf(" %8s\n", "OPT");
+    for (int i = 0; i < numSizes; i++) {
+        int numFrames = (argc > 2) ? atoi(argv[i + 2]) : trace.numPages * defaultPercents[i] / 100;
+        if (numFrames < 1) numFrames = 1;
+        int failedPins = 0;
+        printf("%10d", numFrames);
+        for (int s = 0; s < NUM_STRATEGIES; s++) {
+            int failed;
+            printf(" %7.2f%%", 100.0 * simStrategy(&trace, simStrategies[s], numFrames, &failed));
+            fflush(stdout);
+            if (failed > failedPins) failedPins = failed;
+        }
+        printf(" %7.2f%%", 100.0 * simOpt(&trace, numFrames));
+        if (failedPins > 0) printf("  (%d pins failed, every frame was pinned)", failedPins);
+        printf("\n");
+    }
+
+    CHECK(destroyPageFile(SIM_FILE));
+    free(trace.page);
+    free(trace.op);
+    return 0;
+}
@@ -4,11 +4,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#ifdef SIMULATE
 #include <unistd.h>
+#include <sys/uio.h>
+#ifdef SIMULATE
 #include <time.h>
 #endif
 /*----------------------macros----------------------*/
+#define WRITE_BATCH_PAGES 64 // pages per vectored read or write, well under IOV_MAX
 #ifdef SIMULATE
 #define LATENCY_LOW 5
 #define LATENCY_HIGH 20
@@ -220,6 +222,59 @@ RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
     return RC_OK;    
 }
 
+/** 
+* @brief read consecutive existing pages into separate buffers, one vectored read per WRITE_BATCH_PAGES pages
+* @param pageNum, input value, first page to read
+* @param numPages, input value, number of pages
+* @param fHandle, input value, a storage manager file structure pointer
+* @param memPages, input value, numPages page buffers, page pageNum + i is read into memPages[i]
+* @return error code
+*/
+RC readBlocks (int pageNum, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages)
+{
+    // check input parameters are ok or not
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) 
+        return RC_FILE_HANDLE_NOT_INIT;
+    if (memPages == NULL || numPages < 0) 
+        return RC_READ_FAILED;
+    if (pageNum < 0 || pageNum + numPages > fHandle->totalNumPages) 
+        return RC_READ_NON_EXISTING_PAGE;
+    if (numPages == 0) 
+        return RC_OK;
+
+    // the pages bypass stdio: flushing first makes buffered writes visible to the read
+    FILE *fp = (FILE *)fHandle->mgmtInfo;
+    if (fflush(fp) != 0) 
+        return RC_READ_FAILED;
+    int fd = fileno(fp);
+
+    struct iovec iov[WRITE_BATCH_PAGES];
+    for (int done = 0; done < numPages; ) {
+        int n = (numPages - done < WRITE_BATCH_PAGES) ? numPages - done : WRITE_BATCH_PAGES;
+        for (int i = 0; i < n; i++) {
+            iov[i].iov_base = memPages[done + i];
+            iov[i].iov_len = PAGE_SIZE;
+        }
+        ssize_t read = preadv(fd, iov, n, (off_t)(pageNum + done) * PAGE_SIZE);
+        if (read < 0) 
+            return RC_READ_FAILED;
+        // like readBlock, a short read past the data of the file leaves zeros
+        for (int i = 0; i < n; i++) {
+            ssize_t have = read - (ssize_t)i * PAGE_SIZE;
+            if (have < 0) have = 0;
+            if (have < PAGE_SIZE) memset(memPages[done + i] + have, 0, PAGE_SIZE - have);
+        }
+        done += n;
+    }
+
+    // update current page value
+    fHandle->curPagePos = pageNum + numPages - 1;
+#ifdef SIMULATE
+    printf("%s(): latency %d\n", __func__, latency());
+#endif
+    return RC_OK;    
+}
+
 /** 
 * @brief read a page from page file
 * @param fHandle, input value, a storage manager file structure pointer
@@ -370,6 +425,57 @@ RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
     return RC_OK;    
 }
 
+/** 
+* @brief write consecutive pages from separate buffers, one vectored write per WRITE_BATCH_PAGES pages
+* @param pageNum, input value, first page to write
+* @param numPages, input value, number of pages
+* @param fHandle, input value, a storage manager file structure pointer
+* @param memPages, input value, numPages page buffers, memPages[i] is written to page pageNum + i
+* @return error code
+*/
+RC writeBlocks (int pageNum, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages)
+{
+    // check input parameters are ok or not
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) 
+        return RC_FILE_HANDLE_NOT_INIT;
+    if (memPages == NULL || numPages < 0) 
+        return RC_WRITE_FAILED;
+    if (pageNum < 0) 
+        return RC_INVALID_PAGE_NUM;
+    if (numPages == 0) 
+        return RC_OK;
+
+    // ensure capacity so all pages exist
+    RC rc = ensureCapacity(pageNum + numPages, fHandle);
+    if (rc != RC_OK) return rc;
+
+    // the pages bypass stdio: flushing first leaves no buffered data, the next fseek reads from the file again
+    FILE *fp = (FILE *)fHandle->mgmtInfo;
+    if (fflush(fp) != 0) 
+        return RC_WRITE_FAILED;
+    int fd = fileno(fp);
+
+    struct iovec iov[WRITE_BATCH_PAGES];
+    for (int done = 0; done < numPages; ) {
+        int n = (numPages - done < WRITE_BATCH_PAGES) ? numPages - done : WRITE_BATCH_PAGES;
+        for (int i = 0; i < n; i++) {
+            iov[i].iov_base = memPages[done + i];
+            iov[i].iov_len = PAGE_SIZE;
+        }
+        ssize_t written = pwritev(fd, iov, n, (off_t)(pageNum + done) * PAGE_SIZE);
+        if (written != (ssize_t)n * PAGE_SIZE) 
+            return RC_WRITE_FAILED;
+        done += n;
+    }
+
+    // update current page value
+    fHandle->curPagePos = pageNum + numPages - 1;
+#ifdef SIMULATE
+    printf("%s(): latency %d\n", __func__, latency());
+#endif
+    return RC_OK;    
+}
+
 /** 
 * @brief overwrite current page of page file
 * @param fHandle, input value, a storage manager file structure pointer
@@ -428,39 +534,27 @@ RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle)
     // check input parameters is valid or not
     if (fHandle == NULL || fHandle->mgmtInfo == NULL) 
         return RC_FILE_HANDLE_NOT_INIT;
-    if (numberOfPages <= 0) 
+    if (numberOfPages <= 0 || numberOfPages <= fHandle->totalNumPages) 
         return RC_OK;
 
-    // extend empty page one by one
+    // set file pointer to end of the file once
+    FILE *fp = (FILE *)fHandle->mgmtInfo;
+    if (fseek(fp, 0L, SEEK_END) != 0) 
+        return RC_WRITE_FAILED;
+
+    // write all zero pages, then flush once
     while (fHandle->totalNumPages < numberOfPages) {
-        RC rc = appendEmptyBlock(fHandle);
-        if (rc != RC_OK) 
-            return rc;
+        size_t written = fwrite((void *)ZeroPage, 1, PAGE_SIZE, fp);
+        if (written != PAGE_SIZE) 
+            return RC_WRITE_FAILED;
+        fHandle->totalNumPages++;
     }
-    return RC_OK;
-}
+    fflush(fp);
 
-// RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle) {
-//     if (fHandle == NULL || fHandle->mgmtInfo == NULL) 
-//         return RC_FILE_HANDLE_NOT_INIT;
-//     if (numberOfPages <= 0 || numberOfPages <= fHandle->totalNumPages) 
-//         return RC_OK;
-
-//     FILE *fp = (FILE *)fHandle->mgmtInfo;
-//     int pagesToAdd = numberOfPages - fHandle->totalNumPages;
-
-//     // 移动到文件末尾
-//     if (fseek(fp, 0L, SEEK_END) != 0) 
-//         return RC_WRITE_FAILED;
-
-//     // 批量写入空页（减少I/O操作）
-//     for (int i = 0; i < pagesToAdd; i++) {
-//         size_t written = fwrite(ZeroPage, 1, PAGE_SIZE, fp);
-//         if (written != PAGE_SIZE) 
-//             return RC_WRITE_FAILED;
-//         fHandle->totalNumPages++;
-//     }
-
-//     fflush(fp);
-//     return RC_OK;
-// }
\ No newline at end of file
+    // update current page number
+    fHandle->curPagePos = fHandle->totalNumPages - 1;
+#ifdef SIMULATE
+    printf("%s(): latency %d\n", __func__, latency());
+#endif
+    return RC_OK;
+}
\ No newline at end of file
@@ -0,0 +1,1769 @@
+#include "storage_mgr.h"
+#include "buffer_mgr_stat.h"
+#include "buffer_mgr.h"
+#include "dberror.h"
+#include "test_helper.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// check whether two the content of a buffer pool is the same as an expected content
+// (given in the format produced by sprintPoolContent)
+#define ASSERT_EQUALS_POOL(expected,bm,message)			        \
+		do {									\
+			char *real;								\
+			char *_exp = (char *) (expected);                                   \
+			real = sprintPoolContent(bm);					\
+			if (strcmp((_exp),real) != 0)					\
+			{									\
+				printf("[%s-%s-L%i-%s] FAILED: expected <%s> but was <%s>: %s\n",TEST_INFO, _exp, real, message); \
+				free(real);							\
+				exit(1);							\
+			}									\
+			printf("[%s-%s-L%i-%s] OK: expected <%s> and was <%s>: %s\n",TEST_INFO, _exp, real, message); \
+			free(real);								\
+		} while(0)
+
+// test methods
+static void testFIFO (void);
+static void testLRU (void);
+static void testLRUPinnedFrames (void);
+static void testLFU (void);
+static void testLRUK (void);
+static void testARC (void);
+static void test2Q (void);
+static void testLargePoolPageTable (void);
+static void testConcurrentPins (void);
+static void testPageLatches (void);
+static void testBackgroundCleaner (void);
+static void testPrefetch (void);
+static void testPinNewPage (void);
+static void testAccessStrategy (void);
+static void testResizeBufferPool (void);
+static void testSharedPool (void);
+static void testBatchFlush (void);
+static void testPoolStats (void);
+static void testAccessTrace (void);
+static void testAdaptivePolicy (void);
+static void testPartitionedPool (void);
+static void testGCLOCK (void);
+static void testWarmRestart (void);
+static void testPinWait (void);
+
+// helper methods
+static void createDummyPages (BM_BufferPool *bm, int num);
+static void accessPage (BM_BufferPool *bm, BM_PageHandle *h, int pageNum);
+static void *pinWorker (void *arg);
+static void *latchWorker (void *arg);
+
+// test name
+char *testName;
+
+// main method
+int
+main (void)
+{
+	initStorageManager();
+	testName = "";
+
+	testFIFO();
+	testLRU();
+	testLRUPinnedFrames();
+	testLFU();
+	testLRUK();
+	testARC();
+	test2Q();
+	testLargePoolPageTable();
+	testConcurrentPins();
+	testPageLatches();
+	testBackgroundCleaner();
+	testPrefetch();
+	testPinNewPage();
+	testAccessStrategy();
+	testResizeBufferPool();
+	testSharedPool();
+	testBatchFlush();
+	testPoolStats();
+	testAccessTrace();
+	testAdaptivePolicy();
+	testPartitionedPool();
+	testGCLOCK();
+	testWarmRestart();
+	testPinWait();
+
+	return 0;
+}
+
+// create n pages with content "Page X"
+static void
+createDummyPages (BM_BufferPool *bm, int num)
+{
+	int i;
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+
+	CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+	for (i = 0; i < num; i++)
+	{
+		CHECK(pinPage(bm, h, i));
+		sprintf(h->data, "%s-%i", "Page", h->pageNum);
+		CHECK(markDirty(bm, h));
+		CHECK(unpinPage(bm, h));
+	}
+	CHECK(shutdownBufferPool(bm));
+
+	free(h);
+}
+
+// pin and directly unpin a page
+static void
+accessPage (BM_BufferPool *bm, BM_PageHandle *h, int pageNum)
+{
+	CHECK(pinPage(bm, h, pageNum));
+	CHECK(unpinPage(bm, h));
+}
+
+// ************************************************************
+void
+testFIFO (void)
+{
+	// expected results
+	const char *poolContents[] = {
+		"[0 0],[-1 0],[-1 0]" ,
+		"[0 0],[1 0],[-1 0]",
+		"[0 0],[1 0],[2 0]",
+		"[3 0],[1 0],[2 0]",
+		"[3 0],[4 0],[2 0]",
+		"[3 0],[4 1],[2 0]",
+		"[3 0],[4 1],[5x0]",
+		"[6x0],[4 1],[5x0]",
+		"[6x0],[4 1],[0x0]",
+		"[6x0],[4 0],[0x0]",
+		"[6 0],[4 0],[0 0]"
+	};
+	const int requests[] = {0,1,2,3,4,4,5,6,0};
+	const int numLinRequests = 5;
+	const int numChangeRequests = 3;
+
+	int i;
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	testName = "Testing FIFO page replacement";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 100);
+	CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+
+	// reading some pages linearly with direct unpin and no modifications
+	for (i = 0; i < numLinRequests; i++)
+	{
+		pinPage(bm, h, requests[i]);
+		unpinPage(bm, h);
+		ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+	}
+
+	// pin one page and test remainder
+	i = numLinRequests;
+	pinPage(bm, h, requests[i]);
+	ASSERT_EQUALS_POOL(poolContents[i], bm, "pool content after pin page");
+
+	// read pages and mark them as dirty
+	for (i = numLinRequests + 1; i < numLinRequests + numChangeRequests + 1; i++)
+	{
+		pinPage(bm, h, requests[i]);
+		markDirty(bm, h);
+		unpinPage(bm, h);
+		ASSERT_EQUALS_POOL(poolContents[i], bm, "check pool content");
+	}
+
+	// flush buffer pool to disk
+	i = numLinRequests + numChangeRequests + 1;
+	h->pageNum = 4;
+	unpinPage(bm, h);
+	ASSERT_EQUALS_POOL(poolContents[i], bm, "unpin last page");
+
+	i++;
+	forceFlushPool(bm);
+	ASSERT_EQUALS_POOL(poolContents[i], bm, "pool content after flush");
+
+	ASSERT_EQUALS_INT(3, getNumWriteIO(bm), "check number of write I/Os");
+	ASSERT_EQUALS_INT(8, getNumReadIO(bm), "check number of read I/Os");
+
+	CHECK(shutdownBufferPool(bm));
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testLRU (void)
+{
+	// expected results
+	const char *poolContents[] = {
+		// read first five pages and directly unpin them
+		"[0 0],[-1 0],[-1 0],[-1 0],[-1 0]" ,
+		"[0 0],[1 0],[-1 0],[-1 0],[-1 0]",
+		"[0 0],[1 0],[2 0],[-1 0],[-1 0]",
+		"[0 0],[1 0],[2 0],[3 0],[-1 0]",
+		"[0 0],[1 0],[2 0],[3 0],[4 0]",
+		// use some of the page to create a fixed LRU order without changing pool content
+		"[0 0],[1 0],[2 0],[3 0],[4 0]",
+		"[0 0],[1 0],[2 0],[3 0],[4 0]",
+		"[0 0],[1 0],[2 0],[3 0],[4 0]",
+		"[0 0],[1 0],[2 0],[3 0],[4 0]",
+		"[0 0],[1 0],[2 0],[3 0],[4 0]",
+		// check that pages get evicted in LRU order
+		"[0 0],[1 0],[2 0],[5 0],[4 0]",
+		"[0 0],[1 0],[2 0],[5 0],[6 0]",
+		"[7 0],[1 0],[2 0],[5 0],[6 0]",
+		"[7 0],[1 0],[8 0],[5 0],[6 0]",
+		"[7 0],[9 0],[8 0],[5 0],[6 0]"
+	};
+	const int orderRequests[] = {3,4,0,2,1};
+
+	int i;
+	int snapshot = 0;
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	testName = "Testing LRU page replacement";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 100);
+	CHECK(initBufferPool(bm, "testbuffer.bin", 5, RS_LRU, NULL));
+
+	// reading first five pages linearly with direct unpin and no modifications
+	for (i = 0; i < 5; i++)
+	{
+		pinPage(bm, h, i);
+		unpinPage(bm, h);
+		ASSERT_EQUALS_POOL(poolContents[snapshot++], bm, "check pool content reading in pages");
+	}
+
+	// read pages to change LRU order
+	for (i = 0; i < 5; i++)
+	{
+		pinPage(bm, h, orderRequests[i]);
+		unpinPage(bm, h);
+		ASSERT_EQUALS_POOL(poolContents[snapshot++], bm, "check pool content using pages");
+	}
+
+	// replace pages and check that it happens in LRU order
+	for (i = 0; i < 5; i++)
+	{
+		pinPage(bm, h, 5 + i);
+		unpinPage(bm, h);
+		ASSERT_EQUALS_POOL(poolContents[snapshot++], bm, "check pool content using pages");
+	}
+
+	ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "check number of write I/Os");
+	ASSERT_EQUALS_INT(10, getNumReadIO(bm), "check number of read I/Os");
+
+	CHECK(shutdownBufferPool(bm));
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************
+// pinned frames are never LRU victims, even when they are the least recently used
+void
+testLRUPinnedFrames (void)
+{
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	BM_PageHandle *p0 = MAKE_PAGE_HANDLE();
+	testName = "Testing LRU with pinned frames";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 10);
+	CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+
+	CHECK(pinPage(bm, p0, 0));
+	CHECK(pinPage(bm, h, 1));
+	CHECK(unpinPage(bm, h));
+	CHECK(pinPage(bm, h, 2));
+	CHECK(unpinPage(bm, h));
+	ASSERT_EQUALS_POOL("[0 1],[1 0],[2 0]", bm, "page 0 stays pinned");
+
+	// re-pinning page 1 takes it out of the list, unpinning makes it most recent
+	CHECK(pinPage(bm, h, 1));
+	CHECK(unpinPage(bm, h));
+	CHECK(pinPage(bm, h, 3));
+	CHECK(unpinPage(bm, h));
+	ASSERT_EQUALS_POOL("[0 1],[1 0],[3 0]", bm, "least recently unpinned page 2 is evicted");
+	CHECK(pinPage(bm, h, 4));
+	ASSERT_EQUALS_POOL("[0 1],[4 1],[3 0]", bm, "pinned page 0 is skipped");
+	CHECK(pinPage(bm, h, 3));
+	ASSERT_ERROR(pinPage(bm, h, 5), "all frames are pinned");
+
+	// unpinning page 0 makes it the only candidate
+	CHECK(unpinPage(bm, p0));
+	CHECK(pinPage(bm, h, 5));
+	ASSERT_EQUALS_POOL("[5 1],[4 1],[3 1]", bm, "page 0 is evicted after unpin");
+
+	CHECK(shutdownBufferPool(bm));
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(h);
+	free(p0);
+	TEST_DONE();
+}
+
+// ************************************************************
+// LFU evicts the page with the fewest references, aging lets old counts fade
+void
+testLFU (void)
+{
+	BM_LFUParams aging = { 4 };
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	testName = "Testing LFU page replacement";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 20);
+
+	CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LFU, NULL));
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 1);
+	accessPage(bm, h, 1);
+	accessPage(bm, h, 2);
+	accessPage(bm, h, 3);
+	ASSERT_EQUALS_POOL("[0 0],[1 0],[3 0]", bm, "page with the fewest references is evicted");
+	accessPage(bm, h, 3);
+	accessPage(bm, h, 3);
+	accessPage(bm, h, 4);
+	ASSERT_EQUALS_POOL("[0 0],[4 0],[3 0]", bm, "the older page goes among equal counts");
+	CHECK(pinPage(bm, h, 4));
+	accessPage(bm, h, 5);
+	ASSERT_EQUALS_POOL("[5 0],[4 1],[3 0]", bm, "pinned page 4 is skipped, page 0 reached 3 references first");
+	h->pageNum = 4;
+	CHECK(unpinPage(bm, h));
+	CHECK(shutdownBufferPool(bm));
+
+	// without aging page 0 keeps its old count
+	CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LFU, NULL));
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 1);
+	accessPage(bm, h, 1);
+	accessPage(bm, h, 2);
+	ASSERT_EQUALS_POOL("[0 0],[2 0]", bm, "stale page stays without aging");
+	CHECK(shutdownBufferPool(bm));
+
+	// halving after 4 references brings both pages back to 1
+	CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LFU, &aging));
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 1);
+	accessPage(bm, h, 1);
+	accessPage(bm, h, 2);
+	ASSERT_EQUALS_POOL("[2 0],[1 0]", bm, "stale page is evicted after aging");
+	CHECK(shutdownBufferPool(bm));
+
+	// a pinned page is in no bucket list but its count is halved with the others,
+	// once unpinned it rejoins the merged bucket behind page 1
+	CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LFU, &aging));
+	CHECK(pinPage(bm, h, 0));
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 1);
+	h->pageNum = 0;
+	CHECK(unpinPage(bm, h));
+	accessPage(bm, h, 2);
+	ASSERT_EQUALS_POOL("[0 0],[2 0]", bm, "page 1 reached count 1 first");
+	CHECK(shutdownBufferPool(bm));
+
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testLRUK (void)
+{
+	BM_LRUKParams correlated = { 2, 5, 0 };
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	testName = "Testing LRU-K page replacement";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 20);
+
+	// pages referenced once (a scan) go before pages referenced K times
+	CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU_K, NULL));
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 1);
+	accessPage(bm, h, 1);
+	accessPage(bm, h, 10);
+	accessPage(bm, h, 11);
+	accessPage(bm, h, 12);
+	ASSERT_EQUALS_POOL("[0 0],[1 0],[12 0]", bm, "scan does not evict the hot pages");
+	ASSERT_EQUALS_INT(5, getNumReadIO(bm), "check number of read I/Os");
+	CHECK(shutdownBufferPool(bm));
+
+	// an evicted page keeps its history, so its second reference counts
+	CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LRU_K, NULL));
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 1);
+	accessPage(bm, h, 2);
+	ASSERT_EQUALS_POOL("[0 0],[2 0]", bm, "page 1 has fewer than K references");
+	accessPage(bm, h, 1);
+	ASSERT_EQUALS_POOL("[0 0],[1 0]", bm, "page 2 has fewer than K references");
+	accessPage(bm, h, 3);
+	ASSERT_EQUALS_POOL("[3 0],[1 0]", bm, "page 1 has a more recent K-th reference than page 0");
+	CHECK(shutdownBufferPool(bm));
+
+	// references inside the correlated period count as one
+	CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LRU_K, &correlated));
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 1);
+	CHECK(pinPage(bm, h, 2));
+	ASSERT_EQUALS_POOL("[2 1],[1 0]", bm, "correlated references to page 0 do not protect it");
+	CHECK(pinPage(bm, h, 1));
+	ASSERT_ERROR(pinPage(bm, h, 3), "all frames are pinned");
+	CHECK(shutdownBufferPool(bm));
+
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+
+// ************************************************************
+// ARC keeps pages seen twice in T2 and adapts the T1 target on ghost hits
+void
+testARC (void)
+{
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	testName = "Testing ARC page replacement";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 20);
+
+	CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_ARC, NULL));
+	// pages 0 and 1 are referenced twice and move to T2, the scan stays in T1
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 1);
+	accessPage(bm, h, 1);
+	accessPage(bm, h, 10);
+	accessPage(bm, h, 11);
+	accessPage(bm, h, 12);
+	ASSERT_EQUALS_POOL("[0 0],[1 0],[12 0]", bm, "scan does not evict the pages in T2");
+
+	// a hit in B1 grows T1's target, so the LRU page of T2 goes
+	accessPage(bm, h, 10);
+	ASSERT_EQUALS_POOL("[10 0],[1 0],[12 0]", bm, "B1 ghost hit evicts from T2");
+
+	// a hit in B2 shrinks it again, so the LRU page of T1 goes
+	accessPage(bm, h, 0);
+	ASSERT_EQUALS_POOL("[10 0],[1 0],[0 0]", bm, "B2 ghost hit evicts from T1");
+	ASSERT_EQUALS_INT(7, getNumReadIO(bm), "check number of read I/Os");
+
+	// pinned frames are skipped
+	CHECK(pinPage(bm, h, 10));
+	CHECK(pinPage(bm, h, 1));
+	CHECK(pinPage(bm, h, 0));
+	ASSERT_ERROR(pinPage(bm, h, 5), "all frames are pinned");
+	h->pageNum = 1;
+	CHECK(unpinPage(bm, h));
+	CHECK(pinPage(bm, h, 5));
+	ASSERT_EQUALS_POOL("[10 1],[5 1],[0 1]", bm, "only the unpinned frame is replaced");
+	CHECK(shutdownBufferPool(bm));
+
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+// ************************************************************
+// 2Q keeps pages seen once in A1in, so a scan only cycles through A1in
+void
+test2Q (void)
+{
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	testName = "Testing 2Q page replacement";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 20);
+
+	// 4 frames: Kin = 1, Kout = 2
+	CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_2Q, NULL));
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 1);
+	accessPage(bm, h, 2);
+	accessPage(bm, h, 3);
+	accessPage(bm, h, 4);
+	ASSERT_EQUALS_POOL("[4 0],[1 0],[2 0],[3 0]", bm, "A1in is a FIFO");
+
+	// page 0 is still in A1out, its second reference moves it to Am
+	accessPage(bm, h, 0);
+	ASSERT_EQUALS_POOL("[4 0],[0 0],[2 0],[3 0]", bm, "A1out hit loads the page into Am");
+
+	// a scan only replaces pages of A1in
+	for (int i = 10; i < 16; i++)
+		accessPage(bm, h, i);
+	ASSERT_EQUALS_POOL("[15 0],[0 0],[13 0],[14 0]", bm, "scan does not evict the page in Am");
+
+	// page 12 left A1in recently enough to be promoted, page 1 did not
+	accessPage(bm, h, 12);
+	ASSERT_EQUALS_POOL("[15 0],[0 0],[12 0],[14 0]", bm, "A1out hit after the scan");
+	accessPage(bm, h, 1);
+	ASSERT_EQUALS_POOL("[15 0],[0 0],[12 0],[1 0]", bm, "page 1 was forgotten and goes to A1in");
+	ASSERT_EQUALS_INT(14, getNumReadIO(bm), "check number of read I/Os");
+	CHECK(shutdownBufferPool(bm));
+
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************
+// fill a large pool, re-pin every page through the page table and
+// check that evicted pages disappear from it
+void
+testLargePoolPageTable (void)
+{
+	const int numFrames = 2000;
+	int i;
+	bool ok = true;
+	PageNumber *contents;
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	testName = "Testing page table on a large pool";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 2 * numFrames);
+	CHECK(initBufferPool(bm, "testbuffer.bin", numFrames, RS_FIFO, NULL));
+
+	// load every frame once, frames are handed out in order
+	for (i = 0; i < numFrames; i++)
+	{
+		CHECK(pinPage(bm, h, i));
+		CHECK(unpinPage(bm, h));
+	}
+	contents = getFrameContents(bm);
+	for (i = 0; i < numFrames; i++)
+		ok = ok && (contents[i] == i);
+	free(contents);
+	ASSERT_TRUE(ok, "frame i holds page i");
+
+	// every page is a hit now
+	for (i = numFrames - 1; i >= 0; i--)
+	{
+		CHECK(pinPage(bm, h, i));
+		ok = ok && (strncmp(h->data, "Page-", 5) == 0) && (atoi(h->data + 5) == i);
+		CHECK(unpinPage(bm, h));
+	}
+	ASSERT_TRUE(ok, "hits return the right page data");
+	ASSERT_EQUALS_INT(numFrames, getNumReadIO(bm), "hits do not read from disk");
+
+	// evict the first half and make sure the old pages are gone from the page table
+	for (i = 0; i < numFrames / 2; i++)
+	{
+		CHECK(pinPage(bm, h, numFrames + i));
+		CHECK(unpinPage(bm, h));
+	}
+	h->pageNum = 0;
+	ASSERT_ERROR(unpinPage(bm, h), "evicted page is no longer in the page table");
+	h->pageNum = numFrames / 2 - 1;
+	ASSERT_ERROR(markDirty(bm, h), "markDirty only works on resident pages");
+	CHECK(pinPage(bm, h, numFrames + 1));
+	ASSERT_EQUALS_INT(numFrames + 1, atoi(h->data + 5), "replaced page is found through the page table");
+	CHECK(unpinPage(bm, h));
+	ASSERT_EQUALS_INT(numFrames + numFrames / 2, getNumReadIO(bm), "check number of read I/Os");
+
+	CHECK(shutdownBufferPool(bm));
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************
+// worker of testConcurrentPins: random pins with content checks
+typedef struct PinWorkerArg {
+	BM_BufferPool *bm;
+	unsigned int seed;
+	int numPages;
+	int numOps;
+	bool ok;
+} PinWorkerArg;
+
+static void *
+pinWorker (void *arg)
+{
+	PinWorkerArg *w = (PinWorkerArg *) arg;
+	BM_PageHandle h;
+	int i;
+
+	for (i = 0; i < w->numOps; i++)
+	{
+		int pageNum = rand_r(&w->seed) % w->numPages;
+		CHECK(pinPage(w->bm, &h, pageNum));
+		w->ok = w->ok && (h.pageNum == pageNum) && (atoi(h.data + 5) == pageNum);
+		if (i % 7 == 0)
+			CHECK(markDirty(w->bm, &h));
+		CHECK(unpinPage(w->bm, &h));
+	}
+	return NULL;
+}
+
+// ************************************************************
+// several threads pin and unpin on a small pool, so hits and evictions race
+void
+testConcurrentPins (void)
+{
+	const ReplacementStrategy strategies[] = { RS_CLOCK, RS_FIFO, RS_LRU, RS_ARC };
+	const int numThreads = 4;
+	BM_PoolOptions options = { true, 4 };
+	PinWorkerArg args[4];
+	pthread_t threads[4];
+	int s, i;
+	BM_BufferPool *bm = MAKE_POOL();
+	testName = "Testing concurrent pins";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 40);
+
+	for (s = 0; s < 4; s++)
+	{
+		bool ok = true;
+		int *fixCounts;
+
+		CHECK(initBufferPoolEx(bm, "testbuffer.bin", 10, strategies[s], NULL, &options));
+		for (i = 0; i < numThreads; i++)
+		{
+			args[i].bm = bm;
+			args[i].seed = 525 + i;
+			args[i].numPages = 40;
+			args[i].numOps = 5000;
+			args[i].ok = true;
+			pthread_create(&threads[i], NULL, pinWorker, &args[i]);
+		}
+		for (i = 0; i < numThreads; i++)
+		{
+			pthread_join(threads[i], NULL);
+			ok = ok && args[i].ok;
+		}
+		ASSERT_TRUE(ok, "every pin returned the requested page");
+
+		fixCounts = getFixCounts(bm);
+		for (i = 0; i < 10; i++)
+			ok = ok && (fixCounts[i] == 0);
+		free(fixCounts);
+		ASSERT_TRUE(ok, "all fix counts are back to 0");
+		CHECK(shutdownBufferPool(bm));
+	}
+
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	TEST_DONE();
+}
+
+// ************************************************************
+// worker of testPageLatches: increment a counter stored in a page under the exclusive latch,
+// and check under the shared latch that both copies of it agree
+static void *
+latchWorker (void *arg)
+{
+	PinWorkerArg *w = (PinWorkerArg *) arg;
+	BM_PageHandle h;
+	int i;
+
+	for (i = 0; i < w->numOps; i++)
+	{
+		int pageNum = rand_r(&w->seed) % w->numPages;
+		int *counter;
+		if (i % 2 == 0)
+		{
+			CHECK(pinPageExclusive(w->bm, &h, pageNum));
+			counter = (int *) h.data;
+			counter[0]++;
+			counter[1] = counter[0];
+			CHECK(markDirty(w->bm, &h));
+		}
+		else
+		{
+			CHECK(pinPageShared(w->bm, &h, pageNum));
+			counter = (int *) h.data;
+			w->ok = w->ok && (counter[0] == counter[1]);
+		}
+		CHECK(unpinPageLatched(w->bm, &h));
+	}
+	return NULL;
+}
+
+// worker of testPageLatches: force a page that another thread holds under its exclusive latch
+typedef struct ForceWorkerArg {
+	BM_BufferPool *bm;
+	PageNumber pageNum;
+	RC rc;
+} ForceWorkerArg;
+
+static void *
+forceWorker (void *arg)
+{
+	ForceWorkerArg *w = (ForceWorkerArg *) arg;
+	BM_PageHandle h;
+
+	h.pageNum = w->pageNum;
+	w->rc = forcePage(w->bm, &h);
+	return NULL;
+}
+
+// ************************************************************
+// exclusive latches serialize writers of a page, shared latches never see a half-done update
+void
+testPageLatches (void)
+{
+	const int numThreads = 4;
+	const int numPages = 8;
+	BM_PoolOptions options = { true, 0 };
+	PinWorkerArg args[4];
+	pthread_t threads[4];
+	ForceWorkerArg force;
+	SM_FileHandle fh;
+	char page[PAGE_SIZE];
+	BM_PageHandle h;
+	int i, writes, total = 0;
+	bool ok = true;
+	BM_BufferPool *bm = MAKE_POOL();
+	testName = "Testing shared and exclusive page latches";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	// pool smaller than the page set, so latched pages also get flushed and evicted
+	CHECK(initBufferPoolEx(bm, "testbuffer.bin", 4, RS_CLOCK, NULL, &options));
+	for (i = 0; i < numThreads; i++)
+	{
+		args[i].bm = bm;
+		args[i].seed = 525 + i;
+		args[i].numPages = numPages;
+		args[i].numOps = 4000;
+		args[i].ok = true;
+		pthread_create(&threads[i], NULL, latchWorker, &args[i]);
+	}
+	for (i = 0; i < numThreads; i++)
+	{
+		pthread_join(threads[i], NULL);
+		ok = ok && args[i].ok;
+	}
+	ASSERT_TRUE(ok, "readers never see a half-done update");
+
+	for (i = 0; i < numPages; i++)
+	{
+		CHECK(pinPageShared(bm, &h, i));
+		total += ((int *) h.data)[0];
+		CHECK(unpinPageLatched(bm, &h));
+	}
+	ASSERT_EQUALS_INT(numThreads * 4000 / 2, total, "no increment was lost");
+
+	// forcePage writes a page for the thread holding its exclusive latch and reports it to the others
+	CHECK(pinPageExclusive(bm, &h, 0));
+	sprintf(h.data, "%s", "Forced-0");
+	CHECK(markDirty(bm, &h));
+	force.bm = bm;
+	force.pageNum = 0;
+	force.rc = RC_OK;
+	writes = getNumWriteIO(bm);
+	pthread_create(&threads[0], NULL, forceWorker, &force);
+	pthread_join(threads[0], NULL);
+	ASSERT_EQUALS_INT(RC_PAGE_LATCHED, force.rc, "another thread can not force the latched page");
+	ASSERT_EQUALS_INT(writes, getNumWriteIO(bm), "the skipped write is not counted");
+	CHECK(forcePage(bm, &h));
+	ASSERT_EQUALS_INT(writes + 1, getNumWriteIO(bm), "the latch holder's page is written");
+	CHECK(unpinPageLatched(bm, &h));
+	CHECK(openPageFile("testbuffer.bin", &fh));
+	CHECK(readBlock(0, &fh, page));
+	ASSERT_EQUALS_STRING("Forced-0", page, "forced page is in the file");
+	CHECK(closePageFile(&fh));
+	CHECK(shutdownBufferPool(bm));
+
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testBackgroundCleaner (void)
+{
+	// writer every ms, 1% of 4 unpinned frames rounds down to 0 dirty frames tolerated
+	BM_PoolOptions options = { false, 0, 1, 1 };
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	BM_BufferPool *bm = MAKE_POOL();
+	int i, waitedMs;
+	bool *dirty;
+	bool anyDirty = true;
+	testName = "Testing the background dirty page writer";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	CHECK(initBufferPoolEx(bm, "testbuffer.bin", 4, RS_LRU, NULL, &options));
+	for (i = 0; i < 4; i++)
+	{
+		CHECK(pinPage(bm, h, i));
+		sprintf(h->data, "%s-%i", "Page", h->pageNum);
+		CHECK(markDirty(bm, h));
+		CHECK(unpinPage(bm, h));
+	}
+
+	for (waitedMs = 0; anyDirty && waitedMs < 2000; waitedMs++)
+	{
+		usleep(1000);
+		dirty = getDirtyFlags(bm);
+		anyDirty = false;
+		for (i = 0; i < 4; i++)
+			anyDirty = anyDirty || dirty[i];
+		free(dirty);
+	}
+	ASSERT_TRUE(!anyDirty, "the writer cleaned all unpinned frames");
+	ASSERT_EQUALS_INT(4, getNumWriteIO(bm), "each page was written once");
+
+	// a pinned dirty page is left alone
+	CHECK(pinPage(bm, h, 0));
+	CHECK(markDirty(bm, h));
+	usleep(20000);
+	dirty = getDirtyFlags(bm);
+	ASSERT_TRUE(dirty[0], "pinned page is still dirty");
+	free(dirty);
+	CHECK(unpinPage(bm, h));
+
+	CHECK(shutdownBufferPool(bm));
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testPrefetch (void)
+{
+	// read ahead 3 pages once 2 pins in a row asked for the next page
+	BM_PoolOptions options = { false, 0, 0, 0, 3 };
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	BM_PageHandle pinned[3];
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PoolStats stats;
+	char expected[16];
+	PageNumber *contents;
+	int *fixCounts;
+	int i, waitedMs;
+	bool found;
+	testName = "Testing prefetch and sequential read-ahead";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 10);
+
+	// without an I/O thread the pages are loaded by the call
+	CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+	CHECK(prefetchRange(bm, 0, 2));
+	ASSERT_EQUALS_POOL("[0 0],[1 0],[-1 0]", bm, "pages 0 and 1 are loaded unpinned");
+	ASSERT_EQUALS_INT(2, getNumReadIO(bm), "two reads");
+	CHECK(prefetchPage(bm, 100));
+	ASSERT_EQUALS_INT(2, getNumReadIO(bm), "pages past the end of the file are ignored");
+	CHECK(getPoolStats(bm, &stats));
+	ASSERT_EQUALS_INT(0, (int) (stats.hits + stats.misses), "a prefetch is not a pin");
+	CHECK(pinPage(bm, h, 1));
+	ASSERT_EQUALS_STRING("Page-1", h->data, "prefetched page content");
+	ASSERT_EQUALS_INT(2, getNumReadIO(bm), "pin of a prefetched page is a hit");
+	CHECK(unpinPage(bm, h));
+	// a prefetch that finds every frame pinned is dropped
+	for (i = 0; i < 3; i++)
+		CHECK(pinPage(bm, &pinned[i], i));
+	CHECK(prefetchRange(bm, 5, 2));
+	ASSERT_EQUALS_POOL("[0 1],[1 1],[2 1]", bm, "no page is prefetched without a frame");
+	for (i = 0; i < 3; i++)
+		CHECK(unpinPage(bm, &pinned[i]));
+	CHECK(shutdownBufferPool(bm));
+
+	// read-ahead: pins of 0, 1, 2 queue pages 2..5 for the I/O thread
+	CHECK(initBufferPoolEx(bm, "testbuffer.bin", 8, RS_LRU, NULL, &options));
+	for (i = 0; i < 3; i++)
+	{
+		CHECK(pinPage(bm, h, i));
+		sprintf(expected, "%s-%i", "Page", i);
+		ASSERT_EQUALS_STRING(expected, h->data, "page pinned during read-ahead");
+		CHECK(unpinPage(bm, h));
+	}
+	for (waitedMs = 0; getNumReadIO(bm) < 6 && waitedMs < 2000; waitedMs++)
+		usleep(1000);
+	ASSERT_EQUALS_INT(6, getNumReadIO(bm), "pages 3..5 were read ahead");
+	contents = getFrameContents(bm);
+	fixCounts = getFixCounts(bm);
+	found = true;
+	for (i = 0; i < 8; i++)
+		if (contents[i] >= 3 && contents[i] <= 5)
+			found = found && fixCounts[i] == 0;
+	ASSERT_TRUE(found, "read-ahead pages are unpinned");
+	free(contents);
+	free(fixCounts);
+
+	// a pin right after the prefetch request either waits for the read or loads the page itself
+	CHECK(prefetchPage(bm, 8));
+	CHECK(pinPage(bm, h, 8));
+	ASSERT_EQUALS_STRING("Page-8", h->data, "pin of a page in flight");
+	CHECK(unpinPage(bm, h));
+	CHECK(pinPage(bm, h, 3));
+	ASSERT_EQUALS_STRING("Page-3", h->data, "read-ahead page content");
+	CHECK(unpinPage(bm, h));
+	CHECK(shutdownBufferPool(bm));
+
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testPinNewPage (void)
+{
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	BM_BufferPool *bm = MAKE_POOL();
+	SM_FileHandle fh;
+	char page[PAGE_SIZE];
+	bool *dirty;
+	int i;
+	bool zero = true;
+	testName = "Testing pinNewPage";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+
+	// a new page past the end of the file is neither read nor added to the file yet
+	CHECK(pinNewPage(bm, h, 3));
+	for (i = 0; i < PAGE_SIZE; i++)
+		zero = zero && h->data[i] == 0;
+	ASSERT_TRUE(zero, "new page is zeroed");
+	sprintf(h->data, "%s-%i", "Page", h->pageNum);
+	CHECK(unpinPageLatched(bm, h));
+	ASSERT_EQUALS_INT(0, getNumReadIO(bm), "no read for a new page");
+	dirty = getDirtyFlags(bm);
+	ASSERT_TRUE(dirty[0], "new page is dirty");
+	free(dirty);
+	CHECK(openPageFile("testbuffer.bin", &fh));
+	ASSERT_EQUALS_INT(1, fh.totalNumPages, "file is not extended before the page is written");
+	CHECK(closePageFile(&fh));
+
+	// a resident page is pinned as it is
+	CHECK(pinNewPage(bm, h, 3));
+	ASSERT_EQUALS_STRING("Page-3", h->data, "resident page keeps its content");
+	CHECK(unpinPageLatched(bm, h));
+
+	// the first write back extends the file
+	CHECK(forceFlushPool(bm));
+	ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "one write");
+	CHECK(openPageFile("testbuffer.bin", &fh));
+	ASSERT_EQUALS_INT(4, fh.totalNumPages, "file extended to the new page");
+	CHECK(readBlock(3, &fh, page));
+	ASSERT_EQUALS_STRING("Page-3", page, "new page written");
+	CHECK(closePageFile(&fh));
+	CHECK(shutdownBufferPool(bm));
+
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testAccessStrategy (void)
+{
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_AccessStrategy *ring;
+	int i;
+	testName = "Testing scan ring access strategy";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 40);
+
+	CHECK(initBufferPool(bm, "testbuffer.bin", 8, RS_LRU, NULL));
+	for (i = 0; i < 4; i++)
+		accessPage(bm, h, i);
+
+	// a scan over 30 pages with a ring of 4, capped at 8 / 4 = 2 frames
+	CHECK(createAccessStrategy(&ring, 4));
+	for (i = 10; i < 40; i++)
+	{
+		CHECK(pinPageWithStrategy(bm, h, i, ring));
+		CHECK(unpinPage(bm, h));
+	}
+	ASSERT_EQUALS_POOL("[0 0],[1 0],[2 0],[3 0],[38 0],[39 0],[-1 0],[-1 0]", bm, "scan recycles two frames");
+	ASSERT_EQUALS_INT(34, getNumReadIO(bm), "every scanned page read once");
+
+	// a page of the ring pinned by someone else is not recycled
+	CHECK(pinPage(bm, h, 38));
+	CHECK(pinPageWithStrategy(bm, h, 11, ring));
+	CHECK(unpinPage(bm, h));
+	ASSERT_EQUALS_POOL("[0 0],[1 0],[2 0],[3 0],[38 1],[39 0],[11 0],[-1 0]", bm, "pinned ring page kept");
+	h->pageNum = 38;
+	CHECK(unpinPage(bm, h));
+	CHECK(freeAccessStrategy(ring));
+	CHECK(shutdownBufferPool(bm));
+
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testResizeBufferPool (void)
+{
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PoolOptions options = { true, 0, 0, 0, 0, 8 };
+	char expected[16];
+	int sizes[] = { 8, 2, 6, 1, 5 };
+	int s, r, i;
+	testName = "Testing resizeBufferPool";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 10);
+
+	// growing adds free frames, resident pages stay where they are
+	CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+	for (i = 0; i < 3; i++)
+		accessPage(bm, h, i);
+	CHECK(resizeBufferPool(bm, 5));
+	ASSERT_EQUALS_POOL("[0 0],[1 0],[2 0],[-1 0],[-1 0]", bm, "grown pool");
+	accessPage(bm, h, 3);
+	accessPage(bm, h, 4);
+	ASSERT_EQUALS_POOL("[0 0],[1 0],[2 0],[3 0],[4 0]", bm, "new frames used before any eviction");
+
+	// a pinned page in a dropped frame keeps the pool as it is
+	CHECK(pinPage(bm, h, 4));
+	ASSERT_EQUALS_INT(RC_PINNED_PAGES_IN_BUFFER, resizeBufferPool(bm, 3), "can not drop a pinned frame");
+	CHECK(unpinPage(bm, h));
+
+	// shrinking writes back dirty pages of the dropped frames
+	CHECK(pinPage(bm, h, 3));
+	sprintf(h->data, "%s-%i", "Changed", h->pageNum);
+	CHECK(markDirty(bm, h));
+	CHECK(unpinPage(bm, h));
+	CHECK(resizeBufferPool(bm, 3));
+	ASSERT_EQUALS_POOL("[0 0],[1 0],[2 0]", bm, "shrunk pool");
+	ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "dropped dirty page written");
+	CHECK(pinPage(bm, h, 3));
+	ASSERT_EQUALS_STRING("Changed-3", h->data, "dropped page read back");
+	CHECK(unpinPage(bm, h));
+	CHECK(shutdownBufferPool(bm));
+
+	// every policy keeps working across resizes, and pages keep their content
+	for (s = RS_FIFO; s <= RS_2Q; s++)
+	{
+		CHECK(initBufferPool(bm, "testbuffer.bin", 4, (ReplacementStrategy) s, NULL));
+		for (r = 0; r < 5; r++)
+		{
+			for (i = 0; i < 30; i++)
+			{
+				int pageNum = (i * 7 + r) % 10;
+				CHECK(pinPage(bm, h, pageNum));
+				sprintf(expected, "%s-%i", (pageNum == 3) ? "Changed" : "Page", pageNum);
+				ASSERT_EQUALS_STRING(expected, h->data, "page content after resize");
+				CHECK(unpinPage(bm, h));
+			}
+			CHECK(resizeBufferPool(bm, sizes[r]));
+			ASSERT_EQUALS_INT(sizes[r], bm->numPages, "number of frames");
+		}
+		CHECK(shutdownBufferPool(bm));
+	}
+
+	// a concurrent pool grows up to maxPages
+	CHECK(initBufferPoolEx(bm, "testbuffer.bin", 4, RS_CLOCK, NULL, &options));
+	CHECK(resizeBufferPool(bm, 8));
+	ASSERT_EQUALS_INT(RC_INVALID_PARAMS, resizeBufferPool(bm, 9), "can not grow past maxPages");
+	for (i = 0; i < 10; i++)
+		accessPage(bm, h, i);
+	CHECK(resizeBufferPool(bm, 2));
+	CHECK(resizeBufferPool(bm, 8));
+	for (i = 0; i < 10; i++)
+		accessPage(bm, h, i);
+	CHECK(shutdownBufferPool(bm));
+
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testSharedPool (void)
+{
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_BufferPool *view = MAKE_POOL();
+	char expected[16];
+	int i;
+	testName = "Testing page files sharing one pool";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	CHECK(createPageFile("testbuffer2.bin"));
+	createDummyPages(bm, 5);
+
+	// the same page numbers in two files are two pages
+	CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_LRU, NULL));
+	CHECK(attachBufferPool(view, bm, "testbuffer2.bin"));
+	ASSERT_EQUALS_INT(4, view->numPages, "view sees the pool's frames");
+	for (i = 0; i < 2; i++)
+	{
+		CHECK(pinPage(view, h, i));
+		sprintf(h->data, "%s-%i", "Other", h->pageNum);
+		CHECK(markDirty(view, h));
+		CHECK(unpinPage(view, h));
+		accessPage(bm, h, i);
+	}
+	ASSERT_EQUALS_POOL("[0x0],[0 0],[1x0],[1 0]", bm, "pages of both files in one pool");
+	CHECK(pinPage(bm, h, 0));
+	ASSERT_EQUALS_STRING("Page-0", h->data, "page of the pool's file");
+	CHECK(unpinPage(bm, h));
+
+	// both files compete for the frames: the view's pages are evicted and written back
+	for (i = 2; i < 5; i++)
+		accessPage(bm, h, i);
+	ASSERT_EQUALS_INT(2, getNumWriteIO(bm), "evicted pages of the view written");
+	for (i = 0; i < 2; i++)
+	{
+		CHECK(pinPage(view, h, i));
+		sprintf(expected, "%s-%i", "Other", i);
+		ASSERT_EQUALS_STRING(expected, h->data, "page of the attached file read back");
+		ASSERT_EQUALS_INT(i, h->pageNum, "page number within the attached file");
+		CHECK(unpinPage(view, h));
+	}
+
+	// a pinned page keeps the file attached, detaching evicts only the view's pages
+	CHECK(pinPage(view, h, 1));
+	ASSERT_EQUALS_INT(RC_PINNED_PAGES_IN_BUFFER, shutdownBufferPool(view), "can not detach with a pinned page");
+	CHECK(markDirty(view, h));
+	CHECK(unpinPage(view, h));
+	CHECK(shutdownBufferPool(view));
+	ASSERT_EQUALS_INT(3, getNumWriteIO(bm), "detach writes back the view's dirty pages");
+	ASSERT_TRUE(view->mgmtData == NULL, "view detached");
+	ASSERT_EQUALS_POOL("[-1 0],[-1 0],[3 0],[4 0]", bm, "only the view's pages evicted");
+	accessPage(bm, h, 0);
+	accessPage(bm, h, 1);
+	ASSERT_EQUALS_POOL("[1 0],[0 0],[3 0],[4 0]", bm, "freed frames reused");
+	ASSERT_EQUALS_INT(3, getNumWriteIO(bm), "no eviction into freed frames");
+
+	// the slot is reused, and a pool opened without a file only serves views
+	CHECK(attachBufferPool(view, bm, "testbuffer2.bin"));
+	ASSERT_EQUALS_INT(1, view->fileId, "file slot reused");
+	CHECK(shutdownBufferPool(view));
+	CHECK(shutdownBufferPool(bm));
+	CHECK(initBufferPool(bm, NULL, 3, RS_CLOCK, NULL));
+	ASSERT_EQUALS_INT(RC_FILE_HANDLE_NOT_INIT, pinPage(bm, h, 0), "no file to read from");
+	CHECK(attachBufferPool(view, bm, "testbuffer2.bin"));
+	CHECK(pinPage(view, h, 1));
+	ASSERT_EQUALS_STRING("Other-1", h->data, "page read through a view");
+	CHECK(unpinPage(view, h));
+	CHECK(shutdownBufferPool(view));
+	CHECK(shutdownBufferPool(bm));
+
+	CHECK(destroyPageFile("testbuffer.bin"));
+	CHECK(destroyPageFile("testbuffer2.bin"));
+
+	free(view);
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testBatchFlush (void)
+{
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	BM_BufferPool *bm = MAKE_POOL();
+	SM_FileHandle fh;
+	char page[PAGE_SIZE];
+	char expected[16];
+	const int changed[] = { 8, 1, 9, 0, 2, 4 };
+	bool *dirty;
+	int i;
+	testName = "Testing sorted batch write-back";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 10);
+
+	// dirty pages in no particular frame order, and a new page past a gap at the end of the file
+	CHECK(initBufferPool(bm, "testbuffer.bin", 12, RS_LRU, NULL));
+	for (i = 0; i < 6; i++)
+	{
+		CHECK(pinPage(bm, h, changed[i]));
+		sprintf(h->data, "%s-%i", "Changed", h->pageNum);
+		CHECK(markDirty(bm, h));
+		CHECK(unpinPage(bm, h));
+	}
+	accessPage(bm, h, 5);
+	CHECK(pinNewPage(bm, h, 11));
+	sprintf(h->data, "%s-%i", "New", h->pageNum);
+	CHECK(unpinPageLatched(bm, h));
+
+	CHECK(forceFlushPool(bm));
+	ASSERT_EQUALS_INT(7, getNumWriteIO(bm), "every dirty page counted once");
+	dirty = getDirtyFlags(bm);
+	for (i = 0; i < 12; i++)
+		ASSERT_TRUE(!dirty[i], "all frames clean");
+	free(dirty);
+
+	// the pool's own file handle reads the pages back after the vectored writes
+	CHECK(resizeBufferPool(bm, 1));
+	for (i = 0; i < 10; i++)
+	{
+		CHECK(pinPage(bm, h, i));
+		sprintf(expected, "%s-%i", (i == 0 || i == 1 || i == 2 || i == 4 || i == 8 || i == 9) ? "Changed" : "Page", i);
+		ASSERT_EQUALS_STRING(expected, h->data, "page content after batch write-back");
+		CHECK(unpinPage(bm, h));
+	}
+	ASSERT_EQUALS_INT(7, getNumWriteIO(bm), "clean pages are not written again");
+	CHECK(shutdownBufferPool(bm));
+
+	CHECK(openPageFile("testbuffer.bin", &fh));
+	ASSERT_EQUALS_INT(12, fh.totalNumPages, "file extended to the new page");
+	CHECK(readBlock(10, &fh, page));
+	ASSERT_EQUALS_INT(0, page[0], "page in the gap is zeroed");
+	CHECK(readBlock(11, &fh, page));
+	ASSERT_EQUALS_STRING("New-11", page, "new page written");
+	CHECK(closePageFile(&fh));
+
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testPoolStats (void)
+{
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PoolStats stats;
+	unsigned long long pins, misses;
+	int i, b;
+	testName = "Testing pool statistics";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 5);
+
+	// three misses, a hit, then two evictions of which the first has to write
+	CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+	for (i = 0; i < 3; i++)
+		accessPage(bm, h, i);
+	CHECK(pinPage(bm, h, 0));
+	CHECK(markDirty(bm, h));
+	CHECK(unpinPage(bm, h));
+	accessPage(bm, h, 3);
+	accessPage(bm, h, 4);
+
+	CHECK(getPoolStats(bm, &stats));
+	ASSERT_EQUALS_INT(1, (int) stats.hits, "hits");
+	ASSERT_EQUALS_INT(5, (int) stats.misses, "misses");
+	ASSERT_EQUALS_INT(5, (int) stats.readIO, "reads");
+	ASSERT_EQUALS_INT(1, (int) stats.writeIO, "writes");
+	ASSERT_EQUALS_INT(1, (int) stats.dirtyEvictions, "dirty evictions");
+	ASSERT_EQUALS_INT(1, (int) stats.cleanEvictions, "clean evictions");
+	ASSERT_EQUALS_INT(0, (int) stats.pinWaits, "no read in flight to wait for");
+	pins = misses = 0;
+	for (b = 0; b < BM_LATENCY_BUCKETS; b++)
+	{
+		pins += stats.pinLatency[b];
+		misses += stats.missLatency[b];
+	}
+	ASSERT_EQUALS_INT(6, (int) pins, "every pin timed");
+	ASSERT_EQUALS_INT(5, (int) misses, "every miss timed");
+	printPoolStats(bm);
+
+	// a reset starts the counters over, the old int counters read the same values
+	CHECK(resetPoolStats(bm));
+	accessPage(bm, h, 4);
+	CHECK(getPoolStats(bm, &stats));
+	ASSERT_EQUALS_INT(1, (int) stats.hits, "hits after reset");
+	ASSERT_EQUALS_INT(0, (int) stats.misses, "misses after reset");
+	ASSERT_EQUALS_INT(0, getNumReadIO(bm), "reads after reset");
+	CHECK(shutdownBufferPool(bm));
+
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testAccessTrace (void)
+{
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_TraceRecord records[8];
+	const int pages[] = { 0, 1, 0, 0, 1, 0 };
+	const int ops[] = { TRACE_PIN, TRACE_PIN, TRACE_UNPIN, TRACE_PIN, TRACE_UNPIN, TRACE_UNPIN };
+	FILE *fp;
+	int i, n;
+	testName = "Testing the access trace";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 3);
+
+	// only successful pins and unpins are recorded, and only while the trace runs
+	CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LRU, NULL));
+	accessPage(bm, h, 2);
+	CHECK(startBufferTrace(bm, "testtrace.bin"));
+	CHECK(pinPage(bm, h, 0));
+	CHECK(pinPage(bm, h, 1));
+	ASSERT_TRUE(pinPage(bm, h, 2) != RC_OK, "no frame for a third page");
+	h->pageNum = 0;
+	CHECK(unpinPage(bm, h));
+	CHECK(pinPage(bm, h, 0));
+	h->pageNum = 1;
+	CHECK(unpinPage(bm, h));
+	h->pageNum = 0;
+	CHECK(unpinPageLatched(bm, h));
+	CHECK(stopBufferTrace(bm));
+	accessPage(bm, h, 0);
+	CHECK(shutdownBufferPool(bm));
+
+	fp = fopen("testtrace.bin", "rb");
+	ASSERT_TRUE(fp != NULL, "trace file written");
+	n = (int) fread(records, sizeof(BM_TraceRecord), 8, fp);
+	fclose(fp);
+	ASSERT_EQUALS_INT(6, n, "one record per pin and unpin");
+	for (i = 0; i < n; i++)
+	{
+		ASSERT_EQUALS_INT(pages[i], records[i].page, "traced page");
+		ASSERT_EQUALS_INT(ops[i], records[i].op, "traced operation");
+		ASSERT_TRUE(i == 0 || records[i].timeNs >= records[i - 1].timeNs, "records in time order");
+	}
+	remove("testtrace.bin");
+
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testAdaptivePolicy (void)
+{
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_AdaptiveParams params = { 1, 100 }; // every page sampled, a decision every 100 pins
+	BM_PoolStats stats;
+	ReplacementStrategy live;
+	char expected[32];
+	int round, i;
+	testName = "Testing adaptive policy selection";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 600);
+	CHECK(initBufferPool(bm, "testbuffer.bin", 10, RS_ADAPTIVE, &params));
+	CHECK(getLiveStrategy(bm, &live));
+	ASSERT_EQUALS_INT(RS_LRU, live, "starts with LRU");
+
+	// day: 5 hot pages pinned twice between scans of 8 pages read once, only LFU keeps the hot pages
+	for (round = 0; round < 30; round++)
+	{
+		for (i = 0; i < 10; i++)
+			accessPage(bm, h, i % 5);
+		for (i = 0; i < 8; i++)
+			accessPage(bm, h, 100 + 8 * round + i);
+	}
+	CHECK(getLiveStrategy(bm, &live));
+	ASSERT_EQUALS_INT(RS_LFU, live, "scans with a hot set switch to LFU");
+
+	// night: a loop over 8 new pages, the old counts keep LFU from holding them
+	for (round = 0; round < 50; round++)
+		for (i = 0; i < 8; i++)
+			accessPage(bm, h, 500 + i);
+	CHECK(getLiveStrategy(bm, &live));
+	ASSERT_TRUE(live != RS_LFU, "a recency loop switches away from LFU");
+	CHECK(getPoolStats(bm, &stats));
+	ASSERT_TRUE(stats.policySwitches >= 2, "two switches");
+	printPoolStats(bm);
+
+	// the pages survived the hand-overs
+	for (i = 0; i < 8; i++)
+	{
+		CHECK(pinPage(bm, h, 500 + i));
+		sprintf(expected, "%s-%i", "Page", 500 + i);
+		ASSERT_EQUALS_STRING(expected, h->data, "page content after the switches");
+		CHECK(unpinPage(bm, h));
+	}
+	CHECK(shutdownBufferPool(bm));
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************ 
+// pages hashed to 4 sub-pools: concurrent pins, statistics over all partitions, resize,
+// and new pages written by different partitions through the one shared page file
+void
+testPartitionedPool (void)
+{
+	const int numThreads = 4;
+	BM_PoolOptions options = { true, 4, 0, 0, 0, 32, 4 };
+	PinWorkerArg args[4];
+	pthread_t threads[4];
+	BM_BufferPool view;
+	BM_PoolStats stats;
+	SM_FileHandle fh;
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	BM_BufferPool *bm = MAKE_POOL();
+	char expected[PAGE_SIZE];
+	int i, n;
+	bool ok = true;
+	PageNumber *contents;
+	int *fixCounts;
+	testName = "Testing a partitioned buffer pool";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 40);
+
+	ASSERT_ERROR(initBufferPoolEx(bm, "testbuffer.bin", 3, RS_LRU, NULL, &options), "fewer frames than partitions");
+	// 4 frames per partition, 4 threads never pin all of them
+	CHECK(initBufferPoolEx(bm, "testbuffer.bin", 16, RS_LRU, NULL, &options));
+	ASSERT_ERROR(attachBufferPool(&view, bm, "testbuffer.bin"), "no page files attached to partitions");
+	for (i = 0; i < numThreads; i++)
+	{
+		args[i].bm = bm;
+		args[i].seed = 525 + i;
+		args[i].numPages = 40;
+		args[i].numOps = 5000;
+		args[i].ok = true;
+		pthread_create(&threads[i], NULL, pinWorker, &args[i]);
+	}
+	for (i = 0; i < numThreads; i++)
+	{
+		pthread_join(threads[i], NULL);
+		ok = ok && args[i].ok;
+	}
+	ASSERT_TRUE(ok, "every pin returned the requested page");
+	CHECK(getPoolStats(bm, &stats));
+	ASSERT_EQUALS_INT(numThreads * 5000, (int) (stats.hits + stats.misses), "statistics add up over the partitions");
+
+	// the frames of all partitions, each page in at most one of them
+	contents = getFrameContents(bm);
+	fixCounts = getFixCounts(bm);
+	for (i = 0, n = 0; i < 16; i++)
+	{
+		ok = ok && (fixCounts[i] == 0) && contents[i] != NO_PAGE;
+		for (n = 0; n < i; n++)
+			ok = ok && (contents[n] != contents[i]);
+	}
+	free(contents);
+	free(fixCounts);
+	ASSERT_TRUE(ok, "16 frames, all filled with distinct unpinned pages");
+
+	CHECK(resizeBufferPool(bm, 32));
+	ASSERT_EQUALS_INT(32, bm->numPages, "grown to 32 frames");
+	for (i = 0; i < 40; i++)
+		accessPage(bm, h, i);
+	contents = getFrameContents(bm);
+	for (i = 0, n = 0; i < 32; i++)
+		n += (contents[i] != NO_PAGE);
+	free(contents);
+	ASSERT_EQUALS_INT(32, n, "every partition uses its new frames");
+
+	// new pages past the end of the file, flushed by whichever partition holds them
+	for (i = 40; i < 60; i++)
+	{
+		CHECK(pinNewPage(bm, h, i));
+		sprintf(h->data, "%s-%i", "Page", i);
+		CHECK(unpinPageLatched(bm, h));
+	}
+	// page 40's partition holds new pages up to 55 only, the file still grows past those of the others
+	h->pageNum = 40;
+	CHECK(forcePage(bm, h));
+	CHECK(openPageFile("testbuffer.bin", &fh));
+	ASSERT_EQUALS_INT(60, fh.totalNumPages, "file extended once for the new pages of every partition");
+	CHECK(closePageFile(&fh));
+	CHECK(shutdownBufferPool(bm));
+
+	CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+	for (i = 0; i < 60; i++)
+	{
+		CHECK(pinPage(bm, h, i));
+		sprintf(expected, "%s-%i", "Page", i);
+		ASSERT_EQUALS_STRING(expected, h->data, "page content written through the partitions");
+		CHECK(unpinPage(bm, h));
+	}
+	CHECK(shutdownBufferPool(bm));
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testGCLOCK (void)
+{
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	testName = "Testing GCLOCK page replacement";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 10);
+
+	CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_GCLOCK, NULL));
+	CHECK(pinPage(bm, h, 0));
+	CHECK(markDirty(bm, h));
+	CHECK(unpinPage(bm, h));
+	accessPage(bm, h, 1);
+	accessPage(bm, h, 2);
+	ASSERT_EQUALS_POOL("[0x0],[1 0],[2 0]", bm, "three pages loaded, page 0 is dirty");
+	accessPage(bm, h, 3);
+	ASSERT_EQUALS_POOL("[0x0],[3 0],[2 0]", bm, "the clean page goes first at equal counts");
+	accessPage(bm, h, 4);
+	ASSERT_EQUALS_POOL("[0x0],[3 0],[4 0]", bm, "the hand moves on to the next clean page");
+	ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "no write on the miss path yet");
+	accessPage(bm, h, 5);
+	ASSERT_EQUALS_POOL("[5 0],[3 0],[4 0]", bm, "a dirty page is only spared once");
+	ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "the dirty page was written back");
+
+	// three hits raise page 3 to the maximum count of 4, it outlives two rounds of the hand
+	accessPage(bm, h, 3);
+	accessPage(bm, h, 3);
+	accessPage(bm, h, 3);
+	accessPage(bm, h, 6);
+	ASSERT_EQUALS_POOL("[5 0],[3 0],[6 0]", bm, "page with the higher count stays");
+	accessPage(bm, h, 7);
+	ASSERT_EQUALS_POOL("[7 0],[3 0],[6 0]", bm, "page with the higher count stays");
+	CHECK(shutdownBufferPool(bm));
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testWarmRestart (void)
+{
+	BM_PoolOptions options = { false, 0, 0, 0, 0, 0, 0, true };
+	BM_PoolOptions partOptions = { true, 0, 0, 0, 0, 0, 2, true };
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	char warmFile[64];
+	FILE *fp;
+	testName = "Testing warm restart of the hot page set";
+
+	sprintf(warmFile, "%s%s", "testbuffer.bin", WARM_FILE_SUFFIX);
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 20);
+	ASSERT_TRUE((fp = fopen(warmFile, "rb")) == NULL, "no warm restart file without the option");
+
+	// LRU order after the accesses: 5, 6, 4
+	CHECK(initBufferPoolEx(bm, "testbuffer.bin", 3, RS_LRU, NULL, &options));
+	ASSERT_EQUALS_INT(0, getNumReadIO(bm), "nothing saved yet");
+	accessPage(bm, h, 4);
+	accessPage(bm, h, 5);
+	accessPage(bm, h, 6);
+	accessPage(bm, h, 4);
+	CHECK(shutdownBufferPool(bm));
+	ASSERT_TRUE((fp = fopen(warmFile, "rb")) != NULL, "shutdown saved the hot page set");
+	fclose(fp);
+
+	// the two hottest pages fit, they are loaded in page order and ranked like before
+	CHECK(initBufferPoolEx(bm, "testbuffer.bin", 2, RS_LRU, NULL, &options));
+	ASSERT_EQUALS_INT(2, getNumReadIO(bm), "two pages preloaded");
+	ASSERT_EQUALS_POOL("[4 0],[6 0]", bm, "the hottest pages are resident");
+	CHECK(pinPage(bm, h, 4));
+	ASSERT_EQUALS_STRING("Page-4", h->data, "preloaded page has the file's content");
+	CHECK(unpinPage(bm, h));
+	ASSERT_EQUALS_INT(2, getNumReadIO(bm), "pin of a preloaded page is a hit");
+	accessPage(bm, h, 5);
+	ASSERT_EQUALS_POOL("[4 0],[5 0]", bm, "the colder preloaded page is evicted first");
+	CHECK(shutdownBufferPool(bm));
+
+	// a partitioned pool hands each partition its own pages
+	CHECK(initBufferPoolEx(bm, "testbuffer.bin", 4, RS_CLOCK, NULL, &partOptions));
+	ASSERT_EQUALS_INT(2, getNumReadIO(bm), "two pages preloaded into the partitions");
+	CHECK(pinPage(bm, h, 5));
+	ASSERT_EQUALS_STRING("Page-5", h->data, "preloaded page has the file's content");
+	CHECK(unpinPage(bm, h));
+	accessPage(bm, h, 4);
+	ASSERT_EQUALS_INT(2, getNumReadIO(bm), "both pages are hits");
+	CHECK(shutdownBufferPool(bm));
+
+	CHECK(destroyPageFile("testbuffer.bin"));
+	remove(warmFile);
+
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+// a pin of one page from another thread, done is set once pinPage returned
+typedef struct PinWaitArg {
+	BM_BufferPool *bm;
+	PageNumber pageNum;
+	RC rc;
+	int done;
+} PinWaitArg;
+
+static void *
+pinWaitWorker (void *arg)
+{
+	PinWaitArg *w = (PinWaitArg *) arg;
+	BM_PageHandle h;
+
+	w->rc = pinPage(w->bm, &h, w->pageNum);
+	if (w->rc == RC_OK)
+		CHECK(unpinPage(w->bm, &h));
+	__atomic_store_n(&w->done, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+// test that a pin waits for an unpin instead of failing when every frame is pinned
+void
+testPinWait (void)
+{
+	BM_PoolOptions options = { true, 0, 0, 0, 0, 0, 0, false, PIN_WAIT_FOREVER };
+	BM_PoolOptions partOptions = { true, 0, 0, 0, 0, 0, 4, false, PIN_WAIT_FOREVER };
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_BufferPool *view = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	BM_PageHandle pinned[3];
+	BM_PoolStats stats;
+	PinWaitArg w = { bm, 3, RC_OK, 0 };
+	pthread_t thread;
+	PageNumber *contents;
+	int i;
+	bool found;
+	testName = "Testing pins that wait for a frame";
+
+	CHECK(createPageFile("testbuffer.bin"));
+	createDummyPages(bm, 10);
+
+	// waiting forever the pin blocks until a frame is unpinned
+	CHECK(initBufferPoolEx(bm, "testbuffer.bin", 3, RS_LRU, NULL, &options));
+	for (i = 0; i < 3; i++)
+		CHECK(pinPage(bm, &pinned[i], i));
+	pthread_create(&thread, NULL, pinWaitWorker, &w);
+	usleep(20000);
+	ASSERT_TRUE(__atomic_load_n(&w.done, __ATOMIC_ACQUIRE) == 0, "pin waits while every frame is pinned");
+	CHECK(unpinPage(bm, &pinned[1]));
+	pthread_join(thread, NULL);
+	ASSERT_EQUALS_INT(RC_OK, w.rc, "pin succeeds once a frame is unpinned");
+	ASSERT_EQUALS_POOL("[0 1],[3 0],[2 1]", bm, "page 3 replaced the unpinned page");
+	CHECK(getPoolStats(bm, &stats));
+	ASSERT_EQUALS_INT(1, (int) stats.frameWaits, "one pin waited for a frame");
+	CHECK(unpinPage(bm, &pinned[0]));
+	CHECK(unpinPage(bm, &pinned[2]));
+	CHECK(shutdownBufferPool(bm));
+
+	// with a timeout the pin fails once it expired
+	options.pinWaitMs = 50;
+	CHECK(initBufferPoolEx(bm, "testbuffer.bin", 3, RS_LRU, NULL, &options));
+	for (i = 0; i < 3; i++)
+		CHECK(pinPage(bm, &pinned[i], i));
+	ASSERT_ERROR(pinPage(bm, h, 3), "pin fails after the timeout");
+	CHECK(getPoolStats(bm, &stats));
+	ASSERT_EQUALS_INT(1, (int) stats.frameWaits, "the pin waited before it failed");
+	for (i = 0; i < 3; i++)
+		CHECK(unpinPage(bm, &pinned[i]));
+	CHECK(shutdownBufferPool(bm));
+
+	// PIN_NO_WAIT fails at once like a pool that is not concurrent
+	options.pinWaitMs = PIN_NO_WAIT;
+	CHECK(initBufferPoolEx(bm, "testbuffer.bin", 3, RS_LRU, NULL, &options));
+	for (i = 0; i < 3; i++)
+		CHECK(pinPage(bm, &pinned[i], i));
+	ASSERT_ERROR(pinPage(bm, h, 3), "pin fails at once");
+	CHECK(getPoolStats(bm, &stats));
+	ASSERT_EQUALS_INT(0, (int) stats.frameWaits, "no pin waited");
+	for (i = 0; i < 3; i++)
+		CHECK(unpinPage(bm, &pinned[i]));
+	CHECK(shutdownBufferPool(bm));
+
+	// the frames a detached view leaves go to a waiting pin
+	options.pinWaitMs = PIN_WAIT_FOREVER;
+	CHECK(createPageFile("testbuffer2.bin"));
+	CHECK(initBufferPoolEx(bm, "testbuffer.bin", 3, RS_LRU, NULL, &options));
+	CHECK(attachBufferPool(view, bm, "testbuffer2.bin"));
+	CHECK(pinPage(bm, &pinned[0], 0));
+	CHECK(pinPage(view, &pinned[1], 0));
+	CHECK(pinPage(view, &pinned[2], 1));
+	w.done = 0;
+	pthread_create(&thread, NULL, pinWaitWorker, &w);
+	usleep(20000);
+	ASSERT_TRUE(__atomic_load_n(&w.done, __ATOMIC_ACQUIRE) == 0, "pin waits while the view holds its frames");
+	CHECK(unpinPage(view, &pinned[1]));
+	CHECK(unpinPage(view, &pinned[2]));
+	CHECK(shutdownBufferPool(view));
+	pthread_join(thread, NULL);
+	ASSERT_EQUALS_INT(RC_OK, w.rc, "pin succeeds once the view is detached");
+	contents = getFrameContents(bm);
+	for (i = 0, found = false; i < 3; i++)
+		found = found || contents[i] == 3;
+	free(contents);
+	ASSERT_TRUE(found, "page 3 is resident");
+	CHECK(unpinPage(bm, &pinned[0]));
+	CHECK(shutdownBufferPool(bm));
+	CHECK(destroyPageFile("testbuffer2.bin"));
+
+	// one frame per partition: page 6 shares page 0's, which this thread holds, and the other partitions
+	// can not take it. Even PIN_WAIT_FOREVER only waits the default time there.
+	CHECK(initBufferPoolEx(bm, "testbuffer.bin", 4, RS_LRU, NULL, &partOptions));
+	CHECK(pinPage(bm, &pinned[0], 0));
+	ASSERT_ERROR(pinPage(bm, h, 6), "pin in a full partition fails after the capped wait");
+	CHECK(pinPage(bm, h, 1));
+	CHECK(unpinPage(bm, h));
+	CHECK(unpinPage(bm, &pinned[0]));
+	CHECK(shutdownBufferPool(bm));
+
+	CHECK(destroyPageFile("testbuffer.bin"));
+
+	free(bm);
+	free(view);
+	free(h);
+	TEST_DONE();
+}